@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace PRESIEN::BlindSight{
+
+    struct AllocationStats{
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+        uint64_t frees = 0;
+
+        AllocationStats operator-(const AllocationStats& other) const
+        {
+            return {allocations - other.allocations, bytes - other.bytes, frees - other.frees};
+        }
+
+        AllocationStats& operator+=(const AllocationStats& other)
+        {
+            allocations += other.allocations;
+            bytes += other.bytes;
+            frees += other.frees;
+            return *this;
+        }
+    };
+
+    // Counts global operator new / delete for the benchmark tools. The replacement operators
+    // are only compiled with PRESIEN_ALLOCATION_COUNTING (cmake -DBENCHMARK_ALLOCATIONS=ON),
+    // otherwise every counter stays 0 and Installed() is false.
+    // Every thread counts into its own slot, no locks on the allocation path. The call-site
+    // histogram (VBSALLOCSITES=1 or EnableSites) records a short backtrace per allocation and
+    // is much slower, use it to find where allocations come from, not for timings.
+    class AllocationCounter{
+        public:
+            struct Site{
+                std::string frames;             // "caller <- caller's caller <- ..."
+                uint64_t allocations = 0;
+                uint64_t bytes = 0;
+            };
+
+            static bool Installed();
+
+            // calling thread since it started
+            static AllocationStats Thread();
+            // every thread, including finished ones
+            static AllocationStats Process();
+
+            static void EnableSites(bool enable);
+            static bool SitesEnabled();
+            // biggest allocation counts first, frames inside libstdc++ skipped
+            static std::vector<Site> TopSites(size_t count);
+    };
+
+    // Allocations of the calling thread between construction and destruction, added up per
+    // name so a benchmark can print allocations per call of every instrumented scope.
+    class AllocationScope{
+        public:
+            struct Totals{
+                uint64_t calls = 0;
+                AllocationStats stats;
+            };
+
+            explicit AllocationScope(const char* name);
+            ~AllocationScope();
+            AllocationScope(const AllocationScope &) = delete;
+            AllocationScope &operator=(const AllocationScope &) = delete;
+
+            AllocationStats Stats() const { return AllocationCounter::Thread() - mStart; }
+
+            static std::map<std::string, Totals> AllTotals();
+            static void Reset();
+
+        private:
+            const char* mName;
+            AllocationStats mStart;
+    };
+};
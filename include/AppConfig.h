@@ -1,6 +1,7 @@
 #pragma once
 
 #include <LicenseSpring/Configuration.h>
+#include <string_view>
 
 struct AppConfig
 {
@@ -8,8 +9,13 @@ struct AppConfig
     AppConfig( const std::string& name, const std::string& version )
         : appName( name ), appVersion( version ) {}
 
-    // Create LicenseSpring configuration
-    LicenseSpring::Configuration::ptr_t createLicenseSpringConfig() const;
+    // Create LicenseSpring configuration, for another product of the same account if product code is given
+    LicenseSpring::Configuration::ptr_t createLicenseSpringConfig( const std::string& product = std::string() ) const;
+
+    // LicenseSpring credentials, decoded once into the locked secret vault
+    static std::string_view apiKey();
+    static std::string_view sharedKey();
+    static std::string_view productCode();
 
     std::string appName;
     std::string appVersion;
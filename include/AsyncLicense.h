@@ -0,0 +1,236 @@
+#pragma once
+
+#include "WorkerPool.h"
+
+#include <LicenseSpring/LicenseManager.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PRESIEN::BlindSight{
+
+    enum class AsyncStatus{
+        Ok,
+        Failed,         // the SDK call threw, see error
+        Cancelled,
+        TimedOut
+    };
+
+    template<typename T>
+    struct AsyncOutcome{
+        AsyncStatus status = AsyncStatus::Ok;
+        T value{};
+        std::exception_ptr error;
+
+        // The value, rethrows the SDK exception, std::runtime_error when cancelled or timed out
+        T Get() const
+        {
+            if (status == AsyncStatus::Failed && error)
+                std::rethrow_exception(error);
+            if (status == AsyncStatus::Cancelled)
+                throw std::runtime_error("license call cancelled");
+            if (status == AsyncStatus::TimedOut)
+                throw std::runtime_error("license call timed out");
+            return value;
+        }
+    };
+
+    namespace AsyncDetail{
+
+        using Executor = std::function<void(std::function<void()>)>;
+
+        class Pending{
+            public:
+                virtual ~Pending() = default;
+                virtual void Expire() = 0;
+        };
+
+        // One caller of a (possibly shared) call, completed exactly once by whichever comes
+        // first: the result, Cancel() or its deadline
+        template<typename T>
+        class Waiter : public Pending{
+            public:
+                Waiter(std::function<void(AsyncOutcome<T>)> handler, const Executor& executor)
+                    :mHandler(std::move(handler)), mExecutor(executor) {}
+
+                bool Complete(AsyncOutcome<T> outcome)
+                {
+                    if (mDone.exchange(true))
+                        return false;
+                    auto handler = std::move(mHandler);
+                    if (!handler)
+                        return true;
+                    if (mExecutor)
+                        mExecutor([handler = std::move(handler), outcome = std::move(outcome)]{ handler(outcome); });
+                    else
+                        handler(std::move(outcome));
+                    return true;
+                }
+
+                void Expire() override
+                {
+                    AsyncOutcome<T> outcome;
+                    outcome.status = AsyncStatus::TimedOut;
+                    Complete(std::move(outcome));
+                }
+
+                bool Done() const { return mDone.load(); }
+
+            private:
+                std::atomic<bool> mDone{false};
+                std::function<void(AsyncOutcome<T>)> mHandler;
+                Executor mExecutor;
+        };
+
+        template<typename T>
+        struct Flight{
+            std::vector<std::shared_ptr<Waiter<T>>> waiters;
+        };
+    };
+
+    // Caller side of a started call
+    template<typename T>
+    class AsyncCall{
+        public:
+            explicit AsyncCall(std::shared_ptr<AsyncDetail::Waiter<T>> waiter) : mWaiter(std::move(waiter)) {}
+
+            // The handler runs with Cancelled unless it already ran. The SDK call itself is
+            // only dropped when it has not started and nobody else waits for it.
+            void Cancel()
+            {
+                AsyncOutcome<T> outcome;
+                outcome.status = AsyncStatus::Cancelled;
+                mWaiter->Complete(std::move(outcome));
+            }
+
+            bool Done() const { return mWaiter->Done(); }
+
+        private:
+            std::shared_ptr<AsyncDetail::Waiter<T>> mWaiter;
+    };
+
+    // Non-blocking facade over the blocking LicenseSpring calls for event loop based services.
+    // Calls run on a dedicated I/O pool, the completion handler is handed to the executor,
+    // e.g. [&io](auto work){ asio::post(io, std::move(work)); }, so it runs on the loop thread
+    // (on the completing thread when no executor is given). Identical calls in flight are
+    // coalesced: one SDK request, every caller gets the outcome. A timeout or Cancel() completes
+    // one caller without waiting for the SDK, whose late result is then dropped for that caller.
+    class AsyncLicense{
+        public:
+            using Executor = AsyncDetail::Executor;
+            template<typename T>
+            using Handler = std::function<void(AsyncOutcome<T>)>;
+
+            explicit AsyncLicense(LicenseSpring::LicenseManager::ptr_t manager, size_t ioThreads = 4, Executor executor = Executor());
+            ~AsyncLicense();
+            AsyncLicense(const AsyncLicense &) = delete;
+            AsyncLicense &operator=(const AsyncLicense &) = delete;
+
+            // timeout 0 waits for the SDK however long it takes
+            AsyncCall<LicenseSpring::InstallationFile::ptr_t> Check(LicenseSpring::License::ptr_t license,
+                Handler<LicenseSpring::InstallationFile::ptr_t> handler,
+                std::chrono::milliseconds timeout = std::chrono::milliseconds(0),
+                const LicenseSpring::InstallFileFilter& filter = LicenseSpring::InstallFileFilter());
+
+            AsyncCall<bool> RegisterFloatingFeature(LicenseSpring::License::ptr_t license, const std::string& featureCode,
+                Handler<bool> handler, std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+            AsyncCall<LicenseSpring::License::ptr_t> ActivateLicense(const LicenseSpring::LicenseID& licenseId,
+                Handler<LicenseSpring::License::ptr_t> handler, std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+            // SDK requests issued, coalesced callers not counted
+            size_t Issued() const { return mIssued.load(); }
+
+        private:
+            using clock = std::chrono::steady_clock;
+
+            template<typename T, typename Call>
+            AsyncCall<T> _start(const std::string& key, Call call, Handler<T> handler, std::chrono::milliseconds timeout);
+            void _arm(const std::shared_ptr<AsyncDetail::Pending>& pending, clock::time_point deadline);
+            void _expire();
+
+            LicenseSpring::LicenseManager::ptr_t mManager;
+            Executor mExecutor;
+            std::atomic<size_t> mIssued{0};
+
+            std::mutex mMutex;
+            std::map<std::string, std::shared_ptr<void>> mInFlight;    // key -> Flight<T>
+
+            std::mutex mTimerMutex;
+            std::condition_variable mTimerCv;
+            std::multimap<clock::time_point, std::weak_ptr<AsyncDetail::Pending>> mDeadlines;
+            bool mStopTimer = false;
+            std::thread mTimer;
+
+            // last member: destroyed first, queued calls finish while the rest is alive
+            WorkerPool mPool;
+    };
+
+    template<typename T, typename Call>
+    AsyncCall<T> AsyncLicense::_start(const std::string& key, Call call, Handler<T> handler, std::chrono::milliseconds timeout){
+        auto waiter = std::make_shared<AsyncDetail::Waiter<T>>(std::move(handler), mExecutor);
+        bool first = false;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto& slot = mInFlight[key];
+            if (!slot)
+            {
+                slot = std::make_shared<AsyncDetail::Flight<T>>();
+                first = true;
+            }
+            std::static_pointer_cast<AsyncDetail::Flight<T>>(slot)->waiters.push_back(waiter);
+        }
+        if (timeout.count() > 0)
+            _arm(waiter, clock::now() + timeout);
+        if (!first)
+            return AsyncCall<T>(waiter);
+
+        mPool.Submit([this, key, call = std::move(call)]{
+            {
+                // everybody gave up while the call was queued, do not send it
+                std::lock_guard<std::mutex> lock(mMutex);
+                auto flight = std::static_pointer_cast<AsyncDetail::Flight<T>>(mInFlight[key]);
+                bool abandoned = true;
+                for (const auto& waiter : flight->waiters)
+                    abandoned = abandoned && waiter->Done();
+                if (abandoned)
+                {
+                    mInFlight.erase(key);
+                    return;
+                }
+            }
+
+            AsyncOutcome<T> outcome;
+            ++mIssued;
+            try
+            {
+                outcome.value = call();
+            }
+            catch (...)
+            {
+                outcome.status = AsyncStatus::Failed;
+                outcome.error = std::current_exception();
+            }
+
+            std::shared_ptr<AsyncDetail::Flight<T>> flight;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                flight = std::static_pointer_cast<AsyncDetail::Flight<T>>(mInFlight[key]);
+                mInFlight.erase(key);
+            }
+            for (const auto& waiter : flight->waiters)
+                waiter->Complete(outcome);
+        });
+        return AsyncCall<T>(waiter);
+    }
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <LicenseSpring/License.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace PRESIEN::BlindSight{
+
+    // Samples device metrics into a local buffer and sends only the variables that
+    // changed since the last acknowledged send, as a single addDeviceVariables batch.
+    class DeviceTelemetry{
+        public:
+            using ptr_t = std::shared_ptr<DeviceTelemetry>;
+            using VariableMap = std::map<std::string, std::string>;
+
+            // stateFile keeps the last acknowledged values across process runs, empty disables persistence
+            explicit DeviceTelemetry(const std::string& stateFile = std::string());
+            ~DeviceTelemetry();
+            DeviceTelemetry(const DeviceTelemetry &) = delete;
+            DeviceTelemetry &operator=(const DeviceTelemetry &) = delete;
+
+            // Values which do not change during process life time (hardware id, app version...)
+            void SetStaticVariable(const std::string& name, const std::string& value);
+
+            // Reads cores, memory and thermal zones into the pending buffer
+            void Sample();
+
+            // Host readings only, so one sample can feed several DeviceTelemetry instances
+            static VariableMap Collect();
+            void Update(VariableMap sample);
+
+            // Sends changed variables only, returns number of variables sent. Acknowledged values
+            // belong to one license key, a different key sends everything again.
+            size_t Flush(LicenseSpring::License::ptr_t license);
+
+            // A new activation starts with an empty device on the backend, even with the same key
+            void ResetAcknowledged();
+
+            // Background sample + flush, keeps only a weak reference to the license
+            void StartPeriodicFlush(LicenseSpring::License::ptr_t license, std::chrono::seconds interval);
+            void StopPeriodicFlush();
+
+            VariableMap PendingChanges() const;
+
+        private:
+            void _loadState();
+            void _saveState() const;
+
+            std::string mStateFile;
+            VariableMap mStatic;
+            VariableMap mSampled;
+            VariableMap mAcked;
+            std::string mAckedLicense;  // license key (user for user based licenses) of mAcked
+            mutable std::mutex mMutex;
+
+            std::thread mWorker;
+            std::mutex mWorkerMutex;
+            std::condition_variable mWorkerCv;
+            bool mStopWorker = false;
+    };
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace PRESIEN::BlindSight{
+
+    // Probes all configured hardware id sources in parallel, each one with its own deadline.
+    // The first source in registration order which answers in time wins. Only an id from the
+    // preferred (first) source is persisted, a fallback picked because that source was late
+    // stays valid for this start only. The cache is bound to the device: it is used only while
+    // the live /etc/machine-id and DMI values still match, so a copied volume probes again.
+    // Once an id from the preferred source was cached, the license is bound to that source:
+    // a late preferred source is then waited for (or the cached id used) instead of falling
+    // back, and no id at all is returned rather than a different one.
+    class HardwareFingerprint{
+        public:
+            using Probe = std::function<std::string()>;
+
+            struct Source{
+                std::string name;
+                Probe probe;
+                std::chrono::milliseconds timeout;
+            };
+
+            struct Result{
+                std::string source;     // empty if no source answered
+                std::string raw;        // value read from the source, e.g. tegra chip uid
+                std::string id;         // SHA1 of raw, used as LicenseSpring hardware id
+                bool fromCache = false;
+            };
+
+            explicit HardwareFingerprint(const std::string& cacheFile = std::string());
+
+            // Sources are tried in the order they were added (fallback order)
+            void AddSource(const std::string& name, Probe probe, std::chrono::milliseconds timeout);
+
+            // Tegra fuse, DMI, /etc/machine-id, NIC MACs and MAC1/TARGETHOSTNAME/CUSTOMER_SSN environment
+            static HardwareFingerprint CreateDefault(const std::string& cacheFile);
+
+            Result Resolve(bool useCache = true);
+
+            static std::string ReadTegraChipUid();
+            static std::string ReadMachineId();
+            static std::string ReadDmiId();
+            static std::string ReadNicMacs();
+            static std::string ReadEnvironmentId();
+            // SHA1 of machine-id and DMI, cheap file reads; empty when neither exists
+            static std::string ReadBinding();
+
+        private:
+            bool _readCache(Result& result) const;
+            std::string _cachedSource() const;
+            void _writeCache(const Result& result) const;
+
+            std::string mCacheFile;
+            std::vector<Source> mSources;
+    };
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <thread>
+
+namespace PRESIEN::BlindSight{
+
+    enum class SdkCall{
+        ACTIVATE_LICENSE = 0,
+        CHECK,
+        LOCAL_CHECK,
+        REGISTER_FLOATING_FEATURE,
+        SYNC_CONSUMPTION,
+        SEND_DEVICE_VARIABLES,
+        GET_PRODUCT_DETAILS,
+        GET_VERSION_LIST,
+        GET_INSTALLATION_FILE,
+        COUNT
+    };
+
+    // Call counters and latency histograms for LicenseSpring SDK calls.
+    // Every thread records into its own shard with relaxed atomics (no locks, no sharing),
+    // shards are only summed up when metrics are exported in Prometheus text format.
+    class LicenseMetrics{
+        public:
+            static constexpr size_t CALL_COUNT = static_cast<size_t>(SdkCall::COUNT);
+            // upper bounds in seconds, +Inf bucket is implicit
+            static constexpr std::array<double, 11> BUCKETS = {0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5};
+
+            static LicenseMetrics& GetInstance(){
+                static LicenseMetrics metrics;
+                return metrics;
+            }
+            LicenseMetrics(const LicenseMetrics &) = delete;
+            LicenseMetrics &operator=(const LicenseMetrics &) = delete;
+
+            void Record(SdkCall call, std::chrono::nanoseconds elapsed, bool failed);
+
+            std::string RenderPrometheus() const;
+
+            // node-exporter textfile collector, written to a temp file and renamed
+            bool WriteTextfile(const std::string& path) const;
+
+            // Serves RenderPrometheus() on http://127.0.0.1:<port>/metrics for long running modes
+            bool StartHttpEndpoint(uint16_t port);
+            void StopHttpEndpoint();
+
+        private:
+            LicenseMetrics() = default;
+            ~LicenseMetrics();
+
+            struct Shard;
+            Shard& _localShard();
+
+            std::atomic<Shard*> mShards{nullptr};
+            std::atomic<bool> mServing{false};
+            int mListenFd = -1;
+            std::thread mHttpThread;
+    };
+
+    // Times the enclosing scope, a call which leaves by exception is counted as failed
+    class ScopedSdkTimer{
+        public:
+            explicit ScopedSdkTimer(SdkCall call)
+                : mCall(call), mExceptions(std::uncaught_exceptions()), mStart(std::chrono::steady_clock::now()) {}
+            ~ScopedSdkTimer()
+            {
+                LicenseMetrics::GetInstance().Record(mCall, std::chrono::steady_clock::now() - mStart,
+                                                     std::uncaught_exceptions() > mExceptions);
+            }
+            ScopedSdkTimer(const ScopedSdkTimer &) = delete;
+            ScopedSdkTimer &operator=(const ScopedSdkTimer &) = delete;
+
+        private:
+            SdkCall mCall;
+            int mExceptions;
+            std::chrono::steady_clock::time_point mStart;
+    };
+};
+
+#define PRESIEN_METRIC_CONCAT_(a, b) a##b
+#define PRESIEN_METRIC_CONCAT(a, b) PRESIEN_METRIC_CONCAT_(a, b)
+#define PRESIEN_SDK_TIMER(call) PRESIEN::BlindSight::ScopedSdkTimer PRESIEN_METRIC_CONCAT(sdkTimer_, __LINE__)(PRESIEN::BlindSight::SdkCall::call)
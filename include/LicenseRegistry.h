@@ -0,0 +1,148 @@
+#pragma once
+
+#include "DeviceTelemetry.h"
+#include "WorkerPool.h"
+
+#include <LicenseSpring/LicenseManager.h>
+#include <LicenseSpring/LicenseStorage.h>
+#include <LicenseSpring/ProductDetails.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PRESIEN::BlindSight{
+
+    // One storage backend for every registry entry: license files live under one root as
+    // <root>/<product>/<hardware id>/License.key with both names percent-encoded (pathSafe),
+    // I/O is serialized and loaded data cached.
+    class RegistryStorage : public std::enable_shared_from_this<RegistryStorage>{
+        public:
+            using ptr_t = std::shared_ptr<RegistryStorage>;
+
+            explicit RegistryStorage(const std::wstring& root) : mRoot(root) {}
+
+            // LicenseStorage view for one entry, to be passed to LicenseManager::create
+            LicenseSpring::LicenseStorage::ptr_t ForKey(const std::string& productCode, const std::string& hardwareId);
+
+            void Save(const std::string& key, const std::string& data);
+            std::string Load(const std::string& key);
+            void Clear(const std::string& key);
+
+            // Drops the loaded data, Load reads the files again
+            void ReleaseMemory();
+
+        private:
+            std::wstring _path(const std::string& key) const;
+
+            std::wstring mRoot;
+            std::mutex mMutex;
+            std::map<std::string, std::string> mCache;
+    };
+
+    // Keeps N LicenseManagers in one process, keyed by product code and hardware id.
+    // Entries share one worker pool, one product details cache, one storage backend and
+    // one telemetry pipeline (host sampled once per interval, flushed per license).
+    class LicenseRegistry{
+        public:
+            struct Key{
+                std::string productCode;
+                std::string hardwareId;
+
+                bool operator<(const Key& other) const
+                {
+                    return productCode != other.productCode ? productCode < other.productCode : hardwareId < other.hardwareId;
+                }
+            };
+
+            struct Options{
+                std::wstring storageRoot = L"/PresienVBS/registry";
+                std::string appName = "C++ Sample";
+                std::string appVersion = "3.1";
+                size_t workers = 4;
+                std::chrono::seconds productDetailsTtl{3600};
+            };
+
+            struct ValidationResult{
+                Key key;
+                bool valid = false;
+                std::string error;
+            };
+
+            explicit LicenseRegistry(const Options& options);
+            ~LicenseRegistry();
+            LicenseRegistry(const LicenseRegistry &) = delete;
+            LicenseRegistry &operator=(const LicenseRegistry &) = delete;
+
+            // Creates the LicenseManager for key if it does not exist yet
+            LicenseSpring::LicenseManager::ptr_t Add(const Key& key);
+            LicenseSpring::LicenseManager::ptr_t Get(const Key& key) const;
+            // Held around calls that change the entry license in place (offline refresh, local check,
+            // telemetry flush)
+            std::shared_ptr<std::mutex> UpdateMutex(const Key& key) const;
+            bool Remove(const Key& key);
+            // Adds an entry for every <product>/<hardware id>/License.key under the storage root
+            size_t AddStored();
+            // <root>/<product>/<hardware id>, where the entry keeps its license file
+            std::string StoreDirectory(const Key& key) const;
+            std::vector<Key> Keys() const;
+
+            // localCheck of the entry license on the shared pool
+            std::future<ValidationResult> Validate(const Key& key);
+            std::vector<ValidationResult> ValidateAll();
+
+            // Cached per product code, one request per TTL whichever entry asks
+            LicenseSpring::ProductDetails GetProductDetails(const std::string& productCode);
+
+            void StartTelemetry(std::chrono::seconds interval);
+            void StopTelemetry();
+            size_t FlushTelemetry();
+
+            WorkerPool& Pool() { return mPool; }
+
+            // Storage cache and product details, registered with the MemoryGovernor while the
+            // registry exists
+            void ReleaseMemory();
+
+        private:
+            struct Entry{
+                LicenseSpring::Configuration::ptr_t config;
+                LicenseSpring::LicenseManager::ptr_t manager;
+                DeviceTelemetry::ptr_t telemetry;
+                std::mutex update;
+            };
+
+            struct CachedProduct{
+                LicenseSpring::ProductDetails details;
+                std::chrono::steady_clock::time_point fetched;
+            };
+
+            std::shared_ptr<Entry> _entry(const Key& key) const;
+            static ValidationResult _validate(const Key& key, const std::shared_ptr<Entry>& entry);
+
+            Options mOptions;
+            RegistryStorage::ptr_t mStorage;
+            WorkerPool mPool;
+
+            mutable std::shared_mutex mEntriesMutex;
+            std::map<Key, std::shared_ptr<Entry>> mEntries;
+
+            std::mutex mProductsMutex;
+            std::map<std::string, CachedProduct> mProducts;
+            std::map<std::string, std::shared_future<LicenseSpring::ProductDetails>> mProductRequests;
+
+            size_t mMemoryReleaser = 0;
+
+            std::thread mTelemetryWorker;
+            std::mutex mTelemetryMutex;
+            std::condition_variable mTelemetryCv;
+            bool mStopTelemetry = false;
+    };
+};
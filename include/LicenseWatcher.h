@@ -0,0 +1,95 @@
+#pragma once
+
+#include <LicenseSpring/LicenseManager.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PRESIEN::BlindSight{
+
+    // Reloads the current license when its file is rewritten by another process (updateOffline,
+    // deactivation, refresh ingest...) and tells subscribers which fields changed.
+    // The license directory is watched with inotify, a burst of events within the settle time
+    // causes one LicenseManager::reloadLicense. The previous and new state are flattened into
+    // field -> value maps ("valid", "validity_period", "feature.<code>.total_consumption"...,
+    // "metadata" a hash of the metadata, custom fields and user data) and only differing
+    // fields are delivered. Writes of this process are told with Acknowledge(), a file event
+    // whose content matches the acknowledged write causes no reload.
+    class LicenseWatcher{
+        public:
+            struct Change{
+                std::string field;
+                std::string before;             // empty when the field appeared
+                std::string after;              // empty when the field disappeared
+            };
+            using Callback = std::function<void(const std::vector<Change>&)>;
+            using State = std::map<std::string, std::string>;
+
+            explicit LicenseWatcher(LicenseSpring::LicenseManager::ptr_t manager,
+                                    std::chrono::milliseconds settle = std::chrono::milliseconds(100));
+            ~LicenseWatcher();
+            LicenseWatcher(const LicenseWatcher &) = delete;
+            LicenseWatcher &operator=(const LicenseWatcher &) = delete;
+
+            // prefix "" gets every change, "feature." only feature fields and so on
+            size_t Subscribe(const std::string& prefix, Callback callback);
+            void Unsubscribe(size_t id);
+
+            // Reloads of the watch thread hold mutex, a caller that holds it around its own use
+            // of the LicenseManager never sees the license replaced in between. Before Start().
+            void SetReloadMutex(std::mutex& mutex) { mReloadMutex = &mutex; }
+
+            // The watch thread only records that the file changed, the owner reloads on its own
+            // thread with ReloadIfChanged(). Before Start().
+            void SetDeferred(bool deferred) { mDeferred = deferred; }
+
+            bool Start();
+            void Stop();
+
+            // Reload and notify now, returns the changes found
+            std::vector<Change> Reload();
+            // Deferred mode: Reload when the file changed since and not by this process
+            std::vector<Change> ReloadIfChanged();
+
+            // After this process used the license: when the in-memory license differs from the
+            // known state the change is ours, it becomes the known state together with the file
+            // content and the file event of that save is ignored.
+            void Acknowledge();
+
+            static State Snapshot(LicenseSpring::License::ptr_t license);
+            static std::vector<Change> Diff(const State& before, const State& after);
+
+        private:
+            struct Subscriber{
+                std::string prefix;
+                Callback callback;
+            };
+
+            void _watch();
+            size_t _fileContent() const;
+
+            LicenseSpring::LicenseManager::ptr_t mManager;
+            std::chrono::milliseconds mSettle;
+            std::string mDirectory;
+            std::string mFileName;
+
+            std::mutex* mReloadMutex = nullptr;
+            bool mDeferred = false;
+            std::atomic<bool> mChanged{false};
+            std::mutex mMutex;                  // state and subscribers, held while notifying
+            State mState;
+            size_t mKnownContent = 0;           // hash of the license file mState belongs to
+            std::map<size_t, Subscriber> mSubscribers;
+            size_t mNextId = 1;
+
+            int mInotifyFd = -1;
+            int mStopFd = -1;
+            std::thread mWatcher;
+    };
+};
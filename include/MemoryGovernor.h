@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace PRESIEN::BlindSight{
+
+    // Memory footprint control for Jetson class devices where the GPU shares system memory.
+    // VBSLOWMEM=1 switches the allocator to a small footprint (one malloc arena, large
+    // transient buffers mmapped so they go back to the kernel when freed) and VBSRSSBUDGETMB
+    // sets an RSS budget. While started, a watcher thread waits for memory pressure (PSI
+    // trigger on the cgroup memory.pressure, else /proc/pressure/memory), for high/max/oom
+    // events of the cgroup memory.events and for RSS going over the budget; each one runs the
+    // registered releasers (caches drop what they can rebuild) and trims the heap. While RSS
+    // stays over the budget without growing, releases back off up to once a minute.
+    class MemoryGovernor{
+        public:
+            struct Usage{
+                size_t rss = 0;                 // bytes
+                size_t peakRss = 0;
+                size_t budget = 0;              // 0 unlimited
+                size_t pressureEvents = 0;
+                size_t releases = 0;
+            };
+            using Releaser = std::function<void()>;
+
+            static MemoryGovernor& GetInstance(){
+                static MemoryGovernor governor;
+                return governor;
+            }
+            MemoryGovernor(const MemoryGovernor &) = delete;
+            MemoryGovernor &operator=(const MemoryGovernor &) = delete;
+
+            // VBSLOWMEM and VBSRSSBUDGETMB, call first thing in main
+            void ConfigureFromEnvironment();
+
+            bool LowMemory() const { return mLowMemory; }
+            size_t Budget() const { return mBudget; }
+
+            size_t Register(const std::string& name, Releaser releaser);
+            // Waits for a release in progress, the releaser does not run after this returns
+            void Unregister(size_t id);
+
+            // Runs every releaser and returns freed heap to the kernel
+            void Release(const std::string& reason);
+
+            // Watcher thread for long running modes (batch, embedding services)
+            bool Start();
+            void Stop();
+
+            Usage Current() const;
+            void LogPeak() const;
+
+            static size_t ReadRss();
+            static size_t ReadPeakRss();
+
+        private:
+            MemoryGovernor() = default;
+            ~MemoryGovernor();
+
+            void _watch();
+            bool _eventsIncreased();
+
+            bool mLowMemory = false;
+            size_t mBudget = 0;
+
+            std::mutex mReleaseMutex;           // held while releasers run
+            std::mutex mMutex;
+            std::map<size_t, std::pair<std::string, Releaser>> mReleasers;
+            size_t mNextId = 1;
+            std::atomic<size_t> mPressureEvents{0};
+            std::atomic<size_t> mReleases{0};
+
+            int mPressureFd = -1;
+            int mEventsFd = -1;
+            int mStopFd = -1;
+            std::map<std::string, long long> mEventCounts;
+            std::thread mWatcher;
+    };
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <LicenseSpring/LicenseManager.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace PRESIEN::BlindSight{
+
+    class LicenseWatcher;
+    struct MetadataIndexBuilder;
+
+    // One node of an indexed document. Scalars keep their typed value, strings that spell a
+    // number or true/false (custom fields and user data are always strings) are converted
+    // once when the index is built. The accessors return the fallback when the value does
+    // not convert.
+    class MetadataValue{
+        public:
+            enum class Type{
+                NUL,
+                BOOLEAN,
+                INTEGER,
+                NUMBER,
+                STRING,
+                OBJECT,
+                ARRAY
+            };
+
+            Type GetType() const { return mType; }
+            bool IsNull() const { return mType == Type::NUL; }
+            // children of an object or array
+            size_t Size() const { return mSize; }
+
+            // strings as is, numbers and booleans as JSON text
+            std::string String(const std::string& fallback = std::string()) const;
+            int64_t Int(int64_t fallback = 0) const;
+            double Double(double fallback = 0) const;
+            bool Bool(bool fallback = false) const;
+
+        private:
+            friend struct MetadataIndexBuilder;
+
+            Type mType = Type::NUL;
+            bool mHasBool = false;
+            bool mHasInt = false;
+            bool mHasDouble = false;
+            bool mBool = false;
+            int64_t mInt = 0;
+            double mDouble = 0;
+            std::string mText;
+            size_t mSize = 0;
+    };
+
+    // Parse-once index of License::metadata(), ProductDetails::metadata(), customFields() and
+    // userData(). Every node is stored under its JSON pointer ("/cameras/0/model"), custom
+    // fields and user data under "/<name>", so lookups are one hash probe; a key without a
+    // leading '/' is a top level key. Snapshots are immutable and can be kept and read from
+    // any thread. Current() rebuilds only when the license object changed, when Invalidate()
+    // was called or, once attached, when a LicenseWatcher reports a reload.
+    class MetadataIndex{
+        public:
+            enum class Source{
+                LICENSE_METADATA,
+                PRODUCT_METADATA,
+                CUSTOM_FIELDS,
+                USER_DATA
+            };
+
+            class Snapshot{
+                public:
+                    // nullptr when the key is not in the document
+                    const MetadataValue* Find(Source source, const std::string& key) const;
+
+                    std::string String(Source source, const std::string& key, const std::string& fallback = std::string()) const;
+                    int64_t Int(Source source, const std::string& key, int64_t fallback = 0) const;
+                    double Double(Source source, const std::string& key, double fallback = 0) const;
+                    bool Bool(Source source, const std::string& key, bool fallback = false) const;
+
+                    // increases with every rebuild
+                    uint64_t Revision() const { return mRevision; }
+                    size_t Entries(Source source) const { return mDocuments[static_cast<size_t>(source)].size(); }
+
+                private:
+                    friend class MetadataIndex;
+
+                    std::unordered_map<std::string, MetadataValue> mDocuments[4];
+                    uint64_t mRevision = 0;
+                    std::weak_ptr<LicenseSpring::License> mLicense;
+            };
+            using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+            explicit MetadataIndex(LicenseSpring::LicenseManager::ptr_t manager);
+            ~MetadataIndex();
+            MetadataIndex(const MetadataIndex &) = delete;
+            MetadataIndex &operator=(const MetadataIndex &) = delete;
+
+            // Index of the current license, an empty one when no license is installed
+            SnapshotPtr Current();
+
+            // After in-process calls that can change the license in place (online check)
+            void Invalidate();
+
+            // Drops the current snapshot (holders keep theirs), the next Current() rebuilds
+            void ReleaseMemory();
+
+            // Rebuilds after every reload the watcher notifies, the watcher has to outlive the index
+            void Attach(LicenseWatcher& watcher);
+
+            static SnapshotPtr Build(LicenseSpring::License::ptr_t license, uint64_t revision = 0);
+            // "/a~1b" for key "a/b", JSON pointer escaping
+            static std::string PointerOf(const std::string& key);
+
+        private:
+            LicenseSpring::LicenseManager::ptr_t mManager;
+
+            std::mutex mMutex;
+            SnapshotPtr mSnapshot;
+            uint64_t mRevision = 0;
+            bool mStale = true;
+
+            LicenseWatcher* mWatcher = nullptr;
+            size_t mSubscription = 0;
+    };
+};
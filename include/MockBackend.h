@@ -0,0 +1,206 @@
+#pragma once
+
+#include <LicenseSpring/License.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace PRESIEN::BlindSight{
+
+    // Latency of one mocked call, sampled per call
+    struct LatencyDistribution{
+        enum class Kind{
+            NONE,
+            FIXED,      // a ms
+            UNIFORM,    // a..b ms
+            LOGNORMAL   // median a ms, sigma b
+        };
+        Kind kind = Kind::NONE;
+        double a = 0;
+        double b = 0;
+
+        // "fixed:20", "uniform:5:50", "lognormal:20:0.5", "none"
+        static LatencyDistribution Parse(const std::string& spec);
+        std::chrono::microseconds Sample(std::mt19937_64& rng) const;
+    };
+
+    struct MockBackendOptions{
+        LatencyDistribution networkLatency;     // check, activate, register, sync, send...
+        LatencyDistribution localLatency;       // localCheck
+        double networkTimeoutRate = 0;          // NetworkTimeoutException on network calls
+        double maxFloatingRate = 0;             // MaxFloatingReachedException on floating registration
+        double clockTamperedRate = 0;           // ClockTamperedException on localCheck
+        uint32_t seats = 0;                     // floating seats shared by all licenses, 0 = unlimited
+        bool floatingLicense = false;
+        std::vector<std::string> floatingFeatures;
+        std::vector<std::string> consumptionFeatures;
+        uint64_t seed = 1;                      // per thread rng is seed + thread index
+    };
+
+    // In-process stand-in for the LicenseSpring cloud, shared by every MockLicense it creates.
+    // Lets SampleBase/PresienLicense logic run deterministically under load without the network.
+    class MockBackend : public std::enable_shared_from_this<MockBackend>{
+        public:
+            using ptr_t = std::shared_ptr<MockBackend>;
+
+            static ptr_t Create(const MockBackendOptions& options)
+            {
+                return ptr_t(new MockBackend(options));
+            }
+
+            // Equivalent of LicenseManager::activateLicense, costs one network call
+            LicenseSpring::License::ptr_t ActivateLicense(const LicenseSpring::LicenseID& licenseId);
+
+            const MockBackendOptions& Options() const { return mOptions; }
+            uint32_t SeatsInUse() const { return mSeatsInUse.load(); }
+
+            // used by MockLicense
+            void NetworkCall();
+            void LocalCall();
+            void AcquireSeat();
+            void ReleaseSeat();
+
+        private:
+            explicit MockBackend(const MockBackendOptions& options) : mOptions(options) {}
+            std::mt19937_64& _rng();
+            bool _chance(double rate);
+
+            MockBackendOptions mOptions;
+            std::atomic<uint32_t> mSeatsInUse{0};
+            std::atomic<uint64_t> mThreadCounter{0};
+    };
+
+    // Interface-level mock of LicenseSpring::License backed by MockBackend
+    class MockLicense : public LicenseSpring::License{
+        public:
+            MockLicense(MockBackend::ptr_t backend, const LicenseSpring::LicenseID& licenseId);
+            ~MockLicense() override;
+
+            const LicenseSpring::LicenseID& id() const override { return mId; }
+            const std::string& key() const override { return mId.key(); }
+            const std::string& user() const override { return mId.user(); }
+            LicenseSpring::LicenseType type() const override;
+            LicenseSpring::Customer owner() const override { return LicenseSpring::Customer(); }
+            LicenseSpring::LicenseUser::ptr_t licenseUser() const override { return nullptr; }
+            LicenseSpring::ProductDetails productDetails() const override { return LicenseSpring::ProductDetails(); }
+            std::string status() const override { return "Active"; }
+            bool isActive() const override { return true; }
+            bool isEnabled() const override { return true; }
+            bool isValid() const override { return true; }
+            bool isTrial() const override { return false; }
+            bool isAirGapped() const override { return false; }
+            uint32_t policyId() const override { return 0; }
+            bool isOfflineActivated() const override { return false; }
+            bool isVMAllowed() const override { return true; }
+            bool isFloating() const override { return mBackend->Options().floatingLicense; }
+            bool isBorrowed() const override { return false; }
+            bool isSubscriptionGracePeriodStarted() const override { return false; }
+            bool isGracePeriodStarted() const override { return false; }
+            tm gracePeriodEndDateTime() const override { return tm(); }
+            tm gracePeriodEndDateTimeUTC() const override { return tm(); }
+            int gracePeriodHoursRemaining() const override { return 0; }
+            uint32_t trialPeriod() const override { return 0; }
+            uint32_t maxFloatingUsers() const override { return mBackend->Options().seats; }
+            uint32_t floatingInUseCount() const override { return mBackend->SeatsInUse(); }
+            uint32_t floatingTimeout() const override { return 30; }
+            const std::string& floatingClientId() const override { return mEmpty; }
+            tm validityPeriod() const override { return tm(); }
+            tm validityPeriodUtc() const override { return tm(); }
+            tm validityWithGracePeriod() const override { return tm(); }
+            tm validityWithGracePeriodUtc() const override { return tm(); }
+            uint32_t subscriptionGracePeriod() const override { return 0; }
+            uint32_t maxBorrowTime() const override { return 0; }
+            tm maintenancePeriod() const override { return tm(); }
+            tm maintenancePeriodUtc() const override { return tm(); }
+            tm lastCheckDate() const override { return tm(); }
+            tm lastCheckDateUtc() const override { return tm(); }
+            tm floatingEndDateTime() const override { return tm(); }
+            tm floatingEndDateTimeUtc() const override { return tm(); }
+            const std::string& startDate() const override { return mEmpty; }
+            const std::string& metadata() const override { return mMetadata; }
+            LicenseSpring::LicenseFeature feature(const std::string& featureCode) const override;
+            std::vector<LicenseSpring::LicenseFeature> features() const override { return mFeatures; }
+            std::vector<LicenseSpring::CustomField> customFields() const override { return {}; }
+            const std::vector<LicenseSpring::CustomField>& userData() const override { return mUserData; }
+            std::string userData(const std::string& key) const override;
+            void addUserData(const LicenseSpring::CustomField& data, bool saveLicense = true) override;
+            void removeUserData(const std::string& key = std::string(), bool saveLicense = true) override;
+            int32_t totalConsumption() const override { return mConsumption.load(); }
+            int32_t maxConsumption() const override { return 0; }
+            int32_t maxOverages() const override { return 0; }
+            bool isOveragesAllowed() const override { return false; }
+            bool isUnlimitedConsumptionAllowed() const override { return true; }
+            LicenseSpring::ConsumptionPeriod consumptionPeriod() const override { return LicenseSpring::ConsumptionPeriod(); }
+            bool isResetConsumptionEnabled() const override { return false; }
+            uint32_t timesActivated() const override { return 1; }
+            uint32_t maxActivations() const override { return 1; }
+            uint32_t transferCount() const override { return 0; }
+            int32_t transferLimit() const override { return 0; }
+            bool isDeviceTransferAllowed() const override { return false; }
+            bool isDeviceTransferLimited() const override { return false; }
+            bool isAutoReleaseSet() const override { return true; }
+            void setAutoRelease(bool) override {}
+            void updateConsumption(int32_t value = 1, bool saveLicense = true) override;
+            void updateFeatureConsumption(const std::string& featureCode, int32_t value = 1, bool saveLicense = true) override;
+            bool isExpired() const override { return false; }
+            bool isMaintenancePeriodExpired() const override { return false; }
+            int daysRemainingUtc() const override { return MaxDaysRemainingValue; }
+            int daysRemaining() const override { return MaxDaysRemainingValue; }
+            int maintenanceDaysRemaining() const override { return MaxDaysRemainingValue; }
+            int daysPassedSinceLastCheck() const override { return 0; }
+            void localCheck() override;
+            bool deactivate(bool removeLocalData = false) override;
+            bool changePassword(const std::string&, const std::string&) override { return false; }
+            LicenseSpring::InstallationFile::ptr_t check(const LicenseSpring::InstallFileFilter& filter = LicenseSpring::InstallFileFilter(),
+                                                         bool includeExpiredFeatures = false) override;
+            bool syncConsumption(int32_t requestOverage = -1) override;
+            bool syncFeatureConsumption(const std::string& featureCode = std::string()) override;
+            void addDeviceVariable(const std::string& name, const std::string& value, bool saveLicense = true) override;
+            void addDeviceVariable(const LicenseSpring::DeviceVariable& variable, bool saveLicense = true) override;
+            void addDeviceVariables(const std::vector<LicenseSpring::DeviceVariable>& variables) override;
+            bool sendDeviceVariables() override;
+            std::vector<LicenseSpring::DeviceVariable> getDeviceVariables(bool getFromBackend = false) override;
+            LicenseSpring::DeviceVariable deviceVariable(const std::string& name) const override;
+            const std::string& deviceVariableValue(const std::string& name) const override;
+            void setupLicenseWatchdog(LicenseSpring::LicenseWatchdogCallback, uint32_t = 0) override {}
+            void resumeLicenseWatchdog() override {}
+            void stopLicenseWatchdog() override {}
+            void setupFeatureWatchdog(LicenseSpring::LicenseWatchdogCallback, uint32_t = 0) override {}
+            void resumeFeatureWatchdog() override {}
+            void stopFeatureWatchdog() override {}
+            void registerFloatingLicense() override;
+            void releaseFloatingLicense(bool throwExceptions = false) override;
+            void borrow(uint32_t, uint32_t = 0) override;
+            void borrow(const std::string& = std::string()) override;
+            std::wstring deactivateOffline(const std::wstring& = std::wstring()) override { return std::wstring(); }
+            bool updateOffline(const std::wstring&, bool = false) override { return false; }
+            void unlinkFromDevice() override {}
+            std::string getAirGapDeactivationCode(const std::string&) override { return std::string(); }
+            void deactivateAirGap(const std::string&) override {}
+            bool isLicenseBelongsToThisDevice(DeviceIDAlgorithm) override { return true; }
+            bool checkLicenseBelongsToThisDevice() override { return true; }
+            void registerFloatingFeature(const std::string& featureCode, bool addToWatchdog = true) override;
+            void releaseFloatingFeature(const std::string& featureCode) override;
+
+        private:
+            MockBackend::ptr_t mBackend;
+            LicenseSpring::LicenseID mId;
+            std::vector<LicenseSpring::LicenseFeature> mFeatures;
+            std::vector<LicenseSpring::CustomField> mUserData;
+            std::atomic<int32_t> mConsumption{0};
+            const std::string mEmpty;
+            const std::string mMetadata = "{}";
+
+            mutable std::mutex mMutex;
+            bool mHoldsSeat = false;
+            std::set<std::string> mRegisteredFeatures;
+            std::vector<LicenseSpring::DeviceVariable> mVariables;
+    };
+};
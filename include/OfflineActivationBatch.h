@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace PRESIEN::BlindSight{
+
+    // Offline activation requests for a whole air-gapped site in one run. Every device of the
+    // manifest gets its own LicenseManager (configured with the device hardware id) from a
+    // LicenseRegistry, requests are written in parallel on the registry pool and bundled with
+    // an index into one tar archive for the offline activation portal.
+    class OfflineActivationBatch{
+        public:
+            struct Device{
+                std::string licenseKey;
+                std::string hardwareId;
+                std::string productCode;            // empty means the configured product
+            };
+
+            struct Result{
+                Device device;
+                std::string requestFile;            // relative to the output directory
+                uint64_t size = 0;
+                std::string sha1;
+                std::string error;
+            };
+
+            struct Options{
+                std::string appName = "C++ Sample";
+                std::string appVersion = "3.1";
+                size_t workers = 8;
+            };
+
+            // CSV, one "license_key,hardware_id[,product_code]" per line, '#' comments.
+            // Throws std::runtime_error naming the line on malformed input.
+            static std::vector<Device> ReadManifest(const std::string& path);
+
+            explicit OfflineActivationBatch(const Options& options) : mOptions(options) {}
+
+            // Writes <outputDir>/requests/<n>_<hardware id>.req and <outputDir>/index.json,
+            // a failed device is reported in its result and does not stop the others
+            std::vector<Result> CreateRequests(const std::vector<Device>& devices, const std::string& outputDir);
+
+            // ustar archive of index.json and every request file
+            static void WriteArchive(const std::vector<Result>& results, const std::string& outputDir, const std::string& archivePath);
+
+        private:
+            Options mOptions;
+    };
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace PRESIEN::BlindSight{
+
+    // Binary delta between two installation packages. Both files are cut into content defined
+    // chunks (gear rolling hash, 2/8/64 KiB min/avg/max), every chunk of the new package that
+    // also exists in the old one becomes a copy of old bytes, everything else is stored literally.
+    // Chunk boundaries follow content, so an insertion only disturbs the chunks around it.
+    //
+    // Format, native little endian:
+    //   "PDELTA1\0" | u64 old size | u64 new size | 32 hex chars new MD5
+    //   then ops: 'C' u64 old offset u32 length | 'L' u32 length bytes | 'E'
+    class PackageDelta{
+        public:
+            struct Stats{
+                uint64_t copied = 0;
+                uint64_t literal = 0;
+                uint64_t deltaSize = 0;
+                size_t chunks = 0;
+            };
+
+            // Packaging side, both packages are mapped in memory. Throws std::runtime_error.
+            static Stats Create(const std::string& oldPath, const std::string& newPath, const std::string& deltaPath);
+
+            // Device side, streams the delta over the old package into outPath with bounded memory
+            // (one 64 KiB buffer) and MD5s the output on the way. Returns the MD5 hex, throws
+            // std::runtime_error on a malformed delta, a wrong base or an output hash mismatch,
+            // in which case outPath is not created.
+            static std::string Apply(const std::string& oldPath, const std::string& deltaPath, const std::string& outPath);
+    };
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace PRESIEN::BlindSight{
+
+    // Downloads an installation package with parallel HTTP range requests (libcurl multi).
+    // Chunks are written with pwrite into a preallocated "<dest>.part" file and hashed with MD5
+    // in file order as soon as the prefix is contiguous, so the file is never read back.
+    // Progress (hashed prefix + MD5 state) is checkpointed to "<dest>.part.json" and an
+    // interrupted download resumes from there. Servers without range support get one stream.
+    class PackageDownloader{
+        public:
+            struct Options{
+                size_t connections = 4;
+                size_t chunkSize = 4 * 1024 * 1024;
+                int retries = 3;                            // per chunk
+                std::chrono::seconds timeout{60};           // per chunk request
+            };
+
+            struct Result{
+                bool ok = false;
+                bool resumed = false;
+                uint64_t size = 0;
+                uint64_t downloaded = 0;                    // bytes transferred by this run
+                std::string md5;
+                std::string error;
+            };
+
+            PackageDownloader() = default;
+            explicit PackageDownloader(const Options& options) : mOptions(options) {}
+
+            // expectedSize 0 asks the server, expectedMd5 empty skips verification
+            Result Download(const std::string& url, const std::string& destination,
+                            uint64_t expectedSize = 0, const std::string& expectedMd5 = std::string());
+
+        private:
+            Options mOptions;
+    };
+};
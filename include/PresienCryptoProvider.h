@@ -0,0 +1,48 @@
+#pragma once
+
+#include <LicenseSpring/CryptoProvider.h>
+
+#include <mutex>
+#include <string>
+
+typedef struct evp_cipher_st EVP_CIPHER;
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
+
+namespace PRESIEN::BlindSight{
+
+    // AES-256-GCM license encryption on OpenSSL EVP, which picks AES-NI / ARMv8 AES itself.
+    // The key is derived once and the cipher contexts keep their key schedule between calls,
+    // only the IV is reset per encrypt/decrypt.
+    // Blobs without the GCM prefix are handed to DefaultCryptoProvider, so license files
+    // written before switching providers are still readable and get re-encrypted on next save.
+    class PresienCryptoProvider final : public LicenseSpring::CryptoProvider{
+        public:
+            using ptr_t = std::shared_ptr<PresienCryptoProvider>;
+
+            static ptr_t create()
+            {
+                return std::make_shared<PresienCryptoProvider>();
+            }
+
+            PresienCryptoProvider();
+            ~PresienCryptoProvider() override;
+            PresienCryptoProvider(const PresienCryptoProvider &) = delete;
+            PresienCryptoProvider &operator=(const PresienCryptoProvider &) = delete;
+
+            std::string encrypt(const std::string& inputString) override;
+            std::string decrypt(const std::string& inputString) override;
+            void setSalt(const std::string& salt) override;
+            void setKey(const std::string& key) override;
+
+        private:
+            void _prepare();
+            void _releaseContexts();
+
+            std::mutex mMutex;
+            bool mReady = false;
+            EVP_CIPHER* mCipher = nullptr;
+            EVP_CIPHER_CTX* mEncryptCtx = nullptr;
+            EVP_CIPHER_CTX* mDecryptCtx = nullptr;
+            LicenseSpring::CryptoProvider::ptr_t mLegacy;
+    };
+};
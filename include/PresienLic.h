@@ -17,7 +17,15 @@
 #include <string>
 
 #include "AppConfig.h"
+#include "AsyncLicense.h"
+#include "HardwareFingerprint.h"
+#include "MemoryGovernor.h"
+#include "MetadataIndex.h"
+#include "PresienLog.h"
+#include "RefreshIngest.h"
 #include "Sha1.hpp"
+#include "StartupBudget.h"
+#include "ValidationToken.h"
 
 using namespace std;
 using namespace LicenseSpring;
@@ -31,7 +39,8 @@ namespace PRESIEN::BlindSight{
         INSTALL,
         UPDATE,
         DEACTIVATE,
-        PURGE
+        PURGE,
+        BATCH
     };
 
     class PresienLicenseConfig :public LicenseSpring::Configuration{
@@ -69,28 +78,22 @@ namespace PRESIEN::BlindSight{
 
         bool _updateToPresienHardwareID()
         {
-            
-            try
-            {
-                mTegraCpuUid = _readFile("/sys/module/tegra_fuse/parameters/tegra_chip_uid");
-            }
-            catch (...)
+            // Tegra fuse first, then DMI, machine-id, NIC MACs and environment as fallback.
+            // A tegra id is cached for this device, next starts only compare machine-id and DMI.
+            auto fingerprint = HardwareFingerprint::CreateDefault(PRESIEN_HWID_CACHE_FILE);
+            auto result = fingerprint.Resolve();
+            if (result.id.empty())
             {
-#ifdef __DEBUG
-                tegra_cpu_uid = readFile("/etc/machine-id");
-                cout << "\n Tegra stream not found, generalizing to x86 for debugging purpose only.";
-#else
-                return 0;
-#endif
+                PLOG_ERROR("Error - no hardware id source available.");
+                return false;
             }
-            SHA1 checksum;
-            // generate own hwid algorithm
-            checksum.update(mTegraCpuUid.c_str());
-            string hw_sha1 = checksum.final();
+            if (result.source == "tegra_fuse")
+                mTegraCpuUid = result.raw;
 
-            std::cout << "Input String: " << mTegraCpuUid << std::endl;
-            cout << "Presien HardWareID : " << hw_sha1 << std::endl;
-            _pConfig->setHardwareID(hw_sha1);
+            PLOG_INFO("HardwareID source: " << result.source << (result.fromCache ? " (cached)" : ""));
+            PLOG_INFO("Input String: " << result.raw);
+            PLOG_INFO("Presien HardWareID : " << result.id);
+            _pConfig->setHardwareID(result.id);
 
             return true;
         }
@@ -115,31 +118,33 @@ namespace PRESIEN::BlindSight{
                 if(v !=':')
                     MAC1+= v;
             }
-            std::cout << "MAC ID: " << MAC1 << std::endl;
+            PLOG_INFO("MAC ID: " << MAC1);
 
             string TARGETHOSTNAME = _getEnv("TARGETHOSTNAME");
             std::transform(TARGETHOSTNAME.begin(), TARGETHOSTNAME.end(), TARGETHOSTNAME.begin(),
                 [](unsigned char c){ return std::toupper(c); });
 
-            std::cout << "TARGETHOSTNAME: " << TARGETHOSTNAME << std::endl;
+            PLOG_INFO("TARGETHOSTNAME: " << TARGETHOSTNAME);
 
             string CUSTOMER_SSN = _getEnv("CUSTOMER_SSN");
             std::transform(CUSTOMER_SSN.begin(), CUSTOMER_SSN.end(), CUSTOMER_SSN.begin(),
                 [](unsigned char c){ return std::toupper(c); });
 
-            std::cout << "CUSTOMER_SSN: " << CUSTOMER_SSN << std::endl;           
+            PLOG_INFO("CUSTOMER_SSN: " << CUSTOMER_SSN);
             auto sfinal = MAC1+TARGETHOSTNAME+CUSTOMER_SSN;
             SHA1 checksum;
             checksum.update(sfinal.c_str());
             string hw_sha1 = checksum.final();
             
-            std::cout << "Input String: " << sfinal << std::endl;
-            cout << "ENV HardWareID : " <<  hw_sha1 << std::endl;          
+            PLOG_INFO("Input String: " << sfinal);
+            PLOG_INFO("ENV HardWareID : " <<  hw_sha1);
             _pConfig->setHardwareID(hw_sha1);
             return true;
         }
 
     public:
+        static constexpr const char* PRESIEN_HWID_CACHE_FILE = "/PresienVBS/presien_hwid.json";
+
         PresienLicenseConfig() = default;
         virtual ~PresienLicenseConfig() = default;
         PresienLicenseConfig(const PresienLicenseConfig &) = default;
@@ -153,11 +158,10 @@ namespace PRESIEN::BlindSight{
             _pConfig = appConfig.createLicenseSpringConfig();
 
 #ifdef __DEBUG
-            std::cout << "------------- Network info -------------" << std::endl;
-            std::cout << "Host name:   " << _pConfig->getNetworkInfo().hostName() << std::endl;
-            std::cout << "Local IP:    " << _pConfig->getNetworkInfo().ip() << std::endl;
-            std::cout << "MAC address: " << _pConfig->getNetworkInfo().mac() << std::endl;
-            std::cout << std::endl;
+            PLOG_INFO("------------- Network info -------------");
+            PLOG_INFO("Host name:   " << _pConfig->getNetworkInfo().hostName());
+            PLOG_INFO("Local IP:    " << _pConfig->getNetworkInfo().ip());
+            PLOG_INFO("MAC address: " << _pConfig->getNetworkInfo().mac());
 #endif
             _updateToPresienHardwareID();
         }
@@ -171,9 +175,18 @@ namespace PRESIEN::BlindSight{
 
     class PresienLicense : public SampleBase{
         
+        StartupBudget mBudget{StartupBudget::FromEnvironment()};
         PresienLicenseConfig mConfig;    
         REQUEST_CENTRE mRequest;
-        const wstring VIRTUAL_BLINDSIGHT_LIC_STORE_PATH =L"/PresienVBS";
+        ValidationToken mToken{VALIDATION_TOKEN_FILE, ValidationToken::TtlFromEnvironment()};
+        long mDefaultNetworkTimeout = 0;
+        // batch mode only, the ingest uses the registry pool and goes first
+        std::unique_ptr<LicenseRegistry> mRegistry;
+        std::unique_ptr<RefreshIngest> mRefreshIngest;
+        std::unique_ptr<AsyncLicense> mAsync;
+        std::unique_ptr<MetadataIndex> mMetadata;
+        // batch check answered as timed out whose SDK call still runs
+        std::shared_future<AsyncOutcome<LicenseSpring::InstallationFile::ptr_t>> mPendingCheck;
 
         private:
             PresienLicense();
@@ -183,15 +196,32 @@ namespace PRESIEN::BlindSight{
             bool ValidateLicenseOffline();
             bool UpdateLicense();
             bool DeactivateLicense();
-            void UpdateDataStorePath();
             bool ReadProductInfoFromServer();
             bool ReadTargetPlatformVMInfo();
+            bool IsOnlineWithinBudget();
+            bool RunBatch(std::istream& in, FILE* out);
+            std::string _runBatchCommand(const std::string& line);
+            void _applyNetworkTimeout();
+            void _beginLicenseChange();
+            static REQUEST_CENTRE _requestFromArgs(int argc, char**argv);
+            // no command: VBSINSTALL=1 installs, anything else validates
+            static REQUEST_CENTRE _requestFromEnvironment();
 
         public:
+            static constexpr const wchar_t* VIRTUAL_BLINDSIGHT_LIC_STORE_PATH = L"/PresienVBS";
+            static constexpr const char* VALIDATION_TOKEN_FILE = "/PresienVBS/presien_validation_token.json";
+
+            PresienLicense(const PresienLicense &) = delete;
+            PresienLicense &operator=(const PresienLicense &) = delete;
+
             static PresienLicense& GetInstance(){
                 static PresienLicense presienLicense;
                 return presienLicense;
             }
+            // Validation answered from a fresh validation token, before any SDK object exists
+            static bool ValidatedByToken(int argc, char**argv);
+            // License store on the mounted /PresienVBS volume
+            static void UpdateDataStorePath(LicenseManager::ptr_t manager);
             void ParseCmdArgs(int argc, char**argv);
             bool ProcessRequest();
             
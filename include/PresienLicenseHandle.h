@@ -0,0 +1,64 @@
+#pragma once
+
+#include "MetadataIndex.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace PRESIEN::BlindSight{
+
+    // In-process license API of libpresienlic for services which link the library instead of
+    // spawning presien-lic-app. One handle owns one LicenseManager on the /PresienVBS store,
+    // created by the first Initialize() and kept until Shutdown(). All calls are serialized,
+    // the handle can be shared between threads. SDK errors are logged and reported as false.
+    class PresienLicenseHandle{
+        public:
+            struct FeatureStatus{
+                std::string code;
+                bool found = false;
+                bool expired = false;
+                bool consumption = false;
+                int totalConsumption = 0;
+                int maxConsumption = 0;
+                bool floating = false;
+                int floatingUsers = 0;
+                int floatingInUse = 0;
+            };
+
+            PresienLicenseHandle();
+            ~PresienLicenseHandle();
+            PresienLicenseHandle(const PresienLicenseHandle &) = delete;
+            PresienLicenseHandle &operator=(const PresienLicenseHandle &) = delete;
+
+            // Hardware id and license manager, once; true when a license is installed
+            bool Initialize();
+            bool Initialized() const;
+
+            // Local check of the installed license, answered from the validation token while fresh
+            bool Validate();
+
+            FeatureStatus QueryFeature(const std::string& featureCode);
+
+            // Feature consumption, license consumption for an empty code. sync sends it right away.
+            bool Consume(const std::string& featureCode, int value, bool sync = true);
+
+            // Parsed license/product metadata, custom fields and user data. Keep the snapshot for
+            // repeated lookups; the first call starts a license file watcher so a newer snapshot
+            // follows license changes made by presien-lic-app. The watcher only flags a change,
+            // the license is reloaded at the start of the next handle call, under the handle
+            // lock like every other call. nullptr without a license.
+            MetadataIndex::SnapshotPtr Metadata();
+
+            // Drops the license manager, a later call initializes again
+            void Shutdown();
+
+        private:
+            class Impl;
+
+            bool _initialize();                 // mMutex held
+
+            mutable std::mutex mMutex;
+            std::unique_ptr<Impl> mImpl;
+    };
+};
@@ -0,0 +1,131 @@
+#ifndef PRESIEN_LICENSE_SNAPSHOT_H
+#define PRESIEN_LICENSE_SNAPSHOT_H
+
+#include <LicenseSpring/C-interface/LicenseHandler.h>
+
+#include <stdint.h>
+
+#if defined( _WIN32 )
+#define PRESIEN_C_API __declspec(dllexport)
+#else
+#define PRESIEN_C_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    // Whole license state in one call for Python (ctypes/cffi) and Rust consumers, instead of
+    // one LSLicenseHandler call and string copy per field.
+    //
+    //   PresienLicenseSnapshot snapshot = { sizeof(PresienLicenseSnapshot) };
+    //   if (PresienLicenseSnapshotQuery(handler, &snapshot, PRESIEN_SNAPSHOT_FEATURES) == 0) { ... }
+    //   PresienLicenseSnapshotRelease(&snapshot);
+    //
+    // The caller sets size, the library never writes past it: a consumer built against an
+    // older, shorter struct keeps working, fields appended by a newer version are not filled.
+    // Dates are UTC epoch seconds, 0 when the license does not have them.
+
+#define PRESIEN_LICENSE_SNAPSHOT_VERSION 1
+
+    enum PresienLicenseFlag
+    {
+        PRESIEN_LICENSE_VALID                 = 1u << 0,
+        PRESIEN_LICENSE_ACTIVE                = 1u << 1,
+        PRESIEN_LICENSE_ENABLED               = 1u << 2,
+        PRESIEN_LICENSE_EXPIRED               = 1u << 3,
+        PRESIEN_LICENSE_TRIAL                 = 1u << 4,
+        PRESIEN_LICENSE_FLOATING              = 1u << 5,
+        PRESIEN_LICENSE_BORROWED              = 1u << 6,
+        PRESIEN_LICENSE_OFFLINE_ACTIVATED     = 1u << 7,
+        PRESIEN_LICENSE_AIR_GAPPED            = 1u << 8,
+        PRESIEN_LICENSE_GRACE_PERIOD          = 1u << 9,
+        PRESIEN_LICENSE_MAINTENANCE_EXPIRED   = 1u << 10,
+        PRESIEN_LICENSE_OVERAGES_ALLOWED      = 1u << 11,
+        PRESIEN_LICENSE_UNLIMITED_CONSUMPTION = 1u << 12,
+        PRESIEN_LICENSE_VM_ALLOWED            = 1u << 13
+    };
+
+    enum PresienFeatureFlag
+    {
+        PRESIEN_FEATURE_EXPIRED               = 1u << 0,
+        PRESIEN_FEATURE_CONSUMPTION           = 1u << 1,
+        PRESIEN_FEATURE_FLOATING              = 1u << 2,
+        PRESIEN_FEATURE_OFFLINE_FLOATING      = 1u << 3,
+        PRESIEN_FEATURE_OVERAGES_ALLOWED      = 1u << 4,
+        PRESIEN_FEATURE_UNLIMITED_CONSUMPTION = 1u << 5
+    };
+
+    // Variable length parts, only allocated when asked for
+    enum PresienSnapshotPart
+    {
+        PRESIEN_SNAPSHOT_FEATURES = 1u << 0,    // features array with codes and names
+        PRESIEN_SNAPSHOT_STRINGS  = 1u << 1     // key, user and status
+    };
+
+    typedef struct PresienFeatureSnapshot
+    {
+        const char* code;
+        const char* name;
+        uint32_t flags;                 // PresienFeatureFlag
+        int32_t totalConsumption;
+        int32_t maxConsumption;
+        int32_t localConsumption;
+        int32_t maxOverages;
+        int32_t floatingUsers;
+        int32_t floatingInUse;
+        int32_t floatingTimeout;
+        int64_t expiryDate;
+        int64_t floatingEndDate;
+    } PresienFeatureSnapshot;
+
+    typedef struct PresienLicenseSnapshot
+    {
+        uint32_t size;                  // in: sizeof(PresienLicenseSnapshot) of the caller
+        uint32_t version;               // out: PRESIEN_LICENSE_SNAPSHOT_VERSION of the library
+        uint32_t flags;                 // PresienLicenseFlag
+        int32_t licenseType;            // LSLicenseType
+
+        int64_t validityPeriod;
+        int64_t validityWithGracePeriod;
+        int64_t maintenancePeriod;
+        int64_t lastCheckDate;
+        int64_t gracePeriodEndDate;
+        int64_t floatingEndDate;
+        int32_t daysRemaining;
+        int32_t maintenanceDaysRemaining;
+        int32_t daysSinceLastCheck;
+        int32_t gracePeriodHoursRemaining;
+
+        int32_t totalConsumption;
+        int32_t maxConsumption;
+        int32_t maxOverages;
+        uint32_t floatingTimeout;
+        uint32_t floatingInUse;
+        uint32_t maxFloatingUsers;
+
+        // Features sorted by code; bit i of the bitmap is set when feature i is not expired
+        // (first 64 features), the codes come with PRESIEN_SNAPSHOT_FEATURES
+        uint32_t featureCount;
+        uint64_t featureBitmap;
+
+        // Optional parts, valid until PresienLicenseSnapshotRelease
+        PresienFeatureSnapshot* features;
+        const char* key;
+        const char* user;
+        const char* status;
+        void* block;                    // owns every optional part, do not touch
+    } PresienLicenseSnapshot;
+
+    // 0 on success, -1 for a missing handler / too small size, otherwise the LSErrorCode
+    // the handler reported (e.g. no license installed). On error nothing needs releasing.
+    PRESIEN_C_API int PresienLicenseSnapshotQuery( struct LSLicenseHandler* handler, PresienLicenseSnapshot* snapshot, uint32_t parts );
+
+    // Frees the optional parts only and clears their pointers, the scalar fields stay valid
+    PRESIEN_C_API void PresienLicenseSnapshotRelease( PresienLicenseSnapshot* snapshot );
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
+
+#endif // PRESIEN_LICENSE_SNAPSHOT_H
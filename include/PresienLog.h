@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PRESIEN::BlindSight{
+
+    enum class LogLevel{
+        TRACE = 0,
+        DEBUG,
+        INFO,
+        WARN,
+        ERROR,
+        OFF
+    };
+
+    enum class LogFormat{
+        TEXT,
+        JSON
+    };
+
+    struct LogRecord{
+        LogLevel level = LogLevel::INFO;
+        std::chrono::system_clock::time_point time;
+        const char* file = "";
+        int line = 0;
+        std::string message;
+    };
+
+    // Asynchronous logger: producers push records into a lock-free bounded MPSC ring buffer,
+    // one background thread drains it into the sinks and flushes once per batch, not per line.
+    // If the ring is full records are dropped and counted, logging never blocks the caller.
+    //
+    // Configured from environment at first use:
+    //   VBSLOGLEVEL=trace|debug|info|warn|error|off  (default info)
+    //   VBSLOGFORMAT=text|json                        (default text)
+    //   VBSLOGFILE=/path/to/file                      (optional file sink)
+    //   VBSLOGSYSLOG=1                                (optional syslog sink)
+    //   VBSLOGSTDOUT=0                                (disable stdout sink)
+    class Logger{
+        public:
+            static Logger& GetInstance(){
+                static Logger logger;
+                return logger;
+            }
+            Logger(const Logger &) = delete;
+            Logger &operator=(const Logger &) = delete;
+
+            bool Enabled(LogLevel level) const
+            {
+                return level >= mLevel.load(std::memory_order_relaxed);
+            }
+            void SetLevel(LogLevel level) { mLevel.store(level, std::memory_order_relaxed); }
+            void SetFormat(LogFormat format) { mFormat.store(format, std::memory_order_relaxed); }
+            // Console sink, stdout by default, nullptr disables it (e.g. stderr when stdout carries data)
+            void SetConsole(FILE* stream) { mConsole.store(stream, std::memory_order_relaxed); }
+
+            void Submit(LogLevel level, const char* file, int line, std::string message);
+
+            // Blocks until everything submitted so far is written
+            void Flush();
+
+        private:
+            Logger();
+            ~Logger();
+
+            struct Cell{
+                std::atomic<size_t> seq;
+                LogRecord record;
+            };
+
+            bool _tryPush(LogRecord& record);
+            bool _tryPop(LogRecord& record);
+            void _drain();
+            void _write(const LogRecord& record, std::string& out) const;
+
+            static constexpr size_t CAPACITY = 4096; // power of two
+            std::unique_ptr<Cell[]> mRing;
+            alignas(64) std::atomic<size_t> mEnqueuePos{0};
+            alignas(64) size_t mDequeuePos = 0;
+            std::atomic<size_t> mDropped{0};
+
+            std::atomic<LogLevel> mLevel{LogLevel::INFO};
+            std::atomic<LogFormat> mFormat{LogFormat::TEXT};
+            std::atomic<FILE*> mConsole{stdout};
+            bool mSyslog = false;
+            FILE* mFile = nullptr;
+
+            std::thread mWriter;
+            std::mutex mWakeMutex;
+            std::condition_variable mWakeCv;
+            std::condition_variable mFlushedCv;
+            std::atomic<size_t> mWritten{0};
+            std::atomic<bool> mStop{false};
+    };
+};
+
+// Arguments are stream expressions and are not evaluated at all when the level is disabled,
+// e.g. PLOG_INFO("Hardware ID: " << id);
+#define PLOG_AT(lvl, expr)                                                                              \
+    do                                                                                                  \
+    {                                                                                                   \
+        auto& plogLogger_ = PRESIEN::BlindSight::Logger::GetInstance();                                 \
+        if (plogLogger_.Enabled(PRESIEN::BlindSight::LogLevel::lvl))                                    \
+        {                                                                                               \
+            std::ostringstream plogStream_;                                                             \
+            plogStream_ << expr;                                                                        \
+            plogLogger_.Submit(PRESIEN::BlindSight::LogLevel::lvl, __FILE__, __LINE__, plogStream_.str()); \
+        }                                                                                               \
+    } while (0)
+
+#define PLOG_TRACE(expr) PLOG_AT(TRACE, expr)
+#define PLOG_DEBUG(expr) PLOG_AT(DEBUG, expr)
+#define PLOG_INFO(expr) PLOG_AT(INFO, expr)
+#define PLOG_WARN(expr) PLOG_AT(WARN, expr)
+#define PLOG_ERROR(expr) PLOG_AT(ERROR, expr)
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "LicenseRegistry.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace PRESIEN::BlindSight{
+
+    // Applies offline license refresh files dropped into a directory (USB stick, sneakernet
+    // share) to the license stores of a LicenseRegistry.
+    // A file named "<hardware id>.lic" or "<product>@<hardware id>.lic" goes to that entry,
+    // any other name is tried against every entry until one accepts it. Files are applied on
+    // the registry pool; applied ones move to "<dir>/applied", failed ones to "<dir>/quarantine"
+    // next to a ".error" note. After every update "<store>/snapshot.json" is rewritten and
+    // the OnApplied callback runs, both under the entry's LicenseRegistry::UpdateMutex.
+    // New files are picked up with inotify (close-write / moved-to).
+    class RefreshIngest{
+        public:
+            struct Stats{
+                size_t applied = 0;
+                size_t quarantined = 0;
+            };
+
+            using AppliedCallback = std::function<void(const LicenseRegistry::Key&, LicenseSpring::License::ptr_t)>;
+
+            RefreshIngest(LicenseRegistry& registry, const std::string& dropDir);
+            ~RefreshIngest();
+            RefreshIngest(const RefreshIngest &) = delete;
+            RefreshIngest &operator=(const RefreshIngest &) = delete;
+
+            void SetOnApplied(AppliedCallback callback) { mOnApplied = std::move(callback); }
+
+            // Applies what is in the drop directory now and waits for it
+            Stats ProcessExisting();
+
+            // Watches the drop directory from a background thread until Stop()
+            bool Start();
+            void Stop();
+
+            Stats Totals() const { return {mApplied.load(), mQuarantined.load()}; }
+
+        private:
+            std::future<bool> _submit(const std::string& name);
+            bool _apply(const std::string& name);
+            bool _applyTo(const LicenseRegistry::Key& key, const std::string& path);
+            void _quarantine(const std::string& name, const std::string& reason);
+            void _publish(const LicenseRegistry::Key& key, LicenseSpring::License::ptr_t license);
+            void _watch();
+
+            LicenseRegistry& mRegistry;
+            std::string mDropDir;
+            AppliedCallback mOnApplied;
+
+            std::mutex mInFlightMutex;
+            std::set<std::string> mInFlight;    // inotify can report a file twice
+            std::condition_variable mInFlightCv;
+
+            std::atomic<size_t> mApplied{0};
+            std::atomic<size_t> mQuarantined{0};
+
+            int mInotifyFd = -1;
+            int mStopFd = -1;
+            std::thread mWatcher;
+    };
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <LicenseSpring/LicenseManager.h>
+#include "DeviceTelemetry.h"
+#include "UpdateMetadataCache.h"
 
 struct ConfigHelper;
 
@@ -27,10 +29,23 @@ public:
 
     void printUpdateInfo();
     static void printProductVersionInfo( LicenseSpring::InstallationFile::ptr_t installFile );
+    // Fetches the latest installation package into directory, resuming a previous partial download.
+    // With the installed package and its version given, walks "<package url>.delta" files version
+    // by version first and falls back to the full package when any step fails.
+    std::string downloadLatestUpdate( const std::string& directory, const std::string& installedPackage = std::string(),
+        const std::string& installedVersion = std::string() );
 
     static void PrintLicense( LicenseSpring::License::ptr_t license );
 
 protected:
+    // answered by m_updateCache when set, SDK round trips otherwise
+    std::vector<std::string> availableVersions( LicenseSpring::License::ptr_t license );
+    LicenseSpring::InstallationFile::ptr_t installationFile( LicenseSpring::License::ptr_t license, const std::string& version );
+    std::string applyDeltaUpdates( LicenseSpring::License::ptr_t license, const std::vector<std::string>& versionList,
+        const std::string& directory, const std::string& installedPackage, const std::string& installedVersion );
+
     LicenseSpring::LicenseManager::ptr_t m_licenseManager;
+    PRESIEN::BlindSight::DeviceTelemetry::ptr_t m_telemetry;
+    PRESIEN::BlindSight::UpdateMetadataCache::ptr_t m_updateCache;
 };
 
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PRESIEN::BlindSight{
+
+    // Synthetic seat-table benchmark: a floating-style seat allocator with leases, used to measure
+    // registration latency and seat churn at 1k+ clients. It does NOT speak the LicenseSpring
+    // floating server protocol and FloatingClient cannot connect to it; numbers from it bound
+    // the seat bookkeeping cost only, not a real server deployment. Served as HTTP/JSON:
+    //   POST /register?id=<client>
+    //   POST /borrow?id=<client>&until=<unix seconds>
+    //   POST /unregister?id=<client>
+    //   GET  /info
+    //
+    // Seats are claimed with atomics in an open addressing table, leases expire on a one second
+    // timer wheel and the table is snapshotted to a JSON state file. Released slots become
+    // tombstones; once they are a quarter of the table, the ticker rebuilds it under the
+    // exclusive table lock, every other operation only takes it shared.
+    class SeatTableBench{
+        public:
+            struct Options{
+                uint32_t seats = 100;
+                std::chrono::seconds lease{30};
+                std::string stateFile;                      // empty disables persistence
+                std::chrono::seconds persistInterval{5};
+            };
+
+            enum class Status{
+                OK,
+                NO_SEAT,
+                NOT_FOUND,
+                BAD_REQUEST
+            };
+
+            explicit SeatTableBench(const Options& options);
+            ~SeatTableBench();
+            SeatTableBench(const SeatTableBench &) = delete;
+            SeatTableBench &operator=(const SeatTableBench &) = delete;
+
+            // Claims a seat or renews the lease of an already registered client
+            Status Register(const std::string& id, int64_t* expires = nullptr);
+            Status Borrow(const std::string& id, int64_t until, int64_t* expires = nullptr);
+            Status Unregister(const std::string& id);
+
+            uint32_t InUse() const { return mInUse.load(std::memory_order_relaxed); }
+            uint32_t Capacity() const { return mOptions.seats; }
+            uint64_t Expired() const { return mExpired.load(std::memory_order_relaxed); }
+
+            // Advances the timer wheel to now and releases due leases, returns their count
+            size_t ExpireDue(int64_t now);
+            bool Save() const;
+
+            // One SO_REUSEPORT listener and epoll loop per worker, connections are kept alive
+            bool StartHttp(uint16_t port, unsigned workers);
+            void StopHttp();
+
+            // method and request target, e.g. "POST", "/register?id=a", returns HTTP status and JSON body
+            int HandleRequest(const std::string& method, const std::string& target, std::string& body);
+
+        private:
+            struct Slot{
+                std::atomic<uint64_t> key{0};       // EMPTY, TOMBSTONE, RESERVED or id hash
+                std::atomic<int64_t> expires{0};    // unix seconds
+                std::atomic<uint32_t> idLength{0};
+                std::atomic<uint64_t> id[8] = {};   // 64 bytes of client id, words so snapshots never race
+            };
+
+            struct Bucket{
+                std::mutex mutex;
+                std::vector<std::pair<size_t, uint64_t>> entries; // slot, key
+            };
+
+            static constexpr uint64_t EMPTY = 0;
+            static constexpr uint64_t TOMBSTONE = 1;
+            static constexpr uint64_t RESERVED = 2;
+            static constexpr size_t MAX_ID = sizeof(Slot::id);
+            static constexpr size_t WHEEL_SIZE = 4096; // seconds
+
+            static uint64_t _hash(const std::string& id);
+            Status _acquire(const std::string& id, int64_t expires, int64_t* result);
+            long _find(uint64_t key) const;
+            bool _release(size_t index, uint64_t key);
+            size_t _probeDistance(size_t index, uint64_t key) const { return (index - key) & mMask; }
+            void _rebuild();
+            void _schedule(size_t slot, uint64_t key, int64_t expires);
+            void _load();
+            void _serve(int listenFd);
+
+            Options mOptions;
+            size_t mMask = 0;
+            std::unique_ptr<Slot[]> mSlots;
+            alignas(64) std::atomic<uint32_t> mInUse{0};
+            std::atomic<uint64_t> mExpired{0};
+            std::atomic<bool> mDirty{false};
+            std::atomic<size_t> mTombstones{0};
+            mutable std::shared_mutex mTableMutex;  // exclusive only while _rebuild moves slots
+
+            std::unique_ptr<Bucket[]> mWheel;
+            std::mutex mTickMutex;
+            int64_t mLastTick = 0;
+
+            std::atomic<bool> mRunning{true};
+            std::thread mTicker;
+            std::atomic<bool> mServing{false};
+            std::vector<std::thread> mHttpWorkers;
+    };
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <LicenseSpring/EncryptString.h>
+
+#include <cstddef>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace PRESIEN::BlindSight{
+
+    // Keeps decoded secrets in one mlock'd page (not swapped, excluded from core dumps).
+    // Every secret is decoded exactly once on first use, the page is wiped on exit.
+    class SecretVault{
+        public:
+            static SecretVault& GetInstance(){
+                static SecretVault vault;
+                return vault;
+            }
+            SecretVault(const SecretVault &) = delete;
+            SecretVault &operator=(const SecretVault &) = delete;
+
+            // owner identifies the secret (address of its static encoded storage)
+            std::string_view Fetch(const void* owner, const char* encoded, size_t size, unsigned long long key);
+
+            // Explicit wipe, also done from the destructor at exit
+            void Wipe();
+
+        private:
+            SecretVault();
+            ~SecretVault();
+
+            std::mutex mMutex;
+            char* mPage = nullptr;
+            size_t mPageSize = 0;
+            size_t mUsed = 0;
+            std::unordered_map<const void*, std::string_view> mSecrets;
+    };
+
+    // Secret encoded at compile time with the same XOR scheme as EncryptStr,
+    // but decoded once into the vault instead of at every call site.
+    template <size_t N>
+    class Secret{
+        public:
+            // XORKEY is seeded by __TIME__ per translation unit, so it travels with the secret
+            constexpr Secret(const char (&plain)[N]) : mKey(LicenseSpring::XORKEY), mEncoded{}
+            {
+                for (size_t i = 0; i < N - 1; ++i)
+                    mEncoded[i] = LicenseSpring::encrypt_character<char>(plain[i], static_cast<int>(i));
+            }
+
+            // Must be called on an object with static storage duration, see PRESIEN_SECRET
+            std::string_view Reveal() const
+            {
+                return SecretVault::GetInstance().Fetch(this, mEncoded, N - 1, mKey);
+            }
+
+        private:
+            unsigned long long mKey;
+            char mEncoded[N];
+    };
+};
+
+// e.g. PRESIEN_SECRET(kApiKey, "..."); kApiKey.Reveal();
+#define PRESIEN_SECRET(name, value) static constexpr PRESIEN::BlindSight::Secret<sizeof(value)> name(value)
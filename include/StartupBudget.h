@@ -0,0 +1,130 @@
+#pragma once
+
+#include "PresienLog.h"
+
+#include <LicenseSpring/Exceptions.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PRESIEN::BlindSight{
+
+    // Startup latency budget shared by every phase of PresienLicense startup.
+    // Network phases run against the deadline: the SDK network timeout is derived from the
+    // remaining budget and a phase still running at the deadline continues in the background,
+    // while cached results answer the request. Background work is joined on destruction.
+    // Only read-only phases (connectivity, product details) run within the budget, calls that
+    // change the license state run in the foreground after JoinBackground().
+    //
+    // VBSSTARTUPBUDGETMS=300 sets the budget, unset or 0 keeps the unbounded SDK behaviour.
+    class StartupBudget{
+        public:
+            using clock = std::chrono::steady_clock;
+
+            explicit StartupBudget(std::chrono::milliseconds budget);
+            ~StartupBudget();
+            StartupBudget(const StartupBudget &) = delete;
+            StartupBudget &operator=(const StartupBudget &) = delete;
+
+            static std::chrono::milliseconds FromEnvironment();
+
+            bool Unlimited() const { return mBudget.count() <= 0; }
+            std::chrono::milliseconds Remaining() const;
+
+            // SDK timeout has second granularity and 0 means no timeout, so this is at least 1 s.
+            // Returns fallback when the budget is unlimited.
+            long NetworkTimeoutSeconds(long fallback) const;
+
+            // Runs work and waits at most for the remaining budget.
+            // Returns true when it finished in time (its exception, if any, is rethrown),
+            // false when it keeps running in the background.
+            template<typename Work>
+            bool RunWithin(const std::string& phase, Work work);
+
+            // Blocks until all phases moved to the background have finished
+            void JoinBackground();
+            bool HasBackground();
+
+        private:
+            struct Task{
+                std::mutex mutex;
+                std::condition_variable cv;
+                bool done = false;
+                std::exception_ptr error;
+            };
+
+            const std::chrono::milliseconds mBudget;
+            const clock::time_point mDeadline;
+            std::mutex mBackgroundMutex;
+            std::vector<std::thread> mBackground;
+    };
+
+    template<typename Work>
+    bool StartupBudget::RunWithin(const std::string& phase, Work work){
+        if (Unlimited())
+        {
+            work();
+            return true;
+        }
+
+        auto task = std::make_shared<Task>();
+        std::thread worker([task, phase, work]() mutable {
+            std::exception_ptr error;
+            try
+            {
+                work();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(task->mutex);
+            task->done = true;
+            task->error = error;
+            task->cv.notify_all();
+        });
+
+        std::unique_lock<std::mutex> lock(task->mutex);
+        if (task->cv.wait_until(lock, mDeadline, [&task]{ return task->done; }))
+        {
+            lock.unlock();
+            worker.join();
+            if (task->error)
+                std::rethrow_exception(task->error);
+            return true;
+        }
+        lock.unlock();
+
+        PLOG_WARN("Startup budget of " << mBudget.count() << " ms exhausted, " << phase << " continues in background.");
+        std::lock_guard<std::mutex> backgroundLock(mBackgroundMutex);
+        mBackground.emplace_back([task, phase]{
+            std::unique_lock<std::mutex> taskLock(task->mutex);
+            task->cv.wait(taskLock, [&task]{ return task->done; });
+            if (!task->error)
+            {
+                PLOG_INFO("Background " << phase << " finished.");
+                return;
+            }
+            try
+            {
+                std::rethrow_exception(task->error);
+            }
+            catch (const std::exception& ex)
+            {
+                PLOG_ERROR("Background " << phase << " failed: " << ex.what());
+            }
+            catch (...)
+            {
+                PLOG_ERROR("Background " << phase << " failed.");
+            }
+        });
+        mBackground.emplace_back(std::move(worker));
+        return false;
+    }
+};
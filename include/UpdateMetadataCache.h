@@ -0,0 +1,84 @@
+#pragma once
+
+#include <LicenseSpring/InstallationFile.h>
+#include <LicenseSpring/LicenseID.h>
+#include <LicenseSpring/LicenseManager.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PRESIEN::BlindSight{
+
+    // Local copy of getVersionList / getInstallationFile answers, keyed by license id and
+    // InstallFileFilter (channel + environment), persisted to a JSON file.
+    // Fresh entries are answered without network. A stale entry costs one getVersionList
+    // round trip; installation files are fetched again only for versions which were not in
+    // the previous list (a published version does not change). If the refresh fails the
+    // stale answer is returned. The background refresher keeps used entries from going stale.
+    class UpdateMetadataCache{
+        public:
+            using ptr_t = std::shared_ptr<UpdateMetadataCache>;
+
+            // stateFile empty disables persistence, ttl from VBSUPDATETTL (seconds) if set
+            UpdateMetadataCache(LicenseSpring::LicenseManager::ptr_t manager, const std::string& stateFile,
+                                std::chrono::seconds ttl = std::chrono::hours(6));
+            ~UpdateMetadataCache();
+            UpdateMetadataCache(const UpdateMetadataCache &) = delete;
+            UpdateMetadataCache &operator=(const UpdateMetadataCache &) = delete;
+
+            static std::chrono::seconds TtlFromEnvironment(std::chrono::seconds fallback);
+
+            std::vector<std::string> VersionList(const LicenseSpring::LicenseID& licenseId,
+                                                 const LicenseSpring::InstallFileFilter& filter = LicenseSpring::InstallFileFilter());
+
+            // version empty means latest
+            LicenseSpring::InstallationFile::ptr_t InstallationFile(const LicenseSpring::LicenseID& licenseId,
+                                                                    const std::string& version = std::string(),
+                                                                    const LicenseSpring::InstallFileFilter& filter = LicenseSpring::InstallFileFilter());
+
+            // Drops every entry, next request goes to the network
+            void Invalidate();
+
+            // Memory pressure: keeps only the latest installation file of every entry in memory,
+            // older ones are fetched again on demand
+            void ReleaseMemory();
+
+            void StartBackgroundRefresh(std::chrono::seconds interval);
+            void StopBackgroundRefresh();
+
+        private:
+            struct Entry{
+                LicenseSpring::LicenseID licenseId;
+                LicenseSpring::InstallFileFilter filter;
+                std::vector<std::string> versions;
+                std::map<std::string, LicenseSpring::InstallationFile::ptr_t> files;
+                std::chrono::system_clock::time_point fetched;
+            };
+
+            static std::string _key(const LicenseSpring::LicenseID& licenseId, const LicenseSpring::InstallFileFilter& filter);
+            bool _fresh(const Entry& entry) const;
+            // network refresh of one entry, returns false and keeps the old data on failure
+            bool _refresh(const std::string& key, const LicenseSpring::LicenseID& licenseId,
+                          const LicenseSpring::InstallFileFilter& filter, bool force = false);
+            void _loadState();
+            void _saveState() const;
+
+            LicenseSpring::LicenseManager::ptr_t mManager;
+            std::string mStateFile;
+            std::chrono::seconds mTtl;
+            std::map<std::string, Entry> mEntries;
+            mutable std::mutex mMutex;
+            std::mutex mRefreshMutex;       // one network refresh or state write at a time
+
+            std::thread mWorker;
+            std::mutex mWorkerMutex;
+            std::condition_variable mWorkerCv;
+            bool mStopWorker = false;
+    };
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace PRESIEN::BlindSight{
+
+    // Short-lived proof that the license passed localCheck on this device, so the next
+    // invocation within the ttl can answer without creating a LicenseManager at all.
+    // The token binds the hardware id, the license file path and the SHA-256 of its content,
+    // and carries an HMAC-SHA256 keyed by an embedded secret mixed with the hardware id and the
+    // live device binding (HardwareFingerprint::ReadBinding, machine-id and DMI, read on every
+    // Issue and Verify): copying it to another device, even with the whole license volume,
+    // editing it or replacing the license file invalidates it. No binding, no token.
+    class ValidationToken{
+        public:
+            ValidationToken(const std::string& path, std::chrono::seconds ttl);
+
+            // VBSTOKENTTL seconds, 0 disables the token
+            static std::chrono::seconds TtlFromEnvironment(std::chrono::seconds fallback = std::chrono::seconds(300));
+
+            bool Enabled() const { return mTtl.count() > 0; }
+
+            // Call after a successful localCheck
+            bool Issue(const std::string& hardwareId, const std::string& licenseFile) const;
+
+            // Signature, device, license content and expiry all match
+            bool Verify(const std::string& hardwareId) const;
+
+            // After anything that changes what localCheck would say (install, deactivation)
+            void Revoke() const;
+
+        private:
+            static std::string _payload(long long expiry, const std::string& hardwareId,
+                                        const std::string& licenseFile, const std::string& licenseHash);
+            static std::string _mac(const std::string& hardwareId, const std::string& binding, const std::string& payload);
+            static std::string _hashFile(const std::string& path);
+
+            std::string mPath;
+            std::chrono::seconds mTtl;
+    };
+};
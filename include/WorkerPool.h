@@ -0,0 +1,88 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace PRESIEN::BlindSight{
+
+    // Fixed size thread pool with a FIFO task queue, shared by components which issue
+    // blocking LicenseSpring SDK calls so the process does not grow a thread per request.
+    class WorkerPool{
+        public:
+            explicit WorkerPool(size_t threads = std::thread::hardware_concurrency())
+            {
+                if (threads == 0)
+                    threads = 1;
+                for (size_t i = 0; i < threads; ++i)
+                    mThreads.emplace_back([this]{ _run(); });
+            }
+
+            ~WorkerPool()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mStop = true;
+                }
+                mCv.notify_all();
+                for (auto& thread : mThreads)
+                    thread.join();
+            }
+
+            WorkerPool(const WorkerPool &) = delete;
+            WorkerPool &operator=(const WorkerPool &) = delete;
+
+            template<typename Task>
+            auto Submit(Task task) -> std::future<std::invoke_result_t<Task>>
+            {
+                using Result = std::invoke_result_t<Task>;
+                auto packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+                auto future = packaged->get_future();
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mQueue.emplace_back([packaged]{ (*packaged)(); });
+                }
+                mCv.notify_one();
+                return future;
+            }
+
+            size_t Size() const { return mThreads.size(); }
+
+            size_t Pending() const
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                return mQueue.size();
+            }
+
+        private:
+            void _run()
+            {
+                for (;;)
+                {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(mMutex);
+                        mCv.wait(lock, [this]{ return mStop || !mQueue.empty(); });
+                        // queued work is finished before the pool goes away
+                        if (mQueue.empty())
+                            return;
+                        task = std::move(mQueue.front());
+                        mQueue.pop_front();
+                    }
+                    task();
+                }
+            }
+
+            std::vector<std::thread> mThreads;
+            std::deque<std::function<void()>> mQueue;
+            mutable std::mutex mMutex;
+            std::condition_variable mCv;
+            bool mStop = false;
+    };
+};
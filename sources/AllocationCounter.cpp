@@ -0,0 +1,262 @@
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    constexpr size_t MAX_THREADS = 1024;
+    constexpr size_t SITE_TABLE_SIZE = 4096;
+    constexpr int SITE_DEPTH = 8;
+    constexpr size_t SITE_FRAMES_SHOWN = 3;
+
+    // written by the owning thread only, except the overflow slot shared by threads past MAX_THREADS
+    struct Slot{
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> frees{0};
+    };
+
+    struct SiteEntry{
+        std::atomic<uint64_t> hash{0};
+        void* frames[SITE_DEPTH];
+        int depth;
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> bytes{0};
+    };
+
+    // constant initialized, operator new may run before any dynamic initializer
+    Slot gSlots[MAX_THREADS + 1];
+    std::atomic<size_t> gNextSlot{0};
+    SiteEntry gSites[SITE_TABLE_SIZE];
+    std::atomic<bool> gSitesEnabled{false};
+
+    thread_local Slot* tSlot = nullptr;
+    // set while the counter itself allocates (scope totals, backtrace, symbols)
+    thread_local bool tInternal = false;
+
+    struct InternalGuard{
+        bool previous;
+        InternalGuard() : previous(tInternal) { tInternal = true; }
+        ~InternalGuard() { tInternal = previous; }
+    };
+
+    Slot& threadSlot(){
+        if (!tSlot)
+            tSlot = &gSlots[std::min(gNextSlot.fetch_add(1, std::memory_order_relaxed), MAX_THREADS)];
+        return *tSlot;
+    }
+
+    AllocationStats read(const Slot& slot){
+        return {slot.allocations.load(std::memory_order_relaxed), slot.bytes.load(std::memory_order_relaxed),
+                slot.frees.load(std::memory_order_relaxed)};
+    }
+
+#ifdef PRESIEN_ALLOCATION_COUNTING
+    [[maybe_unused]] const bool gSitesFromEnvironment = []{
+        const char* val = std::getenv("VBSALLOCSITES");
+        const bool enable = val != nullptr && std::string(val) == "1";
+        if (enable)
+            AllocationCounter::EnableSites(true);
+        return enable;
+    }();
+
+    __attribute__((noinline)) void recordSite(size_t size){
+        void* frames[SITE_DEPTH + 2];
+        int depth;
+        {
+            InternalGuard guard;
+            depth = backtrace(frames, SITE_DEPTH + 2);
+        }
+        // frames[0] is this function, frames[1] operator new
+        constexpr int SKIP = 2;
+        if (depth <= SKIP)
+            return;
+        uint64_t hash = 1469598103934665603ull;
+        for (int i = SKIP; i < depth; ++i)
+            hash = (hash ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211ull;
+        hash = hash ? hash : 1;
+
+        for (size_t probe = 0; probe < SITE_TABLE_SIZE; ++probe)
+        {
+            auto& entry = gSites[(hash + probe) % SITE_TABLE_SIZE];
+            uint64_t current = entry.hash.load(std::memory_order_acquire);
+            if (current == 0 && entry.hash.compare_exchange_strong(current, hash))
+            {
+                entry.depth = depth - SKIP;
+                std::memcpy(entry.frames, frames + SKIP, sizeof(void*) * static_cast<size_t>(entry.depth));
+                current = hash;
+            }
+            if (current == hash)
+            {
+                entry.allocations.fetch_add(1, std::memory_order_relaxed);
+                entry.bytes.fetch_add(size, std::memory_order_relaxed);
+                return;
+            }
+        }
+        // table full, the site is not recorded
+    }
+#endif
+
+    std::string frameName(void* frame, bool& inStdLib){
+        Dl_info info{};
+        inStdLib = false;
+        if (!dladdr(frame, &info))
+            return "?";
+        if (info.dli_fname && std::strstr(info.dli_fname, "libstdc++"))
+            inStdLib = true;
+        if (info.dli_sname)
+        {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            std::string name = status == 0 && demangled ? demangled : info.dli_sname;
+            std::free(demangled);
+            return name;
+        }
+        // not exported, resolve with addr2line -e <module> <offset>
+        char offset[32];
+        std::snprintf(offset, sizeof(offset), "+0x%zx", static_cast<size_t>(static_cast<char*>(frame) - static_cast<char*>(info.dli_fbase)));
+        return std::string(info.dli_fname ? info.dli_fname : "?") + offset;
+    }
+
+    std::mutex gScopeMutex;
+    std::map<std::string, AllocationScope::Totals>& scopeTotals(){
+        static std::map<std::string, AllocationScope::Totals> totals;
+        return totals;
+    }
+}
+
+#ifdef PRESIEN_ALLOCATION_COUNTING
+void* operator new(std::size_t size){
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    if (!tInternal)
+    {
+        auto& slot = threadSlot();
+        slot.allocations.fetch_add(1, std::memory_order_relaxed);
+        slot.bytes.fetch_add(size, std::memory_order_relaxed);
+        if (gSitesEnabled.load(std::memory_order_relaxed))
+            recordSite(size);
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept{
+    if (!p)
+        return;
+    if (!tInternal)
+        threadSlot().frees.fetch_add(1, std::memory_order_relaxed);
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept{
+    operator delete(p);
+}
+#endif
+
+bool AllocationCounter::Installed(){
+#ifdef PRESIEN_ALLOCATION_COUNTING
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocationStats AllocationCounter::Thread(){
+    return read(threadSlot());
+}
+
+AllocationStats AllocationCounter::Process(){
+    AllocationStats total;
+    const auto used = std::min(gNextSlot.load(), MAX_THREADS + 1);
+    for (size_t i = 0; i < used; ++i)
+        total += read(gSlots[i]);
+    return total;
+}
+
+void AllocationCounter::EnableSites(bool enable){
+#ifdef PRESIEN_ALLOCATION_COUNTING
+    if (enable)
+    {
+        // the first backtrace loads the unwinder, which allocates
+        InternalGuard guard;
+        void* warmUp[2];
+        backtrace(warmUp, 2);
+    }
+    gSitesEnabled = enable;
+#else
+    (void)enable;
+#endif
+}
+
+bool AllocationCounter::SitesEnabled(){
+    return gSitesEnabled.load();
+}
+
+std::vector<AllocationCounter::Site> AllocationCounter::TopSites(size_t count){
+    InternalGuard guard;
+    std::vector<const SiteEntry*> used;
+    for (const auto& entry : gSites)
+    {
+        if (entry.hash.load(std::memory_order_acquire) != 0)
+            used.push_back(&entry);
+    }
+    std::sort(used.begin(), used.end(), [](const SiteEntry* a, const SiteEntry* b){ return a->allocations.load() > b->allocations.load(); });
+    used.resize(std::min(count, used.size()));
+
+    std::vector<Site> sites;
+    for (const auto* entry : used)
+    {
+        Site site;
+        site.allocations = entry->allocations.load();
+        site.bytes = entry->bytes.load();
+        size_t shown = 0;
+        for (int i = 0; i < entry->depth && shown < SITE_FRAMES_SHOWN; ++i)
+        {
+            bool inStdLib = false;
+            auto name = frameName(entry->frames[i], inStdLib);
+            if (inStdLib)
+                continue;
+            site.frames += (shown++ ? " <- " : "") + name;
+        }
+        sites.push_back(std::move(site));
+    }
+    return sites;
+}
+
+AllocationScope::AllocationScope(const char* name)
+    :mName(name), mStart(AllocationCounter::Thread()){
+}
+
+AllocationScope::~AllocationScope(){
+    const auto stats = Stats();
+    InternalGuard guard;
+    std::lock_guard<std::mutex> lock(gScopeMutex);
+    auto& totals = scopeTotals()[mName];
+    ++totals.calls;
+    totals.stats += stats;
+}
+
+std::map<std::string, AllocationScope::Totals> AllocationScope::AllTotals(){
+    InternalGuard guard;
+    std::lock_guard<std::mutex> lock(gScopeMutex);
+    return scopeTotals();
+}
+
+void AllocationScope::Reset(){
+    InternalGuard guard;
+    std::lock_guard<std::mutex> lock(gScopeMutex);
+    scopeTotals().clear();
+}
@@ -1,18 +1,40 @@
 #include "AppConfig.h"
-#include <LicenseSpring/EncryptString.h>
+#include "PresienCryptoProvider.h"
+#include "SecretVault.h"
 
-LicenseSpring::Configuration::ptr_t AppConfig::createLicenseSpringConfig() const
+// Provide your LicenseSpring credentials here, please keep them safe
+PRESIEN_SECRET( kApiKey, "da262440-9ad3-47f4-b5d5-3612c0f08622" ); // your LicenseSpring API key (UUID)
+PRESIEN_SECRET( kSharedKey, "1h1ORaBjA6JZJbB3gJenU3-dz5nkcwS4v_tm6hGmWZU" ); // your LicenseSpring Shared key
+PRESIEN_SECRET( kProductCode, "BS110" ); // product code that you specified in LicenseSpring for your application
+
+std::string_view AppConfig::apiKey()
+{
+    return kApiKey.Reveal();
+}
+
+std::string_view AppConfig::sharedKey()
+{
+    return kSharedKey.Reveal();
+}
+
+std::string_view AppConfig::productCode()
+{
+    return kProductCode.Reveal();
+}
+
+LicenseSpring::Configuration::ptr_t AppConfig::createLicenseSpringConfig( const std::string& product ) const
 {
     // Optionally you can provide full path where license file will be stored, hardwareID and other options
     LicenseSpring::ExtendedOptions options;
     options.collectNetworkInfo( true );
     options.enableLogging( true );
     options.enableVMDetection( true );
+    // AES-256-GCM with cached key schedule, reads license files written by the default provider too
+    options.overrideCryptoProvider( PRESIEN::BlindSight::PresienCryptoProvider::create() );
 
-    // Provide your LicenseSpring credentials here, please keep them safe
     return LicenseSpring::Configuration::Create(
-        EncryptStr( "da262440-9ad3-47f4-b5d5-3612c0f08622" ), // your LicenseSpring API key (UUID)
-        EncryptStr( "1h1ORaBjA6JZJbB3gJenU3-dz5nkcwS4v_tm6hGmWZU" ), // your LicenseSpring Shared key
-        EncryptStr( "BS110" ), // product code that you specified in LicenseSpring for your application
+        std::string( apiKey() ),
+        std::string( sharedKey() ),
+        product.empty() ? std::string( productCode() ) : product,
         appName, appVersion, options );
 }
@@ -0,0 +1,95 @@
+#include "AsyncLicense.h"
+#include "LicenseMetrics.h"
+
+#include <cstdint>
+
+using namespace LicenseSpring;
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    // calls on the same license object coalesce, different objects never do
+    std::string licenseKey(const License::ptr_t& license){
+        return std::to_string(reinterpret_cast<uintptr_t>(license.get()));
+    }
+}
+
+AsyncLicense::AsyncLicense(LicenseManager::ptr_t manager, size_t ioThreads, Executor executor)
+    :mManager(std::move(manager)), mExecutor(std::move(executor)), mPool(ioThreads){
+    mTimer = std::thread([this]{ _expire(); });
+}
+
+AsyncLicense::~AsyncLicense(){
+    {
+        std::lock_guard<std::mutex> lock(mTimerMutex);
+        mStopTimer = true;
+    }
+    mTimerCv.notify_all();
+    mTimer.join();
+}
+
+AsyncCall<InstallationFile::ptr_t> AsyncLicense::Check(License::ptr_t license, Handler<InstallationFile::ptr_t> handler,
+                                                       std::chrono::milliseconds timeout, const InstallFileFilter& filter){
+    const auto key = "check\n" + licenseKey(license) + '\n' + filter.Channel + '\n' + filter.Environment;
+    return _start<InstallationFile::ptr_t>(key, [license, filter]{
+        PRESIEN_SDK_TIMER(CHECK);
+        return license->check(filter);
+    }, std::move(handler), timeout);
+}
+
+AsyncCall<bool> AsyncLicense::RegisterFloatingFeature(License::ptr_t license, const std::string& featureCode,
+                                                      Handler<bool> handler, std::chrono::milliseconds timeout){
+    const auto key = "floating\n" + licenseKey(license) + '\n' + featureCode;
+    return _start<bool>(key, [license, featureCode]{
+        PRESIEN_SDK_TIMER(REGISTER_FLOATING_FEATURE);
+        license->registerFloatingFeature(featureCode);
+        return true;
+    }, std::move(handler), timeout);
+}
+
+AsyncCall<License::ptr_t> AsyncLicense::ActivateLicense(const LicenseID& licenseId, Handler<License::ptr_t> handler,
+                                                        std::chrono::milliseconds timeout){
+    const auto key = "activate\n" + licenseId.id();
+    auto manager = mManager;
+    return _start<License::ptr_t>(key, [manager, licenseId]{
+        PRESIEN_SDK_TIMER(ACTIVATE_LICENSE);
+        return manager->activateLicense(licenseId);
+    }, std::move(handler), timeout);
+}
+
+void AsyncLicense::_arm(const std::shared_ptr<AsyncDetail::Pending>& pending, clock::time_point deadline){
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lock(mTimerMutex);
+        earliest = mDeadlines.empty() || deadline < mDeadlines.begin()->first;
+        mDeadlines.emplace(deadline, pending);
+    }
+    if (earliest)
+        mTimerCv.notify_all();
+}
+
+void AsyncLicense::_expire(){
+    std::unique_lock<std::mutex> lock(mTimerMutex);
+    while (!mStopTimer)
+    {
+        if (mDeadlines.empty())
+        {
+            mTimerCv.wait(lock);
+            continue;
+        }
+        const auto deadline = mDeadlines.begin()->first;
+        if (clock::now() < deadline)
+        {
+            mTimerCv.wait_until(lock, deadline);
+            continue;
+        }
+        auto pending = mDeadlines.begin()->second.lock();
+        mDeadlines.erase(mDeadlines.begin());
+        if (!pending)
+            continue;
+        // the handler may start another call, which arms a deadline
+        lock.unlock();
+        pending->Expire();
+        lock.lock();
+    }
+}
@@ -0,0 +1,116 @@
+// Encrypt/decrypt throughput of PresienCryptoProvider vs LicenseSpring DefaultCryptoProvider.
+// usage: presien-crypto-bench <license file> [iterations] [key] [salt]
+// The license file is decrypted with DefaultCryptoProvider first, so both providers
+// are measured on a real license payload.
+// Built with -DBENCHMARK_ALLOCATIONS=ON it also reports allocations per encrypt/decrypt.
+
+#include "AllocationCounter.h"
+#include "PresienCryptoProvider.h"
+
+#include <LicenseSpring/Exceptions.h>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace LicenseSpring;
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    void runBenchmark(const std::string& name, CryptoProvider& provider, const std::string& plain, int iterations){
+        using clock = std::chrono::steady_clock;
+
+        // first call pays key derivation, report it separately
+        auto start = clock::now();
+        auto cipher = provider.encrypt(plain);
+        auto setup = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        auto allocationsBefore = AllocationCounter::Thread();
+        start = clock::now();
+        for (int i = 0; i < iterations; ++i)
+            cipher = provider.encrypt(plain);
+        auto encryptSec = std::chrono::duration<double>(clock::now() - start).count();
+        const auto encryptAllocations = AllocationCounter::Thread() - allocationsBefore;
+
+        std::string result;
+        allocationsBefore = AllocationCounter::Thread();
+        start = clock::now();
+        for (int i = 0; i < iterations; ++i)
+            result = provider.decrypt(cipher);
+        auto decryptSec = std::chrono::duration<double>(clock::now() - start).count();
+        const auto decryptAllocations = AllocationCounter::Thread() - allocationsBefore;
+
+        if (result != plain)
+            std::cout << name << ": round trip mismatch!" << std::endl;
+
+        const double mb = static_cast<double>(plain.size()) * iterations / (1024.0 * 1024.0);
+        std::cout << std::left << std::setw(24) << name
+                  << " first call " << std::fixed << std::setprecision(3) << setup << " ms"
+                  << ", encrypt " << std::setprecision(1) << mb / encryptSec << " MB/s ("
+                  << std::setprecision(2) << encryptSec * 1e6 / iterations << " us/op)"
+                  << ", decrypt " << std::setprecision(1) << mb / decryptSec << " MB/s ("
+                  << std::setprecision(2) << decryptSec * 1e6 / iterations << " us/op)"
+                  << ", blob " << cipher.size() << " bytes" << std::endl;
+        if (AllocationCounter::Installed())
+        {
+            std::cout << std::left << std::setw(24) << ""
+                      << " allocations per encrypt " << std::setprecision(1) << static_cast<double>(encryptAllocations.allocations) / iterations
+                      << " (" << static_cast<double>(encryptAllocations.bytes) / iterations << " bytes)"
+                      << ", per decrypt " << static_cast<double>(decryptAllocations.allocations) / iterations
+                      << " (" << static_cast<double>(decryptAllocations.bytes) / iterations << " bytes)" << std::endl;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: " << argv[0] << " <license file> [iterations] [key] [salt]" << std::endl;
+        return -1;
+    }
+    const int iterations = argc > 2 ? std::stoi(argv[2]) : 10000;
+    const std::string key = argc > 3 ? argv[3] : "";
+    const std::string salt = argc > 4 ? argv[4] : "";
+
+    std::ifstream is(argv[1], std::ios::binary);
+    if (!is.good())
+    {
+        std::cout << "Error - cannot read " << argv[1] << std::endl;
+        return -1;
+    }
+    std::stringstream ss;
+    ss << is.rdbuf();
+    std::string blob = ss.str();
+
+    auto defaultProvider = DefaultCryptoProvider::create();
+    auto presienProvider = PresienCryptoProvider::create();
+    if (!key.empty())
+    {
+        defaultProvider->setKey(key);
+        presienProvider->setKey(key);
+    }
+    if (!salt.empty())
+    {
+        defaultProvider->setSalt(salt);
+        presienProvider->setSalt(salt);
+    }
+
+    std::string plain = blob;
+    try
+    {
+        plain = defaultProvider->decrypt(blob);
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << "License file is not DefaultCryptoProvider encrypted (" << ex.what() << "), using it as is." << std::endl;
+    }
+
+    std::cout << "License payload: " << plain.size() << " bytes, " << iterations << " iterations" << std::endl;
+    runBenchmark("DefaultCryptoProvider", *defaultProvider, plain, iterations);
+    runBenchmark("PresienCryptoProvider", *presienProvider, plain, iterations);
+    return 0;
+}
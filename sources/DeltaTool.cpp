@@ -0,0 +1,52 @@
+// Packaging side of delta updates.
+// usage: presien-package-delta make <old package> <new package> <delta>
+//        presien-package-delta apply <old package> <delta> <output>
+// Publish the delta of version N next to its full package as "<package url>.delta", built
+// against the package of InstallationFile::requiredVersion(). Devices walk the version list
+// one delta at a time and fall back to the full package when any step fails.
+
+#include "PackageDelta.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+using namespace PRESIEN::BlindSight;
+
+int main(int argc, char** argv)
+{
+    const std::string mode = argc > 1 ? argv[1] : "";
+    if (argc != 5 || (mode != "make" && mode != "apply"))
+    {
+        std::cout << "usage: " << argv[0] << " make <old> <new> <delta> | apply <old> <delta> <output>" << std::endl;
+        return -1;
+    }
+
+    try
+    {
+        const auto start = std::chrono::steady_clock::now();
+        if (mode == "make")
+        {
+            auto stats = PackageDelta::Create(argv[2], argv[3], argv[4]);
+            const auto total = stats.copied + stats.literal;
+            std::cout << "chunks " << stats.chunks << ", copied " << stats.copied << " B, literal " << stats.literal
+                      << " B, delta " << stats.deltaSize << " B (" << std::fixed << std::setprecision(1)
+                      << (total ? 100.0 * static_cast<double>(stats.deltaSize) / static_cast<double>(total) : 0.0)
+                      << "% of new package)" << std::endl;
+        }
+        else
+        {
+            const auto md5 = PackageDelta::Apply(argv[2], argv[3], argv[4]);
+            std::cout << "md5 " << md5 << std::endl;
+        }
+        std::cout << std::fixed << std::setprecision(3)
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,253 @@
+#include "DeviceTelemetry.h"
+#include "LicenseMetrics.h"
+#include "PresienLog.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <json/json.hpp>
+
+using namespace LicenseSpring;
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    // Memory is reported in buckets so small fluctuations do not count as a change
+    constexpr long MEMORY_BUCKET_MB = 64;
+
+    std::string readFirstLine(const std::string& file){
+        std::ifstream is(file);
+        std::string line;
+        if (is.good())
+            std::getline(is, line);
+        return line;
+    }
+
+    long readMemInfoKB(const std::string& key){
+        std::ifstream is("/proc/meminfo");
+        std::string name;
+        long value = 0;
+        std::string unit;
+        while (is >> name >> value >> unit)
+        {
+            if (name == key + ":")
+                return value;
+        }
+        return -1;
+    }
+
+    // Thermal zones on Jetson are named "CPU-therm"/"GPU-therm", on x86 "x86_pkg_temp"
+    void readThermalZones(DeviceTelemetry::VariableMap& out){
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator("/sys/class/thermal", ec))
+        {
+            const auto zone = entry.path().string();
+            if (zone.find("thermal_zone") == std::string::npos)
+                continue;
+            auto type = readFirstLine(zone + "/type");
+            auto temp = readFirstLine(zone + "/temp");
+            if (type.empty() || temp.empty())
+                continue;
+
+            std::string name;
+            if (type.find("CPU") != std::string::npos || type.find("x86_pkg") != std::string::npos)
+                name = "CPU_TempC";
+            else if (type.find("GPU") != std::string::npos)
+                name = "GPU_TempC";
+            else
+                continue;
+
+            try
+            {
+                // sysfs reports milli degree Celsius, whole degrees are enough for telemetry
+                out.emplace(name, std::to_string(std::stol(temp) / 1000));
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+}
+
+DeviceTelemetry::DeviceTelemetry(const std::string& stateFile):mStateFile(stateFile){
+    _loadState();
+}
+
+DeviceTelemetry::~DeviceTelemetry(){
+    StopPeriodicFlush();
+}
+
+void DeviceTelemetry::SetStaticVariable(const std::string& name, const std::string& value){
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStatic[name] = value;
+}
+
+void DeviceTelemetry::Sample(){
+    Update(Collect());
+}
+
+DeviceTelemetry::VariableMap DeviceTelemetry::Collect(){
+    VariableMap sample;
+    sample["CPU_Cores"] = std::to_string(std::thread::hardware_concurrency());
+
+    auto memTotal = readMemInfoKB("MemTotal");
+    if (memTotal >= 0)
+        sample["MemTotalMB"] = std::to_string(memTotal / 1024);
+    auto memAvailable = readMemInfoKB("MemAvailable");
+    if (memAvailable >= 0)
+        sample["MemAvailableMB"] = std::to_string(memAvailable / 1024 / MEMORY_BUCKET_MB * MEMORY_BUCKET_MB);
+
+    readThermalZones(sample);
+    return sample;
+}
+
+void DeviceTelemetry::Update(VariableMap sample){
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSampled.swap(sample);
+}
+
+DeviceTelemetry::VariableMap DeviceTelemetry::PendingChanges() const{
+    std::lock_guard<std::mutex> lock(mMutex);
+    VariableMap changes;
+    auto diff = [&](const VariableMap& values){
+        for (const auto& v : values)
+        {
+            auto it = mAcked.find(v.first);
+            if (it == mAcked.end() || it->second != v.second)
+                changes[v.first] = v.second;
+        }
+    };
+    diff(mStatic);
+    diff(mSampled);
+    return changes;
+}
+
+size_t DeviceTelemetry::Flush(License::ptr_t license){
+    if (!license)
+        return 0;
+
+    const auto licenseKey = license->key().empty() ? license->user() : license->key();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mAckedLicense != licenseKey)
+        {
+            mAcked.clear();
+            mAckedLicense = licenseKey;
+        }
+    }
+
+    auto changes = PendingChanges();
+    if (changes.empty())
+        return 0;
+
+    std::vector<DeviceVariable> batch;
+    batch.reserve(changes.size());
+    for (const auto& v : changes)
+        batch.emplace_back(v.first, v.second);
+
+    license->addDeviceVariables(batch);
+    bool sent = false;
+    {
+        PRESIEN_SDK_TIMER(SEND_DEVICE_VARIABLES);
+        sent = license->sendDeviceVariables();
+    }
+    // false means request failed and grace period started, keep changes pending for next flush
+    if (!sent)
+        return 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const auto& v : changes)
+            mAcked[v.first] = v.second;
+    }
+    _saveState();
+    return batch.size();
+}
+
+void DeviceTelemetry::ResetAcknowledged(){
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mAcked.clear();
+    }
+    _saveState();
+}
+
+void DeviceTelemetry::StartPeriodicFlush(License::ptr_t license, std::chrono::seconds interval){
+    StopPeriodicFlush();
+    {
+        std::lock_guard<std::mutex> lock(mWorkerMutex);
+        mStopWorker = false;
+    }
+
+    // Attention, do not capture License::ptr_t (shared_ptr), same as for the SDK watchdog.
+    std::weak_ptr<License> wpLicense(license);
+    mWorker = std::thread([this, wpLicense, interval]{
+        std::unique_lock<std::mutex> lock(mWorkerMutex);
+        while (!mWorkerCv.wait_for(lock, interval, [this]{ return mStopWorker; }))
+        {
+            lock.unlock();
+            if (auto pLicense = wpLicense.lock())
+            {
+                try
+                {
+                    Sample();
+                    Flush(pLicense);
+                }
+                catch (const LicenseSpringException& ex)
+                {
+                    PLOG_ERROR("Telemetry flush failed: " << ex.what());
+                }
+            }
+            lock.lock();
+        }
+    });
+}
+
+void DeviceTelemetry::StopPeriodicFlush(){
+    {
+        std::lock_guard<std::mutex> lock(mWorkerMutex);
+        mStopWorker = true;
+    }
+    mWorkerCv.notify_all();
+    if (mWorker.joinable())
+        mWorker.join();
+}
+
+void DeviceTelemetry::_loadState(){
+    if (mStateFile.empty())
+        return;
+    std::ifstream is(mStateFile);
+    if (!is.good())
+        return;
+    try
+    {
+        auto data = nlohmann::json::parse(is);
+        // older state without the license key is sent once again
+        mAckedLicense = data.value("license", "");
+        for (const auto& item : data.value("variables", nlohmann::json::object()).items())
+            mAcked[item.key()] = item.value().get<std::string>();
+    }
+    catch (const nlohmann::json::exception&)
+    {
+        // corrupted state only means everything is sent once again
+        mAcked.clear();
+    }
+}
+
+void DeviceTelemetry::_saveState() const{
+    if (mStateFile.empty())
+        return;
+    nlohmann::json data;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        data["license"] = mAckedLicense;
+        data["variables"] = nlohmann::json::object();
+        for (const auto& v : mAcked)
+            data["variables"][v.first] = v.second;
+    }
+    std::ofstream os(mStateFile, std::ios::trunc);
+    os << data.dump();
+}
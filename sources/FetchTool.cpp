@@ -0,0 +1,177 @@
+// Package downloader driver and a local range-capable file server to run it against.
+// usage: presien-package-fetch serve file=<path> [port=8090] [fail=0.0] [ranges=1]
+//        presien-package-fetch fetch url=<url> dest=<path> [md5=<hex>] [size=0] [connections=4] [chunk=4194304]
+// serve drops a response halfway with probability fail, ranges=0 ignores Range headers.
+// Interrupt fetch and run it again to resume from the checkpoint.
+
+#include "PackageDownloader.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    using Args = std::map<std::string, std::string>;
+
+    bool sendAll(int fd, const char* data, size_t size){
+        while (size > 0)
+        {
+            auto sent = send(fd, data, size, MSG_NOSIGNAL);
+            if (sent <= 0)
+                return false;
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    void serveConnection(int fd, const std::string& content, double failRate, bool ranges){
+        thread_local std::mt19937 rng(std::random_device{}());
+        std::uniform_real_distribution<double> chance(0.0, 1.0);
+        std::string buffer;
+        char data[4096];
+        for (;;)
+        {
+            size_t end;
+            while ((end = buffer.find("\r\n\r\n")) == std::string::npos)
+            {
+                auto received = recv(fd, data, sizeof(data), 0);
+                if (received <= 0)
+                {
+                    close(fd);
+                    return;
+                }
+                buffer.append(data, static_cast<size_t>(received));
+            }
+            std::istringstream request(buffer.substr(0, end));
+            buffer.erase(0, end + 4);
+
+            std::string method, line;
+            request >> method;
+            uint64_t first = 0, last = content.size() - 1;
+            bool partial = false;
+            while (std::getline(request, line))
+            {
+                if (ranges && line.rfind("Range: bytes=", 0) == 0)
+                {
+                    auto dash = line.find('-');
+                    first = std::stoull(line.substr(13, dash - 13));
+                    last = std::min<uint64_t>(std::stoull(line.substr(dash + 1)), content.size() - 1);
+                    partial = true;
+                }
+            }
+
+            const uint64_t length = last - first + 1;
+            std::ostringstream head;
+            head << "HTTP/1.1 " << (partial ? "206 Partial Content" : "200 OK") << "\r\n"
+                 << "Content-Length: " << length << "\r\n";
+            if (ranges)
+                head << "Accept-Ranges: bytes\r\n";
+            if (partial)
+                head << "Content-Range: bytes " << first << "-" << last << "/" << content.size() << "\r\n";
+            head << "\r\n";
+            const auto headers = head.str();
+            if (!sendAll(fd, headers.data(), headers.size()))
+                break;
+            if (method == "HEAD")
+                continue;
+            if (chance(rng) < failRate)
+            {
+                sendAll(fd, content.data() + first, length / 2);
+                break;
+            }
+            if (!sendAll(fd, content.data() + first, length))
+                break;
+        }
+        close(fd);
+    }
+
+    int serve(Args& args){
+        std::ifstream is(args["file"], std::ios::binary);
+        if (!is.good())
+        {
+            std::cout << "Cannot read " << args["file"] << std::endl;
+            return -1;
+        }
+        const std::string content((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+        const double failRate = std::stod(args["fail"]);
+        const bool ranges = args["ranges"] != "0";
+
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(static_cast<uint16_t>(std::stoi(args["port"])));
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0)
+        {
+            std::cout << "Cannot listen on port " << args["port"] << std::endl;
+            return -1;
+        }
+        std::cout << "Serving " << content.size() << " bytes on http://127.0.0.1:" << args["port"] << "/" << std::endl;
+        for (;;)
+        {
+            int fd = accept(listener, nullptr, nullptr);
+            if (fd >= 0)
+                std::thread(serveConnection, fd, std::cref(content), failRate, ranges).detach();
+        }
+    }
+
+    int fetch(Args& args){
+        PackageDownloader::Options options;
+        options.connections = std::stoul(args["connections"]);
+        options.chunkSize = std::stoul(args["chunk"]);
+        PackageDownloader downloader(options);
+
+        const auto start = std::chrono::steady_clock::now();
+        auto result = downloader.Download(args["url"], args["dest"], std::stoull(args["size"]), args["md5"]);
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << (result.ok ? "ok" : "failed: " + result.error) << std::endl;
+        std::cout << "size " << result.size << ", transferred " << result.downloaded << (result.resumed ? " (resumed)" : "")
+                  << ", md5 " << result.md5 << std::endl;
+        std::cout << std::fixed << std::setprecision(2) << elapsed << " s, "
+                  << static_cast<double>(result.downloaded) / elapsed / (1024 * 1024) << " MiB/s" << std::endl;
+        return result.ok ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::string mode = argc > 1 ? argv[1] : "";
+    Args args = {
+        {"file", ""}, {"port", "8090"}, {"fail", "0"}, {"ranges", "1"},
+        {"url", ""}, {"dest", ""}, {"md5", ""}, {"size", "0"}, {"connections", "4"}, {"chunk", "4194304"}
+    };
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if (eq == std::string::npos || !args.count(arg.substr(0, eq)))
+        {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            return -1;
+        }
+        args[arg.substr(0, eq)] = arg.substr(eq + 1);
+    }
+    if (mode == "serve")
+        return serve(args);
+    if (mode == "fetch")
+        return fetch(args);
+    std::cout << "usage: " << argv[0] << " serve|fetch [key=value ...]" << std::endl;
+    return -1;
+}
@@ -0,0 +1,257 @@
+#include "HardwareFingerprint.h"
+#include "Sha1.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <json/json.hpp>
+
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    std::string readFirstLine(const std::string& file){
+        std::ifstream is(file);
+        std::string line;
+        if (is.good())
+            std::getline(is, line);
+        // Remove ending '\r' and blanks
+        while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back())))
+            line.pop_back();
+        return line;
+    }
+
+    std::string getEnv(const char* var){
+        const char* val = std::getenv(var);
+        return val ? val : "";
+    }
+
+    std::string toUpper(std::string value){
+        std::transform(value.begin(), value.end(), value.begin(),
+            [](unsigned char c){ return std::toupper(c); });
+        return value;
+    }
+
+    // how long a late preferred source is waited for once the license is bound to it
+    constexpr std::chrono::seconds BOUND_SOURCE_TIMEOUT{5};
+
+    // Results of the probes, shared with detached probe threads which may outlive Resolve()
+    struct ProbeState{
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<bool> done;
+        std::vector<std::string> values;
+    };
+}
+
+HardwareFingerprint::HardwareFingerprint(const std::string& cacheFile):mCacheFile(cacheFile){
+}
+
+void HardwareFingerprint::AddSource(const std::string& name, Probe probe, std::chrono::milliseconds timeout){
+    mSources.push_back({name, std::move(probe), timeout});
+}
+
+HardwareFingerprint HardwareFingerprint::CreateDefault(const std::string& cacheFile){
+    using namespace std::chrono_literals;
+    HardwareFingerprint fingerprint(cacheFile);
+    // tegra fuse read is known to stall on some carrier boards, give it the longest deadline
+    fingerprint.AddSource("tegra_fuse", &HardwareFingerprint::ReadTegraChipUid, 250ms);
+    fingerprint.AddSource("dmi", &HardwareFingerprint::ReadDmiId, 50ms);
+    fingerprint.AddSource("machine_id", &HardwareFingerprint::ReadMachineId, 50ms);
+    fingerprint.AddSource("nic_mac", &HardwareFingerprint::ReadNicMacs, 50ms);
+    fingerprint.AddSource("environment", &HardwareFingerprint::ReadEnvironmentId, 10ms);
+    return fingerprint;
+}
+
+HardwareFingerprint::Result HardwareFingerprint::Resolve(bool useCache){
+    Result result;
+    Result cached;
+    const bool haveCached = _readCache(cached);
+    if (useCache && haveCached)
+        return cached;
+    // a cached preferred id also with a stale binding (e.g. machine-id regenerated on this device)
+    const bool bound = haveCached || (!mSources.empty() && _cachedSource() == mSources.front().name);
+
+    auto state = std::make_shared<ProbeState>();
+    state->done.assign(mSources.size(), false);
+    state->values.assign(mSources.size(), std::string());
+
+    // Threads are detached on purpose, a stalled sysfs read must not hold up the caller
+    for (size_t i = 0; i < mSources.size(); ++i)
+    {
+        std::thread([state, i, probe = mSources[i].probe]{
+            std::string value;
+            try
+            {
+                value = probe();
+            }
+            catch (...)
+            {
+            }
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->values[i] = std::move(value);
+            state->done[i] = true;
+            state->cv.notify_all();
+        }).detach();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    size_t chosen = mSources.size();
+    for (size_t i = 0; i < mSources.size(); ++i)
+    {
+        const auto deadline = start + mSources[i].timeout;
+        if (!state->cv.wait_until(lock, deadline, [&]{ return state->done[i]; }))
+        {
+            if (i != 0 || !bound)
+                continue;
+            // a fallback id would not match the one the license was activated with
+            if (haveCached)
+                return cached;
+            if (!state->cv.wait_until(lock, start + BOUND_SOURCE_TIMEOUT, [&]{ return state->done[0]; }))
+                return result;
+        }
+        // an empty answer means the source does not exist here, falling back is fine then
+        if (state->values[i].empty())
+            continue;
+
+        result.source = mSources[i].name;
+        result.raw = state->values[i];
+        chosen = i;
+        break;
+    }
+    lock.unlock();
+
+    if (result.raw.empty())
+        return result;
+
+    SHA1 checksum;
+    checksum.update(result.raw);
+    result.id = checksum.final();
+    // a fallback may only be there because the preferred source missed its deadline this time
+    if (chosen == 0)
+        _writeCache(result);
+    return result;
+}
+
+std::string HardwareFingerprint::ReadTegraChipUid(){
+    return readFirstLine("/sys/module/tegra_fuse/parameters/tegra_chip_uid");
+}
+
+std::string HardwareFingerprint::ReadMachineId(){
+    return readFirstLine("/etc/machine-id");
+}
+
+std::string HardwareFingerprint::ReadDmiId(){
+    auto id = readFirstLine("/sys/class/dmi/id/product_uuid");
+    if (id.empty())
+        id = readFirstLine("/sys/class/dmi/id/board_serial");
+    return id;
+}
+
+std::string HardwareFingerprint::ReadNicMacs(){
+    namespace fs = std::filesystem;
+    std::vector<std::string> macs;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator("/sys/class/net", ec))
+    {
+        // skip loopback and virtual interfaces (docker0, veth...), they have no device link
+        if (!fs::exists(entry.path() / "device", ec))
+            continue;
+        auto mac = readFirstLine((entry.path() / "address").string());
+        if (mac.empty() || mac == "00:00:00:00:00:00")
+            continue;
+        macs.push_back(toUpper(mac));
+    }
+    // sorted so enumeration order of interfaces does not change the id
+    std::sort(macs.begin(), macs.end());
+    std::string joined;
+    for (const auto& mac : macs)
+        joined += mac;
+    return joined;
+}
+
+std::string HardwareFingerprint::ReadEnvironmentId(){
+    //shared as environment variable to docker run, see ls_demo.sh
+    //string - 48B02D55DE70CHEWY-CARAMELHEXAGONSSN1234
+    auto mac = toUpper(getEnv("MAC1"));
+    mac.erase(std::remove(mac.begin(), mac.end(), ':'), mac.end());
+    auto host = toUpper(getEnv("TARGETHOSTNAME"));
+    auto ssn = toUpper(getEnv("CUSTOMER_SSN"));
+    if (mac.empty() && host.empty() && ssn.empty())
+        return "";
+    return mac + host + ssn;
+}
+
+std::string HardwareFingerprint::ReadBinding(){
+    const auto machineId = ReadMachineId();
+    const auto dmi = ReadDmiId();
+    if (machineId.empty() && dmi.empty())
+        return "";
+    SHA1 checksum;
+    checksum.update("machine-id:" + machineId + "|dmi:" + dmi);
+    return checksum.final();
+}
+
+bool HardwareFingerprint::_readCache(Result& result) const{
+    if (mCacheFile.empty() || mSources.empty())
+        return false;
+    std::ifstream is(mCacheFile);
+    if (!is.good())
+        return false;
+    try
+    {
+        auto data = nlohmann::json::parse(is);
+        // written by another device (copied volume or image) or by an older version
+        const auto binding = ReadBinding();
+        if (binding.empty() || data.value("binding", "") != binding || data.value("source", "") != mSources.front().name)
+            return false;
+        result.source = data.at("source").get<std::string>();
+        result.raw = data.at("raw").get<std::string>();
+        result.id = data.at("id").get<std::string>();
+        result.fromCache = true;
+        return !result.id.empty();
+    }
+    catch (const nlohmann::json::exception&)
+    {
+        result = Result();
+        return false;
+    }
+}
+
+std::string HardwareFingerprint::_cachedSource() const{
+    if (mCacheFile.empty())
+        return "";
+    std::ifstream is(mCacheFile);
+    if (!is.good())
+        return "";
+    try
+    {
+        return nlohmann::json::parse(is).value("source", "");
+    }
+    catch (const nlohmann::json::exception&)
+    {
+        return "";
+    }
+}
+
+void HardwareFingerprint::_writeCache(const Result& result) const{
+    if (mCacheFile.empty())
+        return;
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(mCacheFile).parent_path(), ec);
+    nlohmann::json data = {
+        {"source", result.source},
+        {"raw", result.raw},
+        {"id", result.id},
+        {"binding", ReadBinding()}
+    };
+    std::ofstream os(mCacheFile, std::ios::trunc);
+    os << data.dump();
+}
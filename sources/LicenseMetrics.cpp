@@ -0,0 +1,209 @@
+#include "LicenseMetrics.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    const char* callName(size_t call){
+        static const char* names[LicenseMetrics::CALL_COUNT] = {
+            "activateLicense",
+            "check",
+            "localCheck",
+            "registerFloatingFeature",
+            "syncConsumption",
+            "sendDeviceVariables",
+            "getProductDetails",
+            "getVersionList",
+            "getInstallationFile"
+        };
+        return names[call];
+    }
+}
+
+struct LicenseMetrics::Shard{
+    std::atomic<uint64_t> calls[CALL_COUNT] = {};
+    std::atomic<uint64_t> errors[CALL_COUNT] = {};
+    std::atomic<uint64_t> sumNs[CALL_COUNT] = {};
+    std::atomic<uint64_t> buckets[CALL_COUNT][BUCKETS.size() + 1] = {};
+    Shard* next = nullptr;
+};
+
+LicenseMetrics::~LicenseMetrics(){
+    StopHttpEndpoint();
+    // shards are intentionally not freed, detached threads may still record during exit
+}
+
+LicenseMetrics::Shard& LicenseMetrics::_localShard(){
+    thread_local Shard* shard = nullptr;
+    if (!shard)
+    {
+        // once per thread: push a new shard to the lock-free list
+        shard = new Shard();
+        shard->next = mShards.load(std::memory_order_relaxed);
+        while (!mShards.compare_exchange_weak(shard->next, shard, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+    return *shard;
+}
+
+void LicenseMetrics::Record(SdkCall call, std::chrono::nanoseconds elapsed, bool failed){
+    const auto index = static_cast<size_t>(call);
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    size_t bucket = 0;
+    while (bucket < BUCKETS.size() && seconds > BUCKETS[bucket])
+        ++bucket;
+
+    auto& shard = _localShard();
+    shard.calls[index].fetch_add(1, std::memory_order_relaxed);
+    shard.sumNs[index].fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+    shard.buckets[index][bucket].fetch_add(1, std::memory_order_relaxed);
+    if (failed)
+        shard.errors[index].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::string LicenseMetrics::RenderPrometheus() const{
+    uint64_t calls[CALL_COUNT] = {};
+    uint64_t errors[CALL_COUNT] = {};
+    uint64_t sumNs[CALL_COUNT] = {};
+    uint64_t buckets[CALL_COUNT][BUCKETS.size() + 1] = {};
+
+    for (auto* shard = mShards.load(std::memory_order_acquire); shard; shard = shard->next)
+    {
+        for (size_t c = 0; c < CALL_COUNT; ++c)
+        {
+            calls[c] += shard->calls[c].load(std::memory_order_relaxed);
+            errors[c] += shard->errors[c].load(std::memory_order_relaxed);
+            sumNs[c] += shard->sumNs[c].load(std::memory_order_relaxed);
+            for (size_t b = 0; b <= BUCKETS.size(); ++b)
+                buckets[c][b] += shard->buckets[c][b].load(std::memory_order_relaxed);
+        }
+    }
+
+    std::ostringstream os;
+    os << "# HELP presien_license_sdk_calls_total LicenseSpring SDK calls made by presien-lic-app.\n";
+    os << "# TYPE presien_license_sdk_calls_total counter\n";
+    for (size_t c = 0; c < CALL_COUNT; ++c)
+        os << "presien_license_sdk_calls_total{call=\"" << callName(c) << "\"} " << calls[c] << '\n';
+
+    os << "# HELP presien_license_sdk_errors_total LicenseSpring SDK calls which threw an exception.\n";
+    os << "# TYPE presien_license_sdk_errors_total counter\n";
+    for (size_t c = 0; c < CALL_COUNT; ++c)
+        os << "presien_license_sdk_errors_total{call=\"" << callName(c) << "\"} " << errors[c] << '\n';
+
+    os << "# HELP presien_license_sdk_call_duration_seconds Latency of LicenseSpring SDK calls.\n";
+    os << "# TYPE presien_license_sdk_call_duration_seconds histogram\n";
+    for (size_t c = 0; c < CALL_COUNT; ++c)
+    {
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b < BUCKETS.size(); ++b)
+        {
+            cumulative += buckets[c][b];
+            os << "presien_license_sdk_call_duration_seconds_bucket{call=\"" << callName(c)
+               << "\",le=\"" << BUCKETS[b] << "\"} " << cumulative << '\n';
+        }
+        cumulative += buckets[c][BUCKETS.size()];
+        os << "presien_license_sdk_call_duration_seconds_bucket{call=\"" << callName(c) << "\",le=\"+Inf\"} " << cumulative << '\n';
+        os << "presien_license_sdk_call_duration_seconds_sum{call=\"" << callName(c) << "\"} " << sumNs[c] / 1e9 << '\n';
+        os << "presien_license_sdk_call_duration_seconds_count{call=\"" << callName(c) << "\"} " << cumulative << '\n';
+    }
+    return os.str();
+}
+
+bool LicenseMetrics::WriteTextfile(const std::string& path) const{
+    // collector must never see a half written file
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream os(tmpPath, std::ios::trunc);
+        if (!os.good())
+            return false;
+        os << RenderPrometheus();
+        if (!os.good())
+            return false;
+    }
+    return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+bool LicenseMetrics::StartHttpEndpoint(uint16_t port){
+    if (mServing.load())
+        return true;
+
+    mListenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (mListenFd < 0)
+        return false;
+    int reuse = 1;
+    setsockopt(mListenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(mListenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(mListenFd, 8) != 0)
+    {
+        close(mListenFd);
+        mListenFd = -1;
+        return false;
+    }
+
+    mServing = true;
+    mHttpThread = std::thread([this]{
+        while (mServing.load())
+        {
+            pollfd pfd{mListenFd, POLLIN, 0};
+            if (poll(&pfd, 1, 200) <= 0)
+                continue;
+            int client = accept(mListenFd, nullptr, nullptr);
+            if (client < 0)
+                continue;
+            // a client that connects and stays silent must not hold the thread, Stop joins it
+            timeval timeout{1, 0};
+            setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+            // request content does not matter, every path answers with the metrics
+            char request[1024];
+            (void)recv(client, request, sizeof(request), 0);
+
+            const auto body = RenderPrometheus();
+            std::ostringstream response;
+            response << "HTTP/1.0 200 OK\r\n"
+                     << "Content-Type: text/plain; version=0.0.4\r\n"
+                     << "Content-Length: " << body.size() << "\r\n"
+                     << "Connection: close\r\n\r\n"
+                     << body;
+            const auto data = response.str();
+            size_t sent = 0;
+            while (sent < data.size())
+            {
+                auto n = send(client, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0)
+                    break;
+                sent += static_cast<size_t>(n);
+            }
+            close(client);
+        }
+    });
+    return true;
+}
+
+void LicenseMetrics::StopHttpEndpoint(){
+    mServing = false;
+    if (mHttpThread.joinable())
+        mHttpThread.join();
+    if (mListenFd >= 0)
+    {
+        close(mListenFd);
+        mListenFd = -1;
+    }
+}
@@ -0,0 +1,392 @@
+#include "LicenseRegistry.h"
+#include "AppConfig.h"
+#include "LicenseMetrics.h"
+#include "MemoryGovernor.h"
+#include "PresienLog.h"
+
+#include <LicenseSpring/Exceptions.h>
+
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace LicenseSpring;
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    // product codes and hardware ids become directory names, percent-encoded so that
+    // different ids never share a directory; letters, digits, '-' and '_' stay as they are
+    std::string pathSafe(const std::string& value){
+        static const char HEX[] = "0123456789ABCDEF";
+        std::string encoded;
+        encoded.reserve(value.size());
+        for (unsigned char c : value)
+        {
+            if (std::isalnum(c) || c == '-' || c == '_')
+                encoded += static_cast<char>(c);
+            else
+            {
+                encoded += '%';
+                encoded += HEX[c >> 4];
+                encoded += HEX[c & 0x0F];
+            }
+        }
+        return encoded;
+    }
+
+    // inverse of pathSafe, false for names pathSafe does not produce
+    bool fromPathSafe(const std::string& name, std::string& value){
+        value.clear();
+        for (size_t i = 0; i < name.size(); ++i)
+        {
+            if (name[i] != '%')
+            {
+                value += name[i];
+                continue;
+            }
+            if (i + 2 >= name.size() || !std::isxdigit(static_cast<unsigned char>(name[i + 1])) || !std::isxdigit(static_cast<unsigned char>(name[i + 2])))
+                return false;
+            value += static_cast<char>(std::stoi(name.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        }
+        return true;
+    }
+
+    class KeyedLicenseStorage : public LicenseStorage{
+        public:
+            KeyedLicenseStorage(RegistryStorage::ptr_t storage, std::string key):mStorage(std::move(storage)), mKey(std::move(key)) {}
+
+            void saveLicense(const std::string& licenseData) override { mStorage->Save(mKey, licenseData); }
+            std::string loadLicense() override { return mStorage->Load(mKey); }
+            void clear() override { mStorage->Clear(mKey); }
+
+        private:
+            RegistryStorage::ptr_t mStorage;
+            std::string mKey;
+    };
+}
+
+LicenseStorage::ptr_t RegistryStorage::ForKey(const std::string& productCode, const std::string& hardwareId){
+    // views keep the backend alive
+    return std::make_shared<KeyedLicenseStorage>(shared_from_this(), pathSafe(productCode) + "/" + pathSafe(hardwareId));
+}
+
+std::wstring RegistryStorage::_path(const std::string& key) const{
+    return (std::filesystem::path(mRoot) / key / "License.key").wstring();
+}
+
+void RegistryStorage::Save(const std::string& key, const std::string& data){
+    std::lock_guard<std::mutex> lock(mMutex);
+    const std::filesystem::path path(_path(key));
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    const auto tmpPath = path.string() + ".tmp";
+    {
+        std::ofstream os(tmpPath, std::ios::binary | std::ios::trunc);
+        os << data;
+        if (!os.good())
+            throw LocalLicenseException("Cannot write license file " + tmpPath);
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec)
+        throw LocalLicenseException("Cannot write license file " + path.string());
+    mCache[key] = data;
+}
+
+std::string RegistryStorage::Load(const std::string& key){
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mCache.find(key);
+    if (it != mCache.end())
+        return it->second;
+
+    std::ifstream is(std::filesystem::path(_path(key)), std::ios::binary);
+    if (!is.good())
+        return std::string();
+    std::stringstream ss;
+    ss << is.rdbuf();
+    return mCache[key] = ss.str();
+}
+
+void RegistryStorage::Clear(const std::string& key){
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::error_code ec;
+    std::filesystem::remove(std::filesystem::path(_path(key)), ec);
+    mCache.erase(key);
+}
+
+void RegistryStorage::ReleaseMemory(){
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCache.clear();
+}
+
+LicenseRegistry::LicenseRegistry(const Options& options)
+    :mOptions(options), mStorage(std::make_shared<RegistryStorage>(options.storageRoot)), mPool(options.workers){
+    mMemoryReleaser = MemoryGovernor::GetInstance().Register("license registry", [this]{ ReleaseMemory(); });
+}
+
+LicenseRegistry::~LicenseRegistry(){
+    MemoryGovernor::GetInstance().Unregister(mMemoryReleaser);
+    StopTelemetry();
+}
+
+void LicenseRegistry::ReleaseMemory(){
+    mStorage->ReleaseMemory();
+    // refetched by the next GetProductDetails, requests in flight are kept
+    std::lock_guard<std::mutex> lock(mProductsMutex);
+    mProducts.clear();
+}
+
+LicenseManager::ptr_t LicenseRegistry::Add(const Key& key){
+    {
+        std::shared_lock<std::shared_mutex> lock(mEntriesMutex);
+        auto it = mEntries.find(key);
+        if (it != mEntries.end())
+            return it->second->manager;
+    }
+
+    auto entry = std::make_shared<Entry>();
+    AppConfig appConfig(mOptions.appName, mOptions.appVersion);
+    entry->config = appConfig.createLicenseSpringConfig(key.productCode);
+    if (!key.hardwareId.empty())
+        entry->config->setHardwareID(key.hardwareId);
+    entry->manager = LicenseManager::create(entry->config, mStorage->ForKey(key.productCode, key.hardwareId));
+
+    const auto telemetryState = std::filesystem::path(mOptions.storageRoot) / pathSafe(key.productCode) / pathSafe(key.hardwareId) / "device_telemetry.json";
+    entry->telemetry = std::make_shared<DeviceTelemetry>(telemetryState.string());
+    entry->telemetry->SetStaticVariable("AppVersion", mOptions.appVersion);
+
+    std::unique_lock<std::shared_mutex> lock(mEntriesMutex);
+    // another thread may have added the same key meanwhile, first one wins
+    auto result = mEntries.emplace(key, entry);
+    return result.first->second->manager;
+}
+
+size_t LicenseRegistry::AddStored(){
+    size_t added = 0;
+    std::error_code ec;
+    for (const auto& product : std::filesystem::directory_iterator(mOptions.storageRoot, ec))
+    {
+        Key key;
+        if (!product.is_directory() || !fromPathSafe(product.path().filename().string(), key.productCode))
+            continue;
+        for (const auto& device : std::filesystem::directory_iterator(product.path(), ec))
+        {
+            if (!std::filesystem::exists(device.path() / "License.key"))
+                continue;
+            if (!fromPathSafe(device.path().filename().string(), key.hardwareId))
+            {
+                PLOG_WARN("Skipping license store with an unknown directory name: " << device.path().string());
+                continue;
+            }
+            Add(key);
+            ++added;
+        }
+    }
+    return added;
+}
+
+std::string LicenseRegistry::StoreDirectory(const Key& key) const{
+    return (std::filesystem::path(mOptions.storageRoot) / pathSafe(key.productCode) / pathSafe(key.hardwareId)).string();
+}
+
+std::shared_ptr<LicenseRegistry::Entry> LicenseRegistry::_entry(const Key& key) const{
+    std::shared_lock<std::shared_mutex> lock(mEntriesMutex);
+    auto it = mEntries.find(key);
+    return it == mEntries.end() ? nullptr : it->second;
+}
+
+LicenseManager::ptr_t LicenseRegistry::Get(const Key& key) const{
+    auto entry = _entry(key);
+    return entry ? entry->manager : nullptr;
+}
+
+std::shared_ptr<std::mutex> LicenseRegistry::UpdateMutex(const Key& key) const{
+    auto entry = _entry(key);
+    // shares ownership of the entry, so the mutex outlives a concurrent Remove
+    return entry ? std::shared_ptr<std::mutex>(entry, &entry->update) : nullptr;
+}
+
+bool LicenseRegistry::Remove(const Key& key){
+    std::unique_lock<std::shared_mutex> lock(mEntriesMutex);
+    return mEntries.erase(key) > 0;
+}
+
+std::vector<LicenseRegistry::Key> LicenseRegistry::Keys() const{
+    std::shared_lock<std::shared_mutex> lock(mEntriesMutex);
+    std::vector<Key> keys;
+    keys.reserve(mEntries.size());
+    for (const auto& entry : mEntries)
+        keys.push_back(entry.first);
+    return keys;
+}
+
+LicenseRegistry::ValidationResult LicenseRegistry::_validate(const Key& key, const std::shared_ptr<Entry>& entry){
+    ValidationResult result;
+    result.key = key;
+    std::lock_guard<std::mutex> lock(entry->update);
+    try
+    {
+        auto license = entry->manager->getCurrentLicense();
+        if (!license)
+        {
+            result.error = "License not installed";
+            return result;
+        }
+        {
+            PRESIEN_SDK_TIMER(LOCAL_CHECK);
+            license->localCheck();
+        }
+        result.valid = license->isValid();
+    }
+    catch (const LicenseSpringException& ex)
+    {
+        result.error = ex.what();
+    }
+    return result;
+}
+
+std::future<LicenseRegistry::ValidationResult> LicenseRegistry::Validate(const Key& key){
+    auto entry = _entry(key);
+    if (!entry)
+    {
+        std::promise<ValidationResult> missing;
+        missing.set_value({key, false, "Unknown product/hardware id"});
+        return missing.get_future();
+    }
+    return mPool.Submit([key, entry]{ return _validate(key, entry); });
+}
+
+std::vector<LicenseRegistry::ValidationResult> LicenseRegistry::ValidateAll(){
+    std::vector<std::future<ValidationResult>> pending;
+    for (const auto& key : Keys())
+        pending.push_back(Validate(key));
+
+    std::vector<ValidationResult> results;
+    results.reserve(pending.size());
+    for (auto& future : pending)
+        results.push_back(future.get());
+    return results;
+}
+
+ProductDetails LicenseRegistry::GetProductDetails(const std::string& productCode){
+    std::shared_future<ProductDetails> request;
+    std::promise<ProductDetails> promise;
+    {
+        std::lock_guard<std::mutex> lock(mProductsMutex);
+        auto cached = mProducts.find(productCode);
+        if (cached != mProducts.end() && std::chrono::steady_clock::now() - cached->second.fetched < mOptions.productDetailsTtl)
+            return cached->second.details;
+
+        // concurrent callers for the same product wait for the one request in flight
+        auto inflight = mProductRequests.find(productCode);
+        if (inflight != mProductRequests.end())
+            request = inflight->second;
+        else
+            mProductRequests[productCode] = promise.get_future().share();
+    }
+    if (request.valid())
+        return request.get();
+
+    std::shared_ptr<Entry> entry;
+    {
+        std::shared_lock<std::shared_mutex> lock(mEntriesMutex);
+        for (const auto& e : mEntries)
+        {
+            if (e.first.productCode == productCode)
+            {
+                entry = e.second;
+                break;
+            }
+        }
+    }
+
+    try
+    {
+        if (!entry)
+            throw ProductNotFoundException("No registry entry for product " + productCode);
+        ProductDetails details;
+        {
+            PRESIEN_SDK_TIMER(GET_PRODUCT_DETAILS);
+            details = entry->manager->getProductDetails(true);
+        }
+        std::lock_guard<std::mutex> lock(mProductsMutex);
+        mProducts[productCode] = {details, std::chrono::steady_clock::now()};
+        mProductRequests.erase(productCode);
+        promise.set_value(details);
+        return details;
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(mProductsMutex);
+        mProductRequests.erase(productCode);
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+size_t LicenseRegistry::FlushTelemetry(){
+    // host readings are the same for every entry, sample once
+    const auto sample = DeviceTelemetry::Collect();
+
+    std::vector<std::shared_ptr<Entry>> entries;
+    {
+        std::shared_lock<std::shared_mutex> lock(mEntriesMutex);
+        for (const auto& entry : mEntries)
+            entries.push_back(entry.second);
+    }
+
+    std::vector<std::future<size_t>> pending;
+    for (const auto& entry : entries)
+    {
+        pending.push_back(mPool.Submit([entry, sample]() -> size_t {
+            entry->telemetry->Update(sample);
+            // sending device variables saves the license, like a refresh or a local check
+            std::lock_guard<std::mutex> lock(entry->update);
+            auto license = entry->manager->getCurrentLicense();
+            return license ? entry->telemetry->Flush(license) : 0;
+        }));
+    }
+
+    size_t sent = 0;
+    for (auto& future : pending)
+    {
+        try
+        {
+            sent += future.get();
+        }
+        catch (const LicenseSpringException& ex)
+        {
+            PLOG_ERROR("Registry telemetry flush failed: " << ex.what());
+        }
+    }
+    return sent;
+}
+
+void LicenseRegistry::StartTelemetry(std::chrono::seconds interval){
+    StopTelemetry();
+    {
+        std::lock_guard<std::mutex> lock(mTelemetryMutex);
+        mStopTelemetry = false;
+    }
+    mTelemetryWorker = std::thread([this, interval]{
+        std::unique_lock<std::mutex> lock(mTelemetryMutex);
+        while (!mTelemetryCv.wait_for(lock, interval, [this]{ return mStopTelemetry; }))
+        {
+            lock.unlock();
+            FlushTelemetry();
+            lock.lock();
+        }
+    });
+}
+
+void LicenseRegistry::StopTelemetry(){
+    {
+        std::lock_guard<std::mutex> lock(mTelemetryMutex);
+        mStopTelemetry = true;
+    }
+    mTelemetryCv.notify_all();
+    if (mTelemetryWorker.joinable())
+        mTelemetryWorker.join();
+}
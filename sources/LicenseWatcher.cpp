@@ -0,0 +1,287 @@
+#include "LicenseWatcher.h"
+#include "PresienLog.h"
+
+#include <LicenseSpring/Exceptions.h>
+
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+using namespace LicenseSpring;
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    std::string boolString(bool value){
+        return value ? "true" : "false";
+    }
+
+    std::string dateString(const tm& value){
+        return TmToString(value, "%Y-%m-%dT%H:%M:%S");
+    }
+
+    // metadata documents and fields only by hash, a change is enough for MetadataIndex
+    std::string metadataHash(const License::ptr_t& license){
+        std::string data = license->metadata();
+        data += '\0';
+        data += license->productDetails().metadata();
+        for (const auto& field : license->customFields())
+            data += '\0' + field.fieldName() + '=' + field.fieldValue();
+        data += '\0';
+        for (const auto& field : license->userData())
+            data += '\0' + field.fieldName() + '=' + field.fieldValue();
+        std::ostringstream os;
+        os << std::hex << std::hash<std::string>()(data);
+        return os.str();
+    }
+}
+
+LicenseWatcher::LicenseWatcher(LicenseManager::ptr_t manager, std::chrono::milliseconds settle)
+    :mManager(std::move(manager)), mSettle(settle){
+    const std::filesystem::path path(mManager->licenseFilePath());
+    mDirectory = path.parent_path().string();
+    mFileName = path.filename().string();
+    mKnownContent = _fileContent();
+    try
+    {
+        mState = Snapshot(mManager->getCurrentLicense());
+    }
+    catch (const LicenseSpringException& ex)
+    {
+        PLOG_WARN("License watcher starts without a readable license: " << ex.what());
+    }
+}
+
+LicenseWatcher::~LicenseWatcher(){
+    Stop();
+}
+
+LicenseWatcher::State LicenseWatcher::Snapshot(License::ptr_t license){
+    State state;
+    if (!license)
+        return state;
+    state["key"] = license->key();
+    state["active"] = boolString(license->isActive());
+    state["enabled"] = boolString(license->isEnabled());
+    state["expired"] = boolString(license->isExpired());
+    state["valid"] = boolString(license->isValid());
+    state["trial"] = boolString(license->isTrial());
+    state["validity_period"] = dateString(license->validityPeriod());
+    state["total_consumption"] = std::to_string(license->totalConsumption());
+    state["max_consumption"] = std::to_string(license->maxConsumption());
+    state["metadata"] = metadataHash(license);
+    for (const auto& feature : license->features())
+    {
+        const auto prefix = "feature." + feature.code() + ".";
+        state[prefix + "expired"] = boolString(feature.isExpired());
+        state[prefix + "expiry_date"] = dateString(feature.expiryDate());
+        if (feature.featureType() == FeatureTypeConsumption)
+        {
+            state[prefix + "total_consumption"] = std::to_string(feature.totalConsumption());
+            state[prefix + "max_consumption"] = std::to_string(feature.maxConsumption());
+        }
+        if (feature.isFloating() || feature.isOfflineFloating())
+            state[prefix + "floating_users"] = std::to_string(feature.floatingUsers());
+    }
+    return state;
+}
+
+std::vector<LicenseWatcher::Change> LicenseWatcher::Diff(const State& before, const State& after){
+    // both maps are ordered, one merge pass
+    std::vector<Change> changes;
+    auto b = before.begin();
+    auto a = after.begin();
+    while (b != before.end() || a != after.end())
+    {
+        if (a == after.end() || (b != before.end() && b->first < a->first))
+        {
+            changes.push_back({b->first, b->second, std::string()});
+            ++b;
+        }
+        else if (b == before.end() || a->first < b->first)
+        {
+            changes.push_back({a->first, std::string(), a->second});
+            ++a;
+        }
+        else
+        {
+            if (a->second != b->second)
+                changes.push_back({a->first, b->second, a->second});
+            ++a;
+            ++b;
+        }
+    }
+    return changes;
+}
+
+size_t LicenseWatcher::Subscribe(const std::string& prefix, Callback callback){
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSubscribers[mNextId] = {prefix, std::move(callback)};
+    return mNextId++;
+}
+
+void LicenseWatcher::Unsubscribe(size_t id){
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSubscribers.erase(id);
+}
+
+size_t LicenseWatcher::_fileContent() const{
+    std::ifstream is(std::filesystem::path(mDirectory) / mFileName, std::ios::binary);
+    std::stringstream ss;
+    if (is.good())
+        ss << is.rdbuf();
+    return std::hash<std::string>()(ss.str());
+}
+
+void LicenseWatcher::Acknowledge(){
+    State state;
+    try
+    {
+        state = Snapshot(mManager->getCurrentLicense());
+    }
+    catch (const LicenseSpringException&)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (state == mState)
+        return;
+    mState = std::move(state);
+    mKnownContent = _fileContent();
+}
+
+std::vector<LicenseWatcher::Change> LicenseWatcher::Reload(){
+    const auto content = _fileContent();
+    State state;
+    try
+    {
+        state = Snapshot(mManager->reloadLicense());
+    }
+    catch (const LicenseSpringException& ex)
+    {
+        // a half written file is picked up again by the close of the writer
+        PLOG_WARN("License reload failed: " << ex.what());
+        return {};
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto changes = Diff(mState, state);
+    mState = std::move(state);
+    mKnownContent = content;
+    if (changes.empty())
+        return changes;
+
+    PLOG_INFO("License file changed, " << changes.size() << " field(s) differ");
+    for (const auto& subscriber : mSubscribers)
+    {
+        std::vector<Change> matching;
+        for (const auto& change : changes)
+        {
+            if (change.field.compare(0, subscriber.second.prefix.size(), subscriber.second.prefix) == 0)
+                matching.push_back(change);
+        }
+        if (!matching.empty())
+            subscriber.second.callback(matching);
+    }
+    return changes;
+}
+
+std::vector<LicenseWatcher::Change> LicenseWatcher::ReloadIfChanged(){
+    if (!mChanged.exchange(false))
+        return {};
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (_fileContent() == mKnownContent)
+            return {};
+    }
+    return Reload();
+}
+
+bool LicenseWatcher::Start(){
+    Stop();
+    mInotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    mStopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    // the directory, not the file: writers replace the file by rename
+    if (mInotifyFd < 0 || mStopFd < 0 ||
+        inotify_add_watch(mInotifyFd, mDirectory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE) < 0)
+    {
+        PLOG_ERROR("Cannot watch license directory " << mDirectory);
+        Stop();
+        return false;
+    }
+    mWatcher = std::thread([this]{ _watch(); });
+    return true;
+}
+
+void LicenseWatcher::Stop(){
+    if (mStopFd >= 0)
+    {
+        uint64_t one = 1;
+        if (write(mStopFd, &one, sizeof(one)) < 0)
+            PLOG_WARN("Cannot signal license watcher");
+    }
+    if (mWatcher.joinable())
+        mWatcher.join();
+    if (mInotifyFd >= 0)
+        close(mInotifyFd);
+    if (mStopFd >= 0)
+        close(mStopFd);
+    mInotifyFd = mStopFd = -1;
+}
+
+void LicenseWatcher::_watch(){
+    alignas(inotify_event) char buffer[4096];
+    pollfd fds[2] = {{mInotifyFd, POLLIN, 0}, {mStopFd, POLLIN, 0}};
+    bool pending = false;
+    for (;;)
+    {
+        // once the license file was touched, wait for the burst to settle
+        const int timeout = pending ? static_cast<int>(mSettle.count()) : -1;
+        const int ready = poll(fds, 2, timeout);
+        if (ready < 0 && errno != EINTR)
+            return;
+        if (fds[1].revents & POLLIN)
+            return;
+        if (ready == 0 && pending)
+        {
+            pending = false;
+            if (mDeferred)
+            {
+                mChanged = true;
+                continue;
+            }
+            std::unique_lock<std::mutex> reloadLock;
+            if (mReloadMutex)
+                reloadLock = std::unique_lock<std::mutex>(*mReloadMutex);
+            bool known;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                known = _fileContent() == mKnownContent;
+            }
+            // our own save, already in memory
+            if (!known)
+                Reload();
+            continue;
+        }
+        if (!(fds[0].revents & POLLIN))
+            continue;
+        ssize_t length;
+        while ((length = read(mInotifyFd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* p = buffer; p < buffer + length;)
+            {
+                auto* event = reinterpret_cast<inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+                if (event->len > 0 && mFileName == event->name)
+                    pending = true;
+            }
+        }
+    }
+}
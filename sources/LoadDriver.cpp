@@ -0,0 +1,210 @@
+// Load and latency test of the SampleBase/PresienLicense wrappers against MockBackend.
+// usage: presien-lic-loadtest [key=value ...]
+//   threads=8 iterations=1000 op=local|check|activate|mixed
+//   latency=lognormal:20:0.5 local_latency=none   (see LatencyDistribution::Parse)
+//   timeout=0.0 tamper=0.0 maxfloat=0.0            (error injection rates, 0..1)
+//   seats=0 floating=0 features=0 seed=1 metrics=<prometheus textfile>
+// Built with -DBENCHMARK_ALLOCATIONS=ON it also reports allocations per op and per wrapper
+// call, VBSALLOCSITES=1 adds the top allocation call sites.
+// Every thread is one device with its own license; op=activate activates a new one per iteration.
+
+#include "AllocationCounter.h"
+#include "MockBackend.h"
+#include "LicenseMetrics.h"
+#include "PresienLog.h"
+#include "SampleBase.h"
+
+#include <LicenseSpring/Exceptions.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <thread>
+
+using namespace LicenseSpring;
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    // Only the wrapper methods are exercised, run modes are not needed
+    class LoadSample : public SampleBase
+    {
+    public:
+        void runOnline( bool ) override {}
+        void runOffline( bool ) override {}
+    };
+
+    struct ThreadResult{
+        std::vector<double> latencyUs;
+        std::map<std::string, uint64_t> errors;
+        AllocationStats allocations;
+    };
+
+    double percentile(const std::vector<double>& sorted, double p){
+        if (sorted.empty())
+            return 0;
+        auto index = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    std::string errorName(const LicenseSpringException& ex){
+        if (dynamic_cast<const NetworkTimeoutException*>(&ex))
+            return "NetworkTimeout";
+        if (dynamic_cast<const ClockTamperedException*>(&ex))
+            return "ClockTampered";
+        if (dynamic_cast<const MaxFloatingReachedException*>(&ex))
+            return "MaxFloatingReached";
+        return "LicenseSpringException(" + std::to_string(static_cast<int>(ex.getCode())) + ")";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::map<std::string, std::string> args = {
+        {"threads", "8"}, {"iterations", "1000"}, {"op", "local"},
+        {"latency", "none"}, {"local_latency", "none"},
+        {"timeout", "0"}, {"tamper", "0"}, {"maxfloat", "0"},
+        {"seats", "0"}, {"floating", "0"}, {"features", "0"}, {"seed", "1"}, {"metrics", ""}
+    };
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if (eq == std::string::npos || !args.count(arg.substr(0, eq)))
+        {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            return -1;
+        }
+        args[arg.substr(0, eq)] = arg.substr(eq + 1);
+    }
+
+    // wrappers log every step, keep the logger out of the measurement
+    Logger::GetInstance().SetLevel(LogLevel::ERROR);
+
+    MockBackendOptions options;
+    options.networkLatency = LatencyDistribution::Parse(args["latency"]);
+    options.localLatency = LatencyDistribution::Parse(args["local_latency"]);
+    options.networkTimeoutRate = std::stod(args["timeout"]);
+    options.clockTamperedRate = std::stod(args["tamper"]);
+    options.maxFloatingRate = std::stod(args["maxfloat"]);
+    options.seats = static_cast<uint32_t>(std::stoul(args["seats"]));
+    options.floatingLicense = args["floating"] == "1";
+    options.seed = std::stoull(args["seed"]);
+    for (int i = 0; i < std::stoi(args["features"]); ++i)
+        options.floatingFeatures.push_back("floating-feature-" + std::to_string(i + 1));
+    auto backend = MockBackend::Create(options);
+
+    const int threads = std::stoi(args["threads"]);
+    const int iterations = std::stoi(args["iterations"]);
+    const std::string op = args["op"];
+    if (op != "local" && op != "check" && op != "activate" && op != "mixed")
+    {
+        std::cout << "Unknown op: " << op << std::endl;
+        return -1;
+    }
+
+    std::vector<ThreadResult> results(static_cast<size_t>(threads));
+    std::vector<std::thread> workers;
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]{
+            using clock = std::chrono::steady_clock;
+            LoadSample sample;
+            auto& result = results[static_cast<size_t>(t)];
+            result.latencyUs.reserve(static_cast<size_t>(iterations));
+            const auto licenseId = LicenseID::fromKey("LOAD-TEST-" + std::to_string(t));
+
+            License::ptr_t license;
+            for (int i = 0; i < iterations; ++i)
+            {
+                const auto allocationsBefore = AllocationCounter::Thread();
+                const auto begin = clock::now();
+                try
+                {
+                    if (op == "activate" || !license)
+                    {
+                        AllocationScope scope("ActivateLicense");
+                        license = backend->ActivateLicense(licenseId);
+                    }
+                    if (op == "local" || op == "mixed")
+                    {
+                        AllocationScope scope("checkLicenseLocal");
+                        sample.checkLicenseLocal(license);
+                    }
+                    if (op == "check" || (op == "mixed" && i % 10 == 0))
+                    {
+                        AllocationScope scope("updateAndCheckLicense");
+                        sample.updateAndCheckLicense(license);
+                    }
+                    if (op == "activate")
+                        license.reset();
+                }
+                catch (const LicenseSpringException& ex)
+                {
+                    ++result.errors[errorName(ex)];
+                    if (op == "activate")
+                        license.reset();
+                }
+                result.latencyUs.push_back(std::chrono::duration<double, std::micro>(clock::now() - begin).count());
+                result.allocations += AllocationCounter::Thread() - allocationsBefore;
+            }
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> latencies;
+    std::map<std::string, uint64_t> errors;
+    AllocationStats allocations;
+    for (auto& result : results)
+    {
+        allocations += result.allocations;
+        latencies.insert(latencies.end(), result.latencyUs.begin(), result.latencyUs.end());
+        for (const auto& e : result.errors)
+            errors[e.first] += e.second;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << "op=" << op << " threads=" << threads << " iterations=" << iterations
+              << " latency=" << args["latency"] << std::endl;
+    std::cout << std::fixed << std::setprecision(1)
+              << "throughput " << static_cast<double>(latencies.size()) / elapsed << " ops/s"
+              << " in " << std::setprecision(3) << elapsed << " s" << std::endl;
+    std::cout << std::setprecision(1)
+              << "latency us: p50 " << percentile(latencies, 50)
+              << ", p90 " << percentile(latencies, 90)
+              << ", p99 " << percentile(latencies, 99)
+              << ", p99.9 " << percentile(latencies, 99.9)
+              << ", max " << (latencies.empty() ? 0 : latencies.back()) << std::endl;
+    for (const auto& e : errors)
+        std::cout << "errors " << e.first << ": " << e.second << std::endl;
+    std::cout << "seats in use at exit: " << backend->SeatsInUse() << std::endl;
+
+    if (AllocationCounter::Installed() && !latencies.empty())
+    {
+        const auto ops = static_cast<double>(latencies.size());
+        std::cout << "allocations per op: " << static_cast<double>(allocations.allocations) / ops
+                  << " (" << static_cast<double>(allocations.bytes) / ops << " bytes)"
+                  << ", frees " << static_cast<double>(allocations.frees) / ops << std::endl;
+        for (const auto& scope : AllocationScope::AllTotals())
+        {
+            const auto calls = static_cast<double>(scope.second.calls);
+            std::cout << "allocations per " << scope.first << ": " << static_cast<double>(scope.second.stats.allocations) / calls
+                      << " (" << static_cast<double>(scope.second.stats.bytes) / calls << " bytes)" << std::endl;
+        }
+        if (AllocationCounter::SitesEnabled())
+        {
+            std::cout << "top allocation sites:" << std::endl;
+            for (const auto& site : AllocationCounter::TopSites(10))
+                std::cout << "  " << site.allocations << " allocs, " << site.bytes << " bytes: " << site.frames << std::endl;
+        }
+    }
+
+    if (!args["metrics"].empty())
+        LicenseMetrics::GetInstance().WriteTextfile(args["metrics"]);
+    return 0;
+}
@@ -0,0 +1,275 @@
+#include "MemoryGovernor.h"
+#include "PresienLog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <malloc.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    constexpr size_t MIB = 1024 * 1024;
+    // 150 ms of stalled tasks within 2 s, also accepted for unprivileged triggers
+    constexpr const char* PSI_TRIGGER = "some 150000 2000000";
+    constexpr auto MIN_RELEASE_INTERVAL = std::chrono::seconds(1);
+    constexpr auto MAX_BUDGET_RELEASE_INTERVAL = std::chrono::seconds(64);
+    // RSS growth over the last release that counts as new memory to release
+    constexpr size_t RSS_GROWTH = 4 * MIB;
+
+    std::string cgroupDirectory(){
+        // cgroup v2: a single "0::/path" line
+        std::ifstream is("/proc/self/cgroup");
+        std::string line;
+        while (std::getline(is, line))
+        {
+            if (line.compare(0, 3, "0::") == 0)
+                return "/sys/fs/cgroup" + line.substr(3);
+        }
+        return std::string();
+    }
+
+    int openPressureTrigger(const std::string& path){
+        int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+            return -1;
+        if (write(fd, PSI_TRIGGER, strlen(PSI_TRIGGER) + 1) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+}
+
+MemoryGovernor::~MemoryGovernor(){
+    Stop();
+}
+
+void MemoryGovernor::ConfigureFromEnvironment(){
+    const char* lowMemory = std::getenv("VBSLOWMEM");
+    mLowMemory = lowMemory != nullptr && std::string(lowMemory) == "1";
+    if (const char* budget = std::getenv("VBSRSSBUDGETMB"))
+    {
+        char* end = nullptr;
+        long megabytes = std::strtol(budget, &end, 10);
+        if (end == budget || megabytes < 0)
+            PLOG_WARN("Ignoring invalid VBSRSSBUDGETMB=" << budget);
+        else
+            mBudget = static_cast<size_t>(megabytes) * MIB;
+    }
+    if (!mLowMemory)
+        return;
+#ifdef __GLIBC__
+    // one arena instead of one per worker thread, transient buffers over 64 KiB
+    // (JSON documents, package chunks) are mmapped and unmapped again on free
+    mallopt(M_ARENA_MAX, 1);
+    mallopt(M_MMAP_THRESHOLD, 64 * 1024);
+    mallopt(M_TRIM_THRESHOLD, 128 * 1024);
+#endif
+    PLOG_INFO("Low memory mode, RSS budget " << (mBudget ? std::to_string(mBudget / MIB) + " MiB" : std::string("unlimited")));
+}
+
+size_t MemoryGovernor::Register(const std::string& name, Releaser releaser){
+    std::lock_guard<std::mutex> lock(mMutex);
+    mReleasers[mNextId] = {name, std::move(releaser)};
+    return mNextId++;
+}
+
+void MemoryGovernor::Unregister(size_t id){
+    std::lock_guard<std::mutex> releaseLock(mReleaseMutex);
+    std::lock_guard<std::mutex> lock(mMutex);
+    mReleasers.erase(id);
+}
+
+void MemoryGovernor::Release(const std::string& reason){
+    std::lock_guard<std::mutex> releaseLock(mReleaseMutex);
+    std::vector<std::pair<std::string, Releaser>> releasers;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const auto& releaser : mReleasers)
+            releasers.push_back(releaser.second);
+    }
+    const auto before = ReadRss();
+    for (const auto& releaser : releasers)
+    {
+        try
+        {
+            releaser.second();
+        }
+        catch (const std::exception& ex)
+        {
+            PLOG_WARN("Memory releaser " << releaser.first << " failed: " << ex.what());
+        }
+    }
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+    ++mReleases;
+    PLOG_INFO("Memory released (" << reason << "): RSS " << before / MIB << " -> " << ReadRss() / MIB << " MiB");
+}
+
+size_t MemoryGovernor::ReadRss(){
+    std::ifstream is("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    is >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+size_t MemoryGovernor::ReadPeakRss(){
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;     // KiB on Linux
+}
+
+MemoryGovernor::Usage MemoryGovernor::Current() const{
+    Usage usage;
+    usage.rss = ReadRss();
+    usage.peakRss = ReadPeakRss();
+    usage.budget = mBudget;
+    usage.pressureEvents = mPressureEvents.load();
+    usage.releases = mReleases.load();
+    return usage;
+}
+
+void MemoryGovernor::LogPeak() const{
+    const auto peak = ReadPeakRss();
+    PLOG_INFO("Peak RSS " << peak / MIB << " MiB" << (mBudget ? ", budget " + std::to_string(mBudget / MIB) + " MiB" : std::string()));
+    if (mBudget && peak > mBudget)
+        PLOG_WARN("Peak RSS exceeded the budget by " << (peak - mBudget) / MIB << " MiB");
+}
+
+bool MemoryGovernor::_eventsIncreased(){
+    char buffer[512];
+    const auto length = pread(mEventsFd, buffer, sizeof(buffer) - 1, 0);
+    if (length <= 0)
+        return false;
+    buffer[length] = '\0';
+    std::istringstream is(buffer);
+    std::string name;
+    long long count = 0;
+    bool increased = false;
+    while (is >> name >> count)
+    {
+        // "low" only means reclaim below memory.low, the others mean we are in trouble
+        if (name == "low")
+            continue;
+        auto& last = mEventCounts[name];
+        increased = increased || count > last;
+        last = count;
+    }
+    return increased;
+}
+
+bool MemoryGovernor::Start(){
+    Stop();
+    const auto cgroup = cgroupDirectory();
+    if (!cgroup.empty())
+    {
+        mPressureFd = openPressureTrigger(cgroup + "/memory.pressure");
+        mEventsFd = open((cgroup + "/memory.events").c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    if (mPressureFd < 0)
+        mPressureFd = openPressureTrigger("/proc/pressure/memory");
+    if (mEventsFd >= 0)
+        _eventsIncreased();     // baseline
+
+    if (mPressureFd < 0 && mEventsFd < 0 && mBudget == 0)
+    {
+        PLOG_WARN("No memory pressure source and no RSS budget, memory watcher not started");
+        return false;
+    }
+    mStopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mStopFd < 0)
+    {
+        Stop();
+        return false;
+    }
+    PLOG_INFO("Memory watcher: PSI " << (mPressureFd >= 0 ? "on" : "off") << ", memory.events " << (mEventsFd >= 0 ? "on" : "off"));
+    mWatcher = std::thread([this]{ _watch(); });
+    return true;
+}
+
+void MemoryGovernor::Stop(){
+    if (mStopFd >= 0)
+    {
+        uint64_t one = 1;
+        if (write(mStopFd, &one, sizeof(one)) < 0)
+            PLOG_WARN("Cannot signal memory watcher");
+    }
+    if (mWatcher.joinable())
+        mWatcher.join();
+    for (int* fd : {&mPressureFd, &mEventsFd, &mStopFd})
+    {
+        if (*fd >= 0)
+            close(*fd);
+        *fd = -1;
+    }
+}
+
+void MemoryGovernor::_watch(){
+    pollfd fds[3] = {{mStopFd, POLLIN, 0}, {mPressureFd, POLLPRI, 0}, {mEventsFd, POLLPRI, 0}};
+    // the budget is checked once a second, pressure wakes us up right away
+    const int timeout = mBudget ? 1000 : -1;
+    auto lastRelease = std::chrono::steady_clock::now() - MIN_RELEASE_INTERVAL;
+    // RSS after the last budget release; without growth above it releasing again frees
+    // nothing new, so the interval doubles until RSS grows or drops under the budget
+    size_t releasedRss = 0;
+    auto budgetInterval = MIN_RELEASE_INTERVAL;
+    for (;;)
+    {
+        if (poll(fds, 3, timeout) < 0 && errno != EINTR)
+            return;
+        if (fds[0].revents & POLLIN)
+            return;
+
+        std::string reason;
+        if (fds[1].revents & POLLERR)
+            fds[1].fd = -1;         // the monitored cgroup is gone
+        else if (fds[1].revents & POLLPRI)
+            reason = "memory pressure";
+        if ((fds[2].revents & POLLPRI) && _eventsIncreased())
+            reason = "cgroup memory.events";
+        const auto now = std::chrono::steady_clock::now();
+        if (!reason.empty())
+            ++mPressureEvents;
+        else if (mBudget)
+        {
+            const auto rss = ReadRss();
+            if (rss <= mBudget)
+            {
+                releasedRss = 0;
+                budgetInterval = MIN_RELEASE_INTERVAL;
+            }
+            else if (rss > releasedRss + RSS_GROWTH)
+                reason = "RSS over budget";
+            else if (now - lastRelease >= budgetInterval)
+            {
+                reason = "RSS over budget, no growth";
+                budgetInterval = std::min(budgetInterval * 2, MAX_BUDGET_RELEASE_INTERVAL);
+            }
+        }
+
+        if (!reason.empty() && now - lastRelease >= MIN_RELEASE_INTERVAL)
+        {
+            lastRelease = now;
+            Release(reason);
+            if (mBudget)
+                releasedRss = ReadRss();
+        }
+    }
+}
@@ -0,0 +1,243 @@
+#include "MetadataIndex.h"
+#include "LicenseWatcher.h"
+#include "PresienLog.h"
+
+#include <LicenseSpring/Exceptions.h>
+
+#include <cerrno>
+#include <cstdlib>
+
+#include <json/json.hpp>
+
+using namespace LicenseSpring;
+using namespace PRESIEN::BlindSight;
+using json = nlohmann::json;
+
+namespace {
+
+    using Document = std::unordered_map<std::string, MetadataValue>;
+
+    std::string escapeToken(const std::string& token){
+        std::string escaped;
+        escaped.reserve(token.size());
+        for (char c : token)
+        {
+            if (c == '~')
+                escaped += "~0";
+            else if (c == '/')
+                escaped += "~1";
+            else
+                escaped += c;
+        }
+        return escaped;
+    }
+}
+
+std::string MetadataValue::String(const std::string& fallback) const{
+    return mType == Type::NUL || mType == Type::OBJECT || mType == Type::ARRAY ? fallback : mText;
+}
+
+int64_t MetadataValue::Int(int64_t fallback) const{
+    return mHasInt ? mInt : fallback;
+}
+
+double MetadataValue::Double(double fallback) const{
+    return mHasDouble ? mDouble : fallback;
+}
+
+bool MetadataValue::Bool(bool fallback) const{
+    return mHasBool ? mBool : fallback;
+}
+
+const MetadataValue* MetadataIndex::Snapshot::Find(Source source, const std::string& key) const{
+    const auto& document = mDocuments[static_cast<size_t>(source)];
+    const auto it = key.empty() || key[0] == '/' ? document.find(key) : document.find(PointerOf(key));
+    return it == document.end() ? nullptr : &it->second;
+}
+
+std::string MetadataIndex::Snapshot::String(Source source, const std::string& key, const std::string& fallback) const{
+    const auto* value = Find(source, key);
+    return value ? value->String(fallback) : fallback;
+}
+
+int64_t MetadataIndex::Snapshot::Int(Source source, const std::string& key, int64_t fallback) const{
+    const auto* value = Find(source, key);
+    return value ? value->Int(fallback) : fallback;
+}
+
+double MetadataIndex::Snapshot::Double(Source source, const std::string& key, double fallback) const{
+    const auto* value = Find(source, key);
+    return value ? value->Double(fallback) : fallback;
+}
+
+bool MetadataIndex::Snapshot::Bool(Source source, const std::string& key, bool fallback) const{
+    const auto* value = Find(source, key);
+    return value ? value->Bool(fallback) : fallback;
+}
+
+std::string MetadataIndex::PointerOf(const std::string& key){
+    return "/" + escapeToken(key);
+}
+
+namespace PRESIEN::BlindSight{
+
+    // fills MetadataValue, which is read-only for everyone else
+    struct MetadataIndexBuilder{
+        static MetadataValue fromText(const std::string& text){
+            MetadataValue value;
+            value.mType = MetadataValue::Type::STRING;
+            value.mText = text;
+            if (text == "true" || text == "false")
+            {
+                value.mHasBool = true;
+                value.mBool = text == "true";
+            }
+            else if (!text.empty())
+            {
+                char* end = nullptr;
+                errno = 0;
+                const long long integer = std::strtoll(text.c_str(), &end, 10);
+                if (*end == '\0' && errno == 0)
+                {
+                    value.mHasInt = true;
+                    value.mInt = integer;
+                }
+                const double number = std::strtod(text.c_str(), &end);
+                if (*end == '\0')
+                {
+                    value.mHasDouble = true;
+                    value.mDouble = number;
+                }
+            }
+            return value;
+        }
+
+        static void add(Document& document, const std::string& pointer, const json& node){
+            MetadataValue value;
+            switch (node.type())
+            {
+                case json::value_t::object:
+                    value.mType = MetadataValue::Type::OBJECT;
+                    value.mSize = node.size();
+                    for (const auto& child : node.items())
+                        add(document, pointer + "/" + escapeToken(child.key()), child.value());
+                    break;
+                case json::value_t::array:
+                    value.mType = MetadataValue::Type::ARRAY;
+                    value.mSize = node.size();
+                    for (size_t i = 0; i < node.size(); ++i)
+                        add(document, pointer + "/" + std::to_string(i), node[i]);
+                    break;
+                case json::value_t::string:
+                    value = fromText(node.get<std::string>());
+                    break;
+                case json::value_t::boolean:
+                    value.mType = MetadataValue::Type::BOOLEAN;
+                    value.mHasBool = true;
+                    value.mBool = node.get<bool>();
+                    value.mText = node.dump();
+                    break;
+                case json::value_t::number_integer:
+                case json::value_t::number_unsigned:
+                    value.mType = MetadataValue::Type::INTEGER;
+                    value.mHasInt = value.mHasDouble = true;
+                    value.mInt = node.get<int64_t>();
+                    value.mDouble = node.get<double>();
+                    value.mText = node.dump();
+                    break;
+                case json::value_t::number_float:
+                    value.mType = MetadataValue::Type::NUMBER;
+                    value.mHasDouble = true;
+                    value.mDouble = node.get<double>();
+                    value.mText = node.dump();
+                    break;
+                default:
+                    break;
+            }
+            document.emplace(pointer, std::move(value));
+        }
+
+        static void addJson(Document& document, const std::string& text, const char* name){
+            if (text.empty())
+                return;
+            try
+            {
+                add(document, "", json::parse(text));
+            }
+            catch (const json::exception& ex)
+            {
+                PLOG_WARN("Cannot index " << name << " metadata: " << ex.what());
+            }
+        }
+
+        static void addFields(Document& document, const std::vector<CustomField>& fields){
+            if (fields.empty())
+                return;
+            MetadataValue root;
+            root.mType = MetadataValue::Type::OBJECT;
+            root.mSize = fields.size();
+            document.emplace("", std::move(root));
+            for (const auto& field : fields)
+                document.emplace(MetadataIndex::PointerOf(field.fieldName()), fromText(field.fieldValue()));
+        }
+    };
+};
+
+MetadataIndex::SnapshotPtr MetadataIndex::Build(License::ptr_t license, uint64_t revision){
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->mRevision = revision;
+    snapshot->mLicense = license;
+    if (!license)
+        return snapshot;
+    auto& documents = snapshot->mDocuments;
+    MetadataIndexBuilder::addJson(documents[static_cast<size_t>(Source::LICENSE_METADATA)], license->metadata(), "license");
+    MetadataIndexBuilder::addJson(documents[static_cast<size_t>(Source::PRODUCT_METADATA)], license->productDetails().metadata(), "product");
+    MetadataIndexBuilder::addFields(documents[static_cast<size_t>(Source::CUSTOM_FIELDS)], license->customFields());
+    MetadataIndexBuilder::addFields(documents[static_cast<size_t>(Source::USER_DATA)], license->userData());
+    return snapshot;
+}
+
+MetadataIndex::MetadataIndex(LicenseManager::ptr_t manager)
+    :mManager(std::move(manager)){
+}
+
+MetadataIndex::~MetadataIndex(){
+    if (mWatcher)
+        mWatcher->Unsubscribe(mSubscription);
+}
+
+MetadataIndex::SnapshotPtr MetadataIndex::Current(){
+    License::ptr_t license;
+    try
+    {
+        license = mManager->getCurrentLicense();
+    }
+    catch (const LicenseSpringException& ex)
+    {
+        PLOG_WARN("Metadata index without a readable license: " << ex.what());
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mSnapshot && !mStale && mSnapshot->mLicense.lock() == license)
+        return mSnapshot;
+    mSnapshot = Build(license, ++mRevision);
+    mStale = false;
+    return mSnapshot;
+}
+
+void MetadataIndex::Invalidate(){
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStale = true;
+}
+
+void MetadataIndex::ReleaseMemory(){
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSnapshot.reset();
+    mStale = true;
+}
+
+void MetadataIndex::Attach(LicenseWatcher& watcher){
+    if (mWatcher)
+        mWatcher->Unsubscribe(mSubscription);
+    mWatcher = &watcher;
+    mSubscription = watcher.Subscribe("", [this](const std::vector<LicenseWatcher::Change>&){ Invalidate(); });
+}
@@ -0,0 +1,342 @@
+#include "MockBackend.h"
+
+#include <LicenseSpring/Exceptions.h>
+
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
+using namespace LicenseSpring;
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    std::vector<std::string> split(const std::string& value, char delimiter){
+        std::vector<std::string> parts;
+        std::istringstream is(value);
+        std::string part;
+        while (std::getline(is, part, delimiter))
+            parts.push_back(part);
+        return parts;
+    }
+
+    LicenseFeature makeFeature(const std::string& code, LSFeatureType type, bool isFloating, int32_t seats){
+        const tm empty{};
+        return LicenseFeature(code, code, type, 0, 0, 0, empty, false, 0, false, true, ConsumptionPeriod(), "{}",
+                              isFloating, false, 30, seats, 0, empty, empty);
+    }
+}
+
+LatencyDistribution LatencyDistribution::Parse(const std::string& spec){
+    LatencyDistribution d;
+    auto parts = split(spec, ':');
+    if (parts.empty() || parts[0] == "none")
+        return d;
+
+    if (parts[0] == "fixed")
+        d.kind = Kind::FIXED;
+    else if (parts[0] == "uniform")
+        d.kind = Kind::UNIFORM;
+    else if (parts[0] == "lognormal")
+        d.kind = Kind::LOGNORMAL;
+    else
+        throw std::invalid_argument("Unknown latency distribution: " + spec);
+
+    if (parts.size() > 1)
+        d.a = std::stod(parts[1]);
+    if (parts.size() > 2)
+        d.b = std::stod(parts[2]);
+    return d;
+}
+
+std::chrono::microseconds LatencyDistribution::Sample(std::mt19937_64& rng) const{
+    double ms = 0;
+    switch (kind)
+    {
+        case Kind::FIXED:
+            ms = a;
+            break;
+        case Kind::UNIFORM:
+            ms = std::uniform_real_distribution<double>(a, std::max(a, b))(rng);
+            break;
+        case Kind::LOGNORMAL:
+            // median of lognormal is exp(mu)
+            ms = std::lognormal_distribution<double>(std::log(std::max(a, 0.001)), b)(rng);
+            break;
+        default:
+            break;
+    }
+    return std::chrono::microseconds(static_cast<int64_t>(ms * 1000));
+}
+
+std::mt19937_64& MockBackend::_rng(){
+    // one engine per thread and backend: no lock on the hot path, reproducible per thread index
+    thread_local const MockBackend* owner = nullptr;
+    thread_local std::mt19937_64 rng;
+    if (owner != this)
+    {
+        owner = this;
+        rng.seed(mOptions.seed + mThreadCounter.fetch_add(1));
+    }
+    return rng;
+}
+
+bool MockBackend::_chance(double rate){
+    if (rate <= 0)
+        return false;
+    return std::uniform_real_distribution<double>(0, 1)(_rng()) < rate;
+}
+
+void MockBackend::NetworkCall(){
+    auto latency = mOptions.networkLatency.Sample(_rng());
+    if (_chance(mOptions.networkTimeoutRate))
+    {
+        // a timed out request costs at least as much as a successful one
+        std::this_thread::sleep_for(latency);
+        throw NetworkTimeoutException("Mock backend: network timeout");
+    }
+    if (latency.count() > 0)
+        std::this_thread::sleep_for(latency);
+}
+
+void MockBackend::LocalCall(){
+    auto latency = mOptions.localLatency.Sample(_rng());
+    if (latency.count() > 0)
+        std::this_thread::sleep_for(latency);
+    if (_chance(mOptions.clockTamperedRate))
+        throw ClockTamperedException("Mock backend: clock tampering detected");
+}
+
+void MockBackend::AcquireSeat(){
+    if (_chance(mOptions.maxFloatingRate))
+        throw MaxFloatingReachedException("Mock backend: injected max floating reached");
+    if (mOptions.seats == 0)
+    {
+        mSeatsInUse.fetch_add(1);
+        return;
+    }
+    auto used = mSeatsInUse.load();
+    do
+    {
+        if (used >= mOptions.seats)
+            throw MaxFloatingReachedException("Mock backend: all " + std::to_string(mOptions.seats) + " seats in use");
+    }
+    while (!mSeatsInUse.compare_exchange_weak(used, used + 1));
+}
+
+void MockBackend::ReleaseSeat(){
+    mSeatsInUse.fetch_sub(1);
+}
+
+License::ptr_t MockBackend::ActivateLicense(const LicenseID& licenseId){
+    NetworkCall();
+    auto license = std::make_shared<MockLicense>(shared_from_this(), licenseId);
+    if (mOptions.floatingLicense)
+        license->registerFloatingLicense();
+    return license;
+}
+
+MockLicense::MockLicense(MockBackend::ptr_t backend, const LicenseID& licenseId):mBackend(std::move(backend)), mId(licenseId){
+    const auto& options = mBackend->Options();
+    for (const auto& code : options.floatingFeatures)
+        mFeatures.push_back(makeFeature(code, FeatureTypeActivation, true, static_cast<int32_t>(options.seats)));
+    for (const auto& code : options.consumptionFeatures)
+        mFeatures.push_back(makeFeature(code, FeatureTypeConsumption, false, 0));
+}
+
+MockLicense::~MockLicense(){
+    // auto release, as the SDK does for floating licenses
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mHoldsSeat)
+        mBackend->ReleaseSeat();
+    for (size_t i = 0; i < mRegisteredFeatures.size(); ++i)
+        mBackend->ReleaseSeat();
+}
+
+LicenseType MockLicense::type() const{
+    return mBackend->Options().consumptionFeatures.empty() ? LicenseTypePerpetual : LicenseTypeConsumption;
+}
+
+LicenseFeature MockLicense::feature(const std::string& featureCode) const{
+    for (const auto& f : mFeatures)
+    {
+        if (f.code() == featureCode)
+            return f;
+    }
+    throw InvalidLicenseFeatureException("Mock backend: unknown feature " + featureCode);
+}
+
+std::string MockLicense::userData(const std::string& key) const{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const auto& field : mUserData)
+    {
+        if (field.fieldName() == key)
+            return field.fieldValue();
+    }
+    return std::string();
+}
+
+void MockLicense::addUserData(const CustomField& data, bool){
+    std::lock_guard<std::mutex> lock(mMutex);
+    mUserData.push_back(data);
+}
+
+void MockLicense::removeUserData(const std::string& key, bool){
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (key.empty())
+        mUserData.clear();
+    else
+        mUserData.erase(std::remove_if(mUserData.begin(), mUserData.end(),
+                                       [&](const CustomField& f){ return f.fieldName() == key; }),
+                        mUserData.end());
+}
+
+void MockLicense::updateConsumption(int32_t value, bool){
+    mConsumption.fetch_add(value);
+}
+
+void MockLicense::updateFeatureConsumption(const std::string& featureCode, int32_t, bool){
+    feature(featureCode);
+}
+
+void MockLicense::localCheck(){
+    mBackend->LocalCall();
+}
+
+bool MockLicense::deactivate(bool){
+    mBackend->NetworkCall();
+    releaseFloatingLicense();
+    return true;
+}
+
+InstallationFile::ptr_t MockLicense::check(const InstallFileFilter&, bool){
+    mBackend->NetworkCall();
+    if (isFloating())
+    {
+        // check keeps the floating seat alive or registers a new one
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mHoldsSeat)
+        {
+            mBackend->AcquireSeat();
+            mHoldsSeat = true;
+        }
+    }
+    return nullptr;
+}
+
+bool MockLicense::syncConsumption(int32_t){
+    mBackend->NetworkCall();
+    return true;
+}
+
+bool MockLicense::syncFeatureConsumption(const std::string&){
+    mBackend->NetworkCall();
+    return true;
+}
+
+void MockLicense::addDeviceVariable(const std::string& name, const std::string& value, bool){
+    addDeviceVariable(DeviceVariable(name, value));
+}
+
+void MockLicense::addDeviceVariable(const DeviceVariable& variable, bool){
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& v : mVariables)
+    {
+        if (v.name() == variable.name())
+        {
+            v = variable;
+            return;
+        }
+    }
+    mVariables.push_back(variable);
+}
+
+void MockLicense::addDeviceVariables(const std::vector<DeviceVariable>& variables){
+    for (const auto& v : variables)
+        addDeviceVariable(v);
+}
+
+bool MockLicense::sendDeviceVariables(){
+    mBackend->NetworkCall();
+    return true;
+}
+
+std::vector<DeviceVariable> MockLicense::getDeviceVariables(bool getFromBackend){
+    if (getFromBackend)
+        mBackend->NetworkCall();
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mVariables;
+}
+
+DeviceVariable MockLicense::deviceVariable(const std::string& name) const{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const auto& v : mVariables)
+    {
+        if (v.name() == name)
+            return v;
+    }
+    return DeviceVariable();
+}
+
+const std::string& MockLicense::deviceVariableValue(const std::string& name) const{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const auto& v : mVariables)
+    {
+        if (v.name() == name)
+            return v.value();
+    }
+    return mEmpty;
+}
+
+void MockLicense::registerFloatingLicense(){
+    mBackend->NetworkCall();
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mHoldsSeat)
+        return;
+    mBackend->AcquireSeat();
+    mHoldsSeat = true;
+}
+
+void MockLicense::releaseFloatingLicense(bool throwExceptions){
+    try
+    {
+        mBackend->NetworkCall();
+    }
+    catch (const LicenseSpringException&)
+    {
+        if (throwExceptions)
+            throw;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mHoldsSeat)
+    {
+        mBackend->ReleaseSeat();
+        mHoldsSeat = false;
+    }
+}
+
+void MockLicense::borrow(uint32_t, uint32_t){
+    mBackend->NetworkCall();
+}
+
+void MockLicense::borrow(const std::string&){
+    mBackend->NetworkCall();
+}
+
+void MockLicense::registerFloatingFeature(const std::string& featureCode, bool){
+    if (!feature(featureCode).isFloating())
+        throw InvalidLicenseFeatureException("Mock backend: feature " + featureCode + " is not floating");
+    mBackend->NetworkCall();
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mRegisteredFeatures.count(featureCode))
+        return;
+    mBackend->AcquireSeat();
+    mRegisteredFeatures.insert(featureCode);
+}
+
+void MockLicense::releaseFloatingFeature(const std::string& featureCode){
+    mBackend->NetworkCall();
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mRegisteredFeatures.erase(featureCode))
+        mBackend->ReleaseSeat();
+}
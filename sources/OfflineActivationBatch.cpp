@@ -0,0 +1,203 @@
+#include "OfflineActivationBatch.h"
+#include "AppConfig.h"
+#include "LicenseRegistry.h"
+#include "PresienLog.h"
+#include "Sha1.hpp"
+
+#include <LicenseSpring/Exceptions.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include <json/json.hpp>
+
+using namespace LicenseSpring;
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    constexpr size_t TAR_BLOCK = 512;
+
+    std::string trim(const std::string& value){
+        const auto first = value.find_first_not_of(" \t\r");
+        if (first == std::string::npos)
+            return std::string();
+        return value.substr(first, value.find_last_not_of(" \t\r") - first + 1);
+    }
+
+    std::string fileSafe(std::string value){
+        for (auto& c : value)
+        {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+                c = '_';
+        }
+        return value.substr(0, 64);
+    }
+
+    std::string readFile(const std::filesystem::path& path){
+        std::ifstream is(path, std::ios::binary);
+        std::stringstream ss;
+        ss << is.rdbuf();
+        return ss.str();
+    }
+
+    void writeOctal(char* field, size_t width, uint64_t value){
+        // width - 1 digits, NUL terminated
+        std::snprintf(field, width, "%0*llo", static_cast<int>(width - 1), static_cast<unsigned long long>(value));
+    }
+
+    void writeTarEntry(std::ofstream& os, const std::string& name, const std::string& content){
+        if (name.size() >= 100)
+            throw std::runtime_error("Archive entry name too long: " + name);
+        char header[TAR_BLOCK] = {};
+        std::memcpy(header, name.data(), name.size());
+        writeOctal(header + 100, 8, 0644);
+        writeOctal(header + 108, 8, 0);
+        writeOctal(header + 116, 8, 0);
+        writeOctal(header + 124, 12, content.size());
+        writeOctal(header + 136, 12, static_cast<uint64_t>(std::time(nullptr)));
+        header[156] = '0';
+        std::memcpy(header + 257, "ustar", 6);
+        std::memcpy(header + 263, "00", 2);
+        // checksum is computed with its own field as spaces
+        std::memset(header + 148, ' ', 8);
+        unsigned checksum = 0;
+        for (unsigned char c : header)
+            checksum += c;
+        std::snprintf(header + 148, 8, "%06o", checksum);
+        header[155] = ' ';
+
+        os.write(header, TAR_BLOCK);
+        os.write(content.data(), static_cast<std::streamsize>(content.size()));
+        const size_t padding = (TAR_BLOCK - content.size() % TAR_BLOCK) % TAR_BLOCK;
+        const char zeros[TAR_BLOCK] = {};
+        os.write(zeros, static_cast<std::streamsize>(padding));
+    }
+}
+
+std::vector<OfflineActivationBatch::Device> OfflineActivationBatch::ReadManifest(const std::string& path){
+    std::ifstream is(path);
+    if (!is.good())
+        throw std::runtime_error("Cannot read manifest " + path);
+
+    std::vector<Device> devices;
+    std::string line;
+    for (size_t number = 1; std::getline(is, line); ++number)
+    {
+        line = trim(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        for (std::string field; std::getline(ss, field, ',');)
+            fields.push_back(trim(field));
+        if (fields.size() < 2 || fields.size() > 3 || fields[0].empty() || fields[1].empty())
+            throw std::runtime_error(path + ":" + std::to_string(number) + ": expected license_key,hardware_id[,product_code]");
+        // optional header line
+        if (devices.empty() && fields[0] == "license_key")
+            continue;
+        devices.push_back({fields[0], fields[1], fields.size() == 3 ? fields[2] : std::string()});
+    }
+    return devices;
+}
+
+std::vector<OfflineActivationBatch::Result> OfflineActivationBatch::CreateRequests(const std::vector<Device>& devices, const std::string& outputDir){
+    const auto requestDir = std::filesystem::path(outputDir) / "requests";
+    std::filesystem::create_directories(requestDir);
+
+    // the registry keeps its (unused) license storage out of the way and is dropped afterwards
+    const auto stateDir = std::filesystem::temp_directory_path() / ("presien-offline-" + std::to_string(getpid()));
+    LicenseRegistry::Options registryOptions;
+    registryOptions.storageRoot = stateDir.wstring();
+    registryOptions.appName = mOptions.appName;
+    registryOptions.appVersion = mOptions.appVersion;
+    registryOptions.workers = mOptions.workers;
+    const std::string defaultProduct(AppConfig::productCode());
+
+    std::vector<Result> results(devices.size());
+    {
+        LicenseRegistry registry(registryOptions);
+        std::vector<std::future<void>> pending;
+        pending.reserve(devices.size());
+        for (size_t i = 0; i < devices.size(); ++i)
+        {
+            pending.push_back(registry.Pool().Submit([&, i]{
+                auto& result = results[i];
+                result.device = devices[i];
+                result.requestFile = "requests/" + std::to_string(i + 1) + "_" + fileSafe(devices[i].hardwareId) + ".req";
+                try
+                {
+                    const LicenseRegistry::Key key{devices[i].productCode.empty() ? defaultProduct : devices[i].productCode, devices[i].hardwareId};
+                    auto manager = registry.Add(key);
+                    const auto path = std::filesystem::path(outputDir) / result.requestFile;
+                    manager->createOfflineActivationFile(LicenseID::fromKey(devices[i].licenseKey), path.wstring());
+                    const auto content = readFile(path);
+                    result.size = content.size();
+                    SHA1 sha1;
+                    sha1.update(content);
+                    result.sha1 = sha1.final();
+                }
+                catch (const std::exception& ex)
+                {
+                    result.error = ex.what();
+                }
+            }));
+        }
+        for (auto& future : pending)
+            future.get();
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(stateDir, ec);
+
+    nlohmann::json index = nlohmann::json::array();
+    size_t failed = 0;
+    for (const auto& result : results)
+    {
+        nlohmann::json item;
+        item["license_key"] = result.device.licenseKey;
+        item["hardware_id"] = result.device.hardwareId;
+        item["product"] = result.device.productCode.empty() ? defaultProduct : result.device.productCode;
+        if (result.error.empty())
+        {
+            item["file"] = result.requestFile;
+            item["size"] = result.size;
+            item["sha1"] = result.sha1;
+        }
+        else
+        {
+            item["error"] = result.error;
+            ++failed;
+        }
+        index.push_back(item);
+    }
+    std::ofstream os(std::filesystem::path(outputDir) / "index.json", std::ios::trunc);
+    os << index.dump(2);
+
+    PLOG_INFO("Offline activation requests: " << devices.size() - failed << " written, " << failed << " failed");
+    return results;
+}
+
+void OfflineActivationBatch::WriteArchive(const std::vector<Result>& results, const std::string& outputDir, const std::string& archivePath){
+    std::ofstream os(archivePath, std::ios::binary | std::ios::trunc);
+    if (!os.good())
+        throw std::runtime_error("Cannot write " + archivePath);
+    writeTarEntry(os, "index.json", readFile(std::filesystem::path(outputDir) / "index.json"));
+    for (const auto& result : results)
+    {
+        if (result.error.empty())
+            writeTarEntry(os, result.requestFile, readFile(std::filesystem::path(outputDir) / result.requestFile));
+    }
+    const char zeros[TAR_BLOCK * 2] = {};
+    os.write(zeros, sizeof(zeros));
+    if (!os.good())
+        throw std::runtime_error("Cannot write " + archivePath);
+}
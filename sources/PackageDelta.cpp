@@ -0,0 +1,320 @@
+// MD5_CTX streaming API, same as PackageDownloader
+#define OPENSSL_SUPPRESS_DEPRECATED
+
+#include "PackageDelta.h"
+
+#include <openssl/md5.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    constexpr char MAGIC[8] = {'P', 'D', 'E', 'L', 'T', 'A', '1', '\0'};
+    constexpr size_t MIN_CHUNK = 2 * 1024;
+    constexpr size_t MAX_CHUNK = 64 * 1024;
+    constexpr uint64_t CHUNK_MASK = (1ull << 13) - 1;    // 8 KiB average
+    constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    const std::array<uint64_t, 256>& gearTable(){
+        // fixed seed, packaging tool and device must cut identically
+        static const auto table = []{
+            std::array<uint64_t, 256> gear{};
+            uint64_t state = 0x5072657369656e31ull;
+            for (auto& value : gear)
+            {
+                uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+                value = z ^ (z >> 31);
+            }
+            return gear;
+        }();
+        return table;
+    }
+
+    size_t nextChunk(const uint8_t* data, size_t size){
+        if (size <= MIN_CHUNK)
+            return size;
+        const auto& gear = gearTable();
+        const size_t limit = std::min(size, MAX_CHUNK);
+        uint64_t hash = 0;
+        for (size_t i = MIN_CHUNK; i < limit; ++i)
+        {
+            hash = (hash << 1) + gear[data[i]];
+            if ((hash & CHUNK_MASK) == 0)
+                return i + 1;
+        }
+        return limit;
+    }
+
+    uint64_t fingerprint(const uint8_t* data, size_t size){
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < size; ++i)
+            hash = (hash ^ data[i]) * 0x100000001b3ull;
+        return hash ^ size;
+    }
+
+    std::string toHex(const unsigned char* data, size_t size){
+        static const char digits[] = "0123456789abcdef";
+        std::string hex;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hex += digits[data[i] >> 4];
+            hex += digits[data[i] & 0x0f];
+        }
+        return hex;
+    }
+
+    class MappedFile{
+        public:
+            explicit MappedFile(const std::string& path){
+                mFd = open(path.c_str(), O_RDONLY);
+                struct stat st{};
+                if (mFd < 0 || fstat(mFd, &st) != 0)
+                    throw std::runtime_error("Cannot open " + path);
+                mSize = static_cast<size_t>(st.st_size);
+                if (mSize > 0)
+                {
+                    void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFd, 0);
+                    if (data == MAP_FAILED)
+                        throw std::runtime_error("Cannot map " + path);
+                    mData = static_cast<const uint8_t*>(data);
+                }
+            }
+            ~MappedFile(){
+                if (mData)
+                    munmap(const_cast<uint8_t*>(mData), mSize);
+                if (mFd >= 0)
+                    close(mFd);
+            }
+            MappedFile(const MappedFile &) = delete;
+            MappedFile &operator=(const MappedFile &) = delete;
+
+            const uint8_t* Data() const { return mData; }
+            size_t Size() const { return mSize; }
+
+        private:
+            int mFd = -1;
+            const uint8_t* mData = nullptr;
+            size_t mSize = 0;
+    };
+
+    template<typename T>
+    void put(std::ofstream& os, T value){
+        os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template<typename T>
+    T get(std::ifstream& is){
+        T value{};
+        if (!is.read(reinterpret_cast<char*>(&value), sizeof(value)))
+            throw std::runtime_error("Truncated delta");
+        return value;
+    }
+}
+
+PackageDelta::Stats PackageDelta::Create(const std::string& oldPath, const std::string& newPath, const std::string& deltaPath){
+    MappedFile oldFile(oldPath);
+    MappedFile newFile(newPath);
+
+    std::unordered_map<uint64_t, std::pair<uint64_t, uint32_t>> index;
+    for (size_t offset = 0; offset < oldFile.Size();)
+    {
+        const size_t length = nextChunk(oldFile.Data() + offset, oldFile.Size() - offset);
+        index.emplace(fingerprint(oldFile.Data() + offset, length), std::make_pair(offset, static_cast<uint32_t>(length)));
+        offset += length;
+    }
+
+    unsigned char digest[MD5_DIGEST_LENGTH];
+    MD5(newFile.Data(), newFile.Size(), digest);
+
+    std::ofstream os(deltaPath, std::ios::binary | std::ios::trunc);
+    if (!os.good())
+        throw std::runtime_error("Cannot write " + deltaPath);
+    os.write(MAGIC, sizeof(MAGIC));
+    put<uint64_t>(os, oldFile.Size());
+    put<uint64_t>(os, newFile.Size());
+    os << toHex(digest, sizeof(digest));
+
+    Stats stats;
+    // adjacent copies and literals are merged before they are written
+    uint64_t copyOffset = 0, copyLength = 0;
+    size_t literalStart = 0, literalLength = 0;
+    auto flushCopy = [&]{
+        while (copyLength > 0)
+        {
+            const auto length = static_cast<uint32_t>(std::min<uint64_t>(copyLength, UINT32_MAX));
+            os.put('C');
+            put<uint64_t>(os, copyOffset);
+            put<uint32_t>(os, length);
+            copyOffset += length;
+            copyLength -= length;
+        }
+    };
+    auto flushLiteral = [&]{
+        if (literalLength == 0)
+            return;
+        os.put('L');
+        put<uint32_t>(os, static_cast<uint32_t>(literalLength));
+        os.write(reinterpret_cast<const char*>(newFile.Data() + literalStart), static_cast<std::streamsize>(literalLength));
+        literalLength = 0;
+    };
+
+    for (size_t offset = 0; offset < newFile.Size();)
+    {
+        const uint8_t* chunk = newFile.Data() + offset;
+        const size_t length = nextChunk(chunk, newFile.Size() - offset);
+        ++stats.chunks;
+        auto match = index.find(fingerprint(chunk, length));
+        // the fingerprint only nominates, bytes decide
+        if (match != index.end() && match->second.second == length &&
+            std::memcmp(oldFile.Data() + match->second.first, chunk, length) == 0)
+        {
+            flushLiteral();
+            if (copyLength > 0 && copyOffset + copyLength != match->second.first)
+                flushCopy();
+            if (copyLength == 0)
+                copyOffset = match->second.first;
+            copyLength += length;
+            stats.copied += length;
+        }
+        else
+        {
+            flushCopy();
+            if (literalLength + length > UINT32_MAX)
+                flushLiteral();
+            if (literalLength == 0)
+                literalStart = offset;
+            literalLength += length;
+            stats.literal += length;
+        }
+        offset += length;
+    }
+    flushCopy();
+    flushLiteral();
+    os.put('E');
+    os.flush();
+    if (!os.good())
+        throw std::runtime_error("Cannot write " + deltaPath);
+    stats.deltaSize = static_cast<uint64_t>(os.tellp());
+    return stats;
+}
+
+std::string PackageDelta::Apply(const std::string& oldPath, const std::string& deltaPath, const std::string& outPath){
+    std::ifstream delta(deltaPath, std::ios::binary);
+    if (!delta.good())
+        throw std::runtime_error("Cannot open " + deltaPath);
+    char magic[sizeof(MAGIC)];
+    if (!delta.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw std::runtime_error(deltaPath + " is not a package delta");
+    const auto oldSize = get<uint64_t>(delta);
+    const auto newSize = get<uint64_t>(delta);
+    std::string expectedMd5(32, '\0');
+    if (!delta.read(&expectedMd5[0], 32))
+        throw std::runtime_error("Truncated delta");
+
+    int oldFd = open(oldPath.c_str(), O_RDONLY);
+    struct stat st{};
+    if (oldFd < 0 || fstat(oldFd, &st) != 0 || static_cast<uint64_t>(st.st_size) != oldSize)
+    {
+        if (oldFd >= 0)
+            close(oldFd);
+        throw std::runtime_error(oldPath + " is not the base version of this delta");
+    }
+
+    const auto partPath = outPath + ".part";
+    int outFd = open(partPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (outFd < 0)
+    {
+        close(oldFd);
+        throw std::runtime_error("Cannot write " + partPath);
+    }
+
+    MD5_CTX md5;
+    MD5_Init(&md5);
+    std::vector<char> buffer(BUFFER_SIZE);
+    uint64_t written = 0;
+    std::string error;
+    auto emit = [&](size_t length){
+        if (write(outFd, buffer.data(), length) != static_cast<ssize_t>(length))
+            throw std::runtime_error("Cannot write " + partPath);
+        MD5_Update(&md5, buffer.data(), length);
+        written += length;
+    };
+
+    try
+    {
+        for (char op = 0; op != 'E';)
+        {
+            if (!delta.get(op))
+                throw std::runtime_error("Truncated delta");
+            if (op == 'C')
+            {
+                auto offset = get<uint64_t>(delta);
+                auto remaining = static_cast<uint64_t>(get<uint32_t>(delta));
+                if (offset + remaining > oldSize)
+                    throw std::runtime_error("Delta copies past the base package");
+                while (remaining > 0)
+                {
+                    const size_t length = static_cast<size_t>(std::min<uint64_t>(remaining, buffer.size()));
+                    if (pread(oldFd, buffer.data(), length, static_cast<off_t>(offset)) != static_cast<ssize_t>(length))
+                        throw std::runtime_error("Cannot read " + oldPath);
+                    emit(length);
+                    offset += length;
+                    remaining -= length;
+                }
+            }
+            else if (op == 'L')
+            {
+                auto remaining = static_cast<uint64_t>(get<uint32_t>(delta));
+                while (remaining > 0)
+                {
+                    const size_t length = static_cast<size_t>(std::min<uint64_t>(remaining, buffer.size()));
+                    if (!delta.read(buffer.data(), static_cast<std::streamsize>(length)))
+                        throw std::runtime_error("Truncated delta");
+                    emit(length);
+                    remaining -= length;
+                }
+            }
+            else if (op != 'E')
+                throw std::runtime_error("Corrupt delta op");
+            if (written > newSize)
+                throw std::runtime_error("Delta output exceeds target size");
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        error = ex.what();
+    }
+    close(oldFd);
+    if (close(outFd) != 0 && error.empty())
+        error = "Cannot write " + partPath;
+
+    unsigned char digest[MD5_DIGEST_LENGTH];
+    MD5_Final(digest, &md5);
+    const auto md5Hex = toHex(digest, sizeof(digest));
+    if (error.empty() && (written != newSize || md5Hex != expectedMd5))
+        error = "Delta output hash mismatch, expected " + expectedMd5 + " got " + md5Hex;
+    if (!error.empty())
+    {
+        std::remove(partPath.c_str());
+        throw std::runtime_error(error);
+    }
+    if (std::rename(partPath.c_str(), outPath.c_str()) != 0)
+        throw std::runtime_error("Cannot move " + partPath + " to " + outPath);
+    return md5Hex;
+}
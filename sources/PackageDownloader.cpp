@@ -0,0 +1,369 @@
+// MD5_CTX is plain data, the only way to checkpoint a running MD5 without re-reading the prefix
+#define OPENSSL_SUPPRESS_DEPRECATED
+
+#include "PackageDownloader.h"
+#include "PresienLog.h"
+
+#include <curl/curl.h>
+#include <openssl/md5.h>
+
+#include <json/json.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    struct Transfer{
+        CURL* easy = nullptr;
+        size_t index = 0;
+        uint64_t offset = 0;
+        size_t length = 0;
+        std::string data;
+    };
+
+    struct Checkpoint{
+        uint64_t hashed = 0;
+        MD5_CTX md5;
+    };
+
+    void globalInit(){
+        static std::once_flag once;
+        std::call_once(once, []{ curl_global_init(CURL_GLOBAL_DEFAULT); });
+    }
+
+    std::string toHex(const unsigned char* data, size_t size){
+        static const char digits[] = "0123456789abcdef";
+        std::string hex;
+        hex.reserve(size * 2);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hex += digits[data[i] >> 4];
+            hex += digits[data[i] & 0x0f];
+        }
+        return hex;
+    }
+
+    bool fromHex(const std::string& hex, unsigned char* out, size_t size){
+        if (hex.size() != size * 2)
+            return false;
+        for (size_t i = 0; i < size; ++i)
+            out[i] = static_cast<unsigned char>(std::stoi(hex.substr(i * 2, 2), nullptr, 16));
+        return true;
+    }
+
+    std::string lower(std::string value){
+        std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c){ return std::tolower(c); });
+        return value;
+    }
+
+    size_t appendToTransfer(char* ptr, size_t size, size_t nmemb, void* userdata){
+        auto* transfer = static_cast<Transfer*>(userdata);
+        const size_t bytes = size * nmemb;
+        // more than requested means the server ignored the range, abort and fall back
+        if (transfer->data.size() + bytes > transfer->length)
+            return 0;
+        transfer->data.append(ptr, bytes);
+        return bytes;
+    }
+
+    struct StreamState{
+        int fd = -1;
+        uint64_t offset = 0;
+        MD5_CTX md5;
+        bool failed = false;
+    };
+
+    size_t writeStream(char* ptr, size_t size, size_t nmemb, void* userdata){
+        auto* state = static_cast<StreamState*>(userdata);
+        const size_t bytes = size * nmemb;
+        if (pwrite(state->fd, ptr, bytes, static_cast<off_t>(state->offset)) != static_cast<ssize_t>(bytes))
+        {
+            state->failed = true;
+            return 0;
+        }
+        MD5_Update(&state->md5, ptr, bytes);
+        state->offset += bytes;
+        return bytes;
+    }
+
+    size_t rangeHeader(char* buffer, size_t size, size_t nitems, void* userdata){
+        std::string header(buffer, size * nitems);
+        if (lower(header).find("accept-ranges: bytes") == 0)
+            *static_cast<bool*>(userdata) = true;
+        return size * nitems;
+    }
+
+    // HEAD request for size and range support
+    bool probe(const std::string& url, std::chrono::seconds timeout, uint64_t& size, bool& ranges){
+        CURL* easy = curl_easy_init();
+        curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(easy, CURLOPT_NOBODY, 1L);
+        curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(easy, CURLOPT_TIMEOUT, static_cast<long>(timeout.count()));
+        curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, rangeHeader);
+        curl_easy_setopt(easy, CURLOPT_HEADERDATA, &ranges);
+        auto code = curl_easy_perform(easy);
+        long status = 0;
+        curl_off_t length = -1;
+        curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &status);
+        curl_easy_getinfo(easy, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+        curl_easy_cleanup(easy);
+        if (code != CURLE_OK || status != 200 || length < 0)
+            return false;
+        size = static_cast<uint64_t>(length);
+        return true;
+    }
+
+    bool loadCheckpoint(const std::string& path, const std::string& url, uint64_t size, size_t chunkSize, Checkpoint& checkpoint){
+        std::ifstream is(path);
+        if (!is.good())
+            return false;
+        try
+        {
+            auto data = nlohmann::json::parse(is);
+            if (data.at("url").get<std::string>() != url || data.at("size").get<uint64_t>() != size ||
+                data.at("chunk_size").get<size_t>() != chunkSize)
+                return false;
+            checkpoint.hashed = data.at("hashed").get<uint64_t>();
+            return fromHex(data.at("md5_state").get<std::string>(), reinterpret_cast<unsigned char*>(&checkpoint.md5), sizeof(MD5_CTX));
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    void saveCheckpoint(const std::string& path, const std::string& url, uint64_t size, size_t chunkSize, const Checkpoint& checkpoint){
+        nlohmann::json data;
+        data["url"] = url;
+        data["size"] = size;
+        data["chunk_size"] = chunkSize;
+        data["hashed"] = checkpoint.hashed;
+        data["md5_state"] = toHex(reinterpret_cast<const unsigned char*>(&checkpoint.md5), sizeof(MD5_CTX));
+        const auto tmpPath = path + ".tmp";
+        {
+            std::ofstream os(tmpPath, std::ios::trunc);
+            os << data.dump();
+        }
+        std::rename(tmpPath.c_str(), path.c_str());
+    }
+}
+
+PackageDownloader::Result PackageDownloader::Download(const std::string& url, const std::string& destination,
+                                                      uint64_t expectedSize, const std::string& expectedMd5){
+    globalInit();
+    Result result;
+    const auto partPath = destination + ".part";
+    const auto statePath = destination + ".part.json";
+    const size_t chunkSize = std::max<size_t>(mOptions.chunkSize, 64 * 1024);
+
+    uint64_t size = expectedSize;
+    bool ranges = true;
+    if (size == 0 && !probe(url, mOptions.timeout, size, ranges))
+    {
+        result.error = "Cannot determine package size of " + url;
+        return result;
+    }
+    result.size = size;
+
+    Checkpoint checkpoint;
+    MD5_Init(&checkpoint.md5);
+    struct stat st{};
+    if (loadCheckpoint(statePath, url, size, chunkSize, checkpoint) && stat(partPath.c_str(), &st) == 0 &&
+        static_cast<uint64_t>(st.st_size) == size && checkpoint.hashed <= size)
+    {
+        result.resumed = checkpoint.hashed > 0;
+        PLOG_INFO("Resuming download of " << url << " at " << checkpoint.hashed << " of " << size << " bytes");
+    }
+    else
+    {
+        checkpoint.hashed = 0;
+        MD5_Init(&checkpoint.md5);
+    }
+
+    int fd = open(partPath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        result.error = "Cannot open " + partPath;
+        return result;
+    }
+    if (size > 0 && posix_fallocate(fd, 0, static_cast<off_t>(size)) != 0 && ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        close(fd);
+        result.error = "Cannot preallocate " + partPath;
+        return result;
+    }
+
+    const size_t total = static_cast<size_t>((size + chunkSize - 1) / chunkSize);
+    size_t nextHash = static_cast<size_t>(checkpoint.hashed / chunkSize);
+    size_t nextSchedule = nextHash;
+    // completed chunks wait here until the hashed prefix reaches them, bounded by the window
+    const size_t window = std::max<size_t>(mOptions.connections, 1) * 2;
+    std::map<size_t, std::string> completed;
+    std::deque<size_t> retry;
+    std::map<size_t, int> attempts;
+    bool rangesIgnored = !ranges;
+
+    CURLM* multi = curl_multi_init();
+    std::vector<Transfer*> active;
+    auto start = [&](size_t index){
+        auto* transfer = new Transfer();
+        transfer->index = index;
+        transfer->offset = static_cast<uint64_t>(index) * chunkSize;
+        transfer->length = static_cast<size_t>(std::min<uint64_t>(chunkSize, size - transfer->offset));
+        transfer->data.reserve(transfer->length);
+        const auto range = std::to_string(transfer->offset) + "-" + std::to_string(transfer->offset + transfer->length - 1);
+        transfer->easy = curl_easy_init();
+        curl_easy_setopt(transfer->easy, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(transfer->easy, CURLOPT_RANGE, range.c_str());
+        curl_easy_setopt(transfer->easy, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(transfer->easy, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(transfer->easy, CURLOPT_TIMEOUT, static_cast<long>(mOptions.timeout.count()));
+        curl_easy_setopt(transfer->easy, CURLOPT_WRITEFUNCTION, appendToTransfer);
+        curl_easy_setopt(transfer->easy, CURLOPT_WRITEDATA, transfer);
+        curl_easy_setopt(transfer->easy, CURLOPT_PRIVATE, transfer);
+        curl_multi_add_handle(multi, transfer->easy);
+        active.push_back(transfer);
+    };
+    auto finish = [&](Transfer* transfer){
+        curl_multi_remove_handle(multi, transfer->easy);
+        curl_easy_cleanup(transfer->easy);
+        active.erase(std::find(active.begin(), active.end(), transfer));
+        delete transfer;
+    };
+
+    while (!rangesIgnored && result.error.empty() && nextHash < total)
+    {
+        while (active.size() < mOptions.connections)
+        {
+            if (!retry.empty())
+            {
+                start(retry.front());
+                retry.pop_front();
+            }
+            else if (nextSchedule < total && nextSchedule < nextHash + window)
+                start(nextSchedule++);
+            else
+                break;
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        int queued = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi, &queued))
+        {
+            if (msg->msg != CURLMSG_DONE)
+                continue;
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+            long status = 0;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &status);
+
+            if (msg->data.result == CURLE_OK && status == 206 && transfer->data.size() == transfer->length)
+            {
+                if (pwrite(fd, transfer->data.data(), transfer->length, static_cast<off_t>(transfer->offset)) != static_cast<ssize_t>(transfer->length))
+                    result.error = "Cannot write " + partPath;
+                result.downloaded += transfer->length;
+                completed.emplace(transfer->index, std::move(transfer->data));
+            }
+            else if (status == 200 && !(total == 1 && transfer->data.size() == transfer->length))
+                rangesIgnored = true;
+            else if (status == 200)
+            {
+                // single chunk package, a full response is the chunk itself
+                if (pwrite(fd, transfer->data.data(), transfer->length, 0) != static_cast<ssize_t>(transfer->length))
+                    result.error = "Cannot write " + partPath;
+                result.downloaded += transfer->length;
+                completed.emplace(transfer->index, std::move(transfer->data));
+            }
+            else if (++attempts[transfer->index] > mOptions.retries)
+                result.error = "Chunk " + std::to_string(transfer->index) + " failed: " +
+                               (msg->data.result != CURLE_OK ? curl_easy_strerror(msg->data.result) : "HTTP " + std::to_string(status));
+            else
+                retry.push_back(transfer->index);
+            finish(transfer);
+        }
+
+        // hash in file order as soon as the prefix is contiguous
+        bool advanced = false;
+        for (auto it = completed.find(nextHash); it != completed.end(); it = completed.find(nextHash))
+        {
+            MD5_Update(&checkpoint.md5, it->second.data(), it->second.size());
+            checkpoint.hashed += it->second.size();
+            completed.erase(it);
+            ++nextHash;
+            advanced = true;
+        }
+        if (advanced)
+            saveCheckpoint(statePath, url, size, chunkSize, checkpoint);
+        if (running > 0)
+            curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+    }
+
+    while (!active.empty())
+        finish(active.front());
+    curl_multi_cleanup(multi);
+
+    if (rangesIgnored && result.error.empty())
+    {
+        PLOG_WARN("Server does not support range requests, downloading " << url << " as one stream");
+        StreamState stream;
+        stream.fd = fd;
+        MD5_Init(&stream.md5);
+        CURL* easy = curl_easy_init();
+        curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(easy, CURLOPT_FAILONERROR, 1L);
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeStream);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, &stream);
+        auto code = curl_easy_perform(easy);
+        curl_easy_cleanup(easy);
+        if (code != CURLE_OK || stream.failed || stream.offset != size)
+            result.error = std::string("Download failed: ") + curl_easy_strerror(code);
+        result.downloaded = stream.offset;
+        checkpoint.hashed = stream.offset;
+        checkpoint.md5 = stream.md5;
+    }
+    close(fd);
+
+    if (!result.error.empty())
+    {
+        PLOG_ERROR(result.error << ", " << checkpoint.hashed << " bytes kept for resume");
+        return result;
+    }
+
+    unsigned char digest[MD5_DIGEST_LENGTH];
+    MD5_Final(digest, &checkpoint.md5);
+    result.md5 = toHex(digest, sizeof(digest));
+    std::remove(statePath.c_str());
+    if (!expectedMd5.empty() && lower(expectedMd5) != result.md5)
+    {
+        std::remove(partPath.c_str());
+        result.error = "MD5 mismatch, expected " + expectedMd5 + " got " + result.md5;
+        PLOG_ERROR(result.error);
+        return result;
+    }
+    if (std::rename(partPath.c_str(), destination.c_str()) != 0)
+    {
+        result.error = "Cannot move package to " + destination;
+        return result;
+    }
+    result.ok = true;
+    return result;
+}
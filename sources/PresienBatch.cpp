@@ -0,0 +1,400 @@
+#include "PresienLic.h"
+#include "LicenseMetrics.h"
+#include "LicenseWatcher.h"
+#include "OfflineActivationBatch.h"
+
+#include <filesystem>
+#include <future>
+#include <map>
+#include <mutex>
+
+#include <json/json.hpp>
+
+// Batch mode: "presien-lic-app --batch" reads one JSON command per line from stdin and writes
+// one JSON result per line to stdout, all against the one initialized LicenseManager.
+//   {"id":1,"cmd":"validate"}
+//   {"id":2,"cmd":"check","timeout_ms":5000}              timeout optional, a timed out check keeps running
+//                                                        and the next check joins it instead of sending another
+//   {"id":3,"cmd":"send-vars","vars":{"Site":"North"}}
+//   {"id":4,"cmd":"feature-status","feature":"f1"}        feature optional, all features otherwise
+//   {"id":5,"cmd":"consume","feature":"f1","value":1}      feature optional, license consumption otherwise
+//   {"id":6,"cmd":"borrow","hours":8,"days":0}             or "until":"2024-05-28T15:30:00Z"
+//   {"id":7,"cmd":"download-update","dir":"/tmp"}         latest installation package, resumes a partial one
+//                                                        "installed"/"installed_version" try deltas first
+//   {"id":8,"cmd":"offline-requests","manifest":"site.csv","out":"site","archive":"site.tar"}
+//                                                        activation requests for every manifest device, archive optional
+//   {"id":9,"cmd":"refresh-ingest","dir":"/media/usb","watch":false}
+//                                                        applies offline refresh files to the registry stores,
+//                                                        "watch":true keeps applying new files until quit
+//   {"id":10,"cmd":"memory","release":false}               RSS, peak RSS and budget, "release":true drops caches first
+//   {"id":11,"cmd":"metadata","source":"license","key":"/cameras/0/model"}
+//                                                        source license, product, custom or user; key a top level
+//                                                        key or JSON pointer, entry counts without it
+//   {"id":12,"cmd":"quit"}
+// Results echo the id: {"id":1,"ok":true,...} or {"id":1,"ok":false,"error":"...","code":12}.
+// When another process rewrites the license file an unsolicited line is written in between:
+//   {"event":"license-changed","changes":[{"field":"validity_period","before":"...","after":"..."}]}
+// Logs go to stderr in this mode. VBSMETRICSPORT=9464 serves the SDK call metrics meanwhile.
+// With VBSLOWMEM=1 or VBSRSSBUDGETMB set, caches are released on memory pressure or over budget.
+
+using namespace PRESIEN::BlindSight;
+using json = nlohmann::json;
+
+namespace {
+
+    json featureStatus(const LicenseFeature& feature){
+        json status;
+        status["code"] = feature.code();
+        status["name"] = feature.name();
+        status["type"] = feature.featureType() == FeatureTypeConsumption ? "consumption" : "activation";
+        status["expired"] = feature.isExpired();
+        if (feature.featureType() == FeatureTypeConsumption)
+        {
+            status["max_consumption"] = feature.maxConsumption();
+            status["total_consumption"] = feature.totalConsumption();
+            status["local_consumption"] = feature.localConsumption();
+        }
+        if (feature.isFloating() || feature.isOfflineFloating())
+        {
+            status["floating_users"] = feature.floatingUsers();
+            status["floating_in_use"] = feature.floatingInUseCount();
+        }
+        return status;
+    }
+
+    json metadataValue(const MetadataValue& value){
+        switch (value.GetType())
+        {
+            case MetadataValue::Type::BOOLEAN:
+                return value.Bool();
+            case MetadataValue::Type::INTEGER:
+                return value.Int();
+            case MetadataValue::Type::NUMBER:
+                return value.Double();
+            case MetadataValue::Type::STRING:
+                return value.String();
+            case MetadataValue::Type::OBJECT:
+            case MetadataValue::Type::ARRAY:
+                return {{"size", value.Size()}};
+            default:
+                return nullptr;
+        }
+    }
+
+    const char* metadataType(MetadataValue::Type type){
+        switch (type)
+        {
+            case MetadataValue::Type::BOOLEAN: return "boolean";
+            case MetadataValue::Type::INTEGER: return "integer";
+            case MetadataValue::Type::NUMBER: return "number";
+            case MetadataValue::Type::STRING: return "string";
+            case MetadataValue::Type::OBJECT: return "object";
+            case MetadataValue::Type::ARRAY: return "array";
+            default: return "null";
+        }
+    }
+}
+
+bool PresienLicense::RunBatch(std::istream& in, FILE* out){
+    if (auto* port = std::getenv("VBSMETRICSPORT"))
+    {
+        if (!LicenseMetrics::GetInstance().StartHttpEndpoint(static_cast<uint16_t>(std::atoi(port))))
+            PLOG_WARN("Cannot serve metrics on port " << port);
+    }
+    auto& memory = MemoryGovernor::GetInstance();
+    if (memory.LowMemory() || memory.Budget())
+        memory.Start();
+    // long running, keep update checks local for the whole session
+    if (m_updateCache)
+        m_updateCache->StartBackgroundRefresh(std::chrono::minutes(15));
+
+    std::mutex outMutex;
+    auto writeLine = [&outMutex, out](std::string line){
+        line += '\n';
+        // one line per message, flushed so a co-process can read it right away
+        std::lock_guard<std::mutex> lock(outMutex);
+        fwrite(line.data(), 1, line.size(), out);
+        fflush(out);
+    };
+    mAsync = std::make_unique<AsyncLicense>(m_licenseManager, 2);
+    // commands and watcher reloads use the same LicenseManager and License, one at a time
+    std::mutex commandMutex;
+    LicenseWatcher watcher(m_licenseManager);
+    watcher.SetReloadMutex(commandMutex);
+    watcher.Subscribe("", [&writeLine](const std::vector<LicenseWatcher::Change>& changes){
+        json event;
+        event["event"] = "license-changed";
+        event["changes"] = json::array();
+        for (const auto& change : changes)
+            event["changes"].push_back({{"field", change.field}, {"before", change.before}, {"after", change.after}});
+        writeLine(event.dump());
+    });
+    watcher.Start();
+    mMetadata = std::make_unique<MetadataIndex>(m_licenseManager);
+    mMetadata->Attach(watcher);
+    const auto metadataReleaser = memory.Register("metadata index", [this]{ mMetadata->ReleaseMemory(); });
+
+    std::string line;
+    size_t commands = 0;
+    while (std::getline(in, line))
+    {
+        if (line.empty())
+            continue;
+        std::string result;
+        bool answered = false;
+        {
+            std::lock_guard<std::mutex> lock(commandMutex);
+            result = _runBatchCommand(line);
+            if (mPendingCheck.valid())
+            {
+                // answered as timed out, the check still runs on the same License: no command
+                // and no reload until it finished
+                writeLine(result);
+                answered = true;
+                mPendingCheck.wait();
+                mPendingCheck = std::shared_future<AsyncOutcome<InstallationFile::ptr_t>>();
+                mMetadata->Invalidate();
+            }
+            // check, consume and borrow save the watched file, that is no license-changed event
+            watcher.Acknowledge();
+        }
+        if (result.empty())
+            break; // quit
+        if (!answered)
+            writeLine(std::move(result));
+        ++commands;
+    }
+    if (m_updateCache)
+        m_updateCache->StopBackgroundRefresh();
+    if (mRefreshIngest)
+    {
+        const auto totals = mRefreshIngest->Totals();
+        PLOG_INFO("Refresh ingest: " << totals.applied << " applied, " << totals.quarantined << " quarantined.");
+        mRefreshIngest.reset();
+    }
+    mAsync.reset();
+    memory.Unregister(metadataReleaser);
+    mMetadata.reset();
+    memory.Stop();
+    PLOG_INFO("Batch mode finished after " << commands << " commands.");
+    return true;
+}
+
+std::string PresienLicense::_runBatchCommand(const std::string& line){
+    json result;
+    try
+    {
+        const auto command = json::parse(line);
+        if (command.contains("id"))
+            result["id"] = command["id"];
+        const auto cmd = command.value("cmd", "");
+        if (cmd == "quit")
+            return std::string();
+        if (cmd == "memory")
+        {
+            // answered without a license
+            auto& memory = MemoryGovernor::GetInstance();
+            if (command.value("release", false))
+                memory.Release("batch command");
+            const auto usage = memory.Current();
+            result["rss"] = usage.rss;
+            result["peak_rss"] = usage.peakRss;
+            result["budget"] = usage.budget;
+            result["low_memory"] = memory.LowMemory();
+            result["pressure_events"] = usage.pressureEvents;
+            result["releases"] = usage.releases;
+            result["ok"] = true;
+            return result.dump();
+        }
+
+        if (cmd == "metadata")
+        {
+            static const std::map<std::string, MetadataIndex::Source> sources = {
+                {"license", MetadataIndex::Source::LICENSE_METADATA}, {"product", MetadataIndex::Source::PRODUCT_METADATA},
+                {"custom", MetadataIndex::Source::CUSTOM_FIELDS}, {"user", MetadataIndex::Source::USER_DATA}};
+            const auto source = sources.find(command.value("source", "license"));
+            if (source == sources.end())
+                throw std::invalid_argument("unknown metadata source " + command.value("source", ""));
+            const auto snapshot = mMetadata->Current();
+            result["revision"] = snapshot->Revision();
+            if (command.contains("key"))
+            {
+                const auto* value = snapshot->Find(source->second, command["key"].get<std::string>());
+                result["found"] = value != nullptr;
+                if (value)
+                {
+                    result["type"] = metadataType(value->GetType());
+                    result["value"] = metadataValue(*value);
+                }
+            }
+            else
+                result["entries"] = snapshot->Entries(source->second);
+            result["ok"] = true;
+            return result.dump();
+        }
+
+        auto license = m_licenseManager->getCurrentLicense();
+        if (!license)
+            throw LocalLicenseException("License not installed");
+
+        if (cmd == "validate")
+        {
+            checkLicenseLocal(license);
+            result["valid"] = license->isValid();
+            result["days_remaining"] = license->daysRemaining();
+        }
+        else if (cmd == "check")
+        {
+            const auto timeout = std::chrono::milliseconds(command.value("timeout_ms", 0));
+            if (timeout.count() > 0)
+            {
+                // no deadline on the call itself: the handler tells when the SDK is done with the
+                // License, RunBatch waits for that before the next command or reload touches it
+                auto done = std::make_shared<std::promise<AsyncOutcome<InstallationFile::ptr_t>>>();
+                std::shared_future<AsyncOutcome<InstallationFile::ptr_t>> outcome = done->get_future().share();
+                mAsync->Check(license, [done](AsyncOutcome<InstallationFile::ptr_t> result){
+                    done->set_value(std::move(result));
+                });
+                if (outcome.wait_for(timeout) != std::future_status::ready)
+                {
+                    mPendingCheck = outcome;
+                    throw std::runtime_error("license call timed out");
+                }
+                outcome.get().Get();
+            }
+            else
+            {
+                PRESIEN_SDK_TIMER(CHECK);
+                license->check();
+            }
+            // the check updates metadata and custom fields in place
+            mMetadata->Invalidate();
+            result["valid"] = license->isValid();
+            result["grace_period"] = license->isGracePeriodStarted();
+        }
+        else if (cmd == "send-vars")
+        {
+            if (command.contains("vars"))
+            {
+                for (const auto& var : command["vars"].items())
+                    m_telemetry->SetStaticVariable(var.key(), var.value().is_string() ? var.value().get<std::string>() : var.value().dump());
+            }
+            m_telemetry->Sample();
+            result["sent"] = m_telemetry->Flush(license);
+        }
+        else if (cmd == "feature-status")
+        {
+            if (command.contains("feature"))
+                result["feature"] = featureStatus(license->feature(command["feature"].get<std::string>()));
+            else
+            {
+                result["features"] = json::array();
+                for (const auto& feature : license->features())
+                    result["features"].push_back(featureStatus(feature));
+            }
+        }
+        else if (cmd == "consume")
+        {
+            const auto value = command.value("value", 1);
+            if (command.contains("feature"))
+            {
+                const auto code = command["feature"].get<std::string>();
+                license->updateFeatureConsumption(code, value);
+                result["synced"] = license->syncFeatureConsumption(code);
+                result["total_consumption"] = license->feature(code).totalConsumption();
+            }
+            else
+            {
+                license->updateConsumption(value);
+                {
+                    PRESIEN_SDK_TIMER(SYNC_CONSUMPTION);
+                    result["synced"] = license->syncConsumption();
+                }
+                result["total_consumption"] = license->totalConsumption();
+            }
+        }
+        else if (cmd == "borrow")
+        {
+            if (command.contains("until"))
+                license->borrow(command["until"].get<std::string>());
+            else
+                license->borrow(command.value("hours", 0u), command.value("days", 0u));
+            result["borrowed"] = license->isBorrowed();
+            result["until"] = TmToString(license->floatingEndDateTimeUtc(), "%Y-%m-%dT%H:%M:%SZ");
+        }
+        else if (cmd == "download-update")
+        {
+            const auto path = downloadLatestUpdate(command.value("dir", std::string(".")),
+                                                   command.value("installed", std::string()),
+                                                   command.value("installed_version", std::string()));
+            if (path.empty())
+                throw std::invalid_argument("no installation package available");
+            result["path"] = path;
+        }
+        else if (cmd == "offline-requests")
+        {
+            OfflineActivationBatch::Options options;
+            options.appName = mConfig.GetBasePtr()->getAppName();
+            options.appVersion = mConfig.GetBasePtr()->getAppVersion();
+            options.workers = command.value("workers", options.workers);
+            OfflineActivationBatch batch(options);
+            const auto outputDir = command.at("out").get<std::string>();
+            auto results = batch.CreateRequests(OfflineActivationBatch::ReadManifest(command.at("manifest").get<std::string>()), outputDir);
+            size_t failed = 0;
+            for (const auto& r : results)
+                failed += r.error.empty() ? 0 : 1;
+            result["created"] = results.size() - failed;
+            result["failed"] = failed;
+            result["index"] = outputDir + "/index.json";
+            if (command.contains("archive"))
+            {
+                OfflineActivationBatch::WriteArchive(results, outputDir, command["archive"].get<std::string>());
+                result["archive"] = command["archive"];
+            }
+        }
+        else if (cmd == "refresh-ingest")
+        {
+            if (!mRegistry)
+            {
+                LicenseRegistry::Options options;
+                if (command.contains("registry"))
+                    options.storageRoot = std::filesystem::path(command["registry"].get<std::string>()).wstring();
+                options.appName = mConfig.GetBasePtr()->getAppName();
+                options.appVersion = mConfig.GetBasePtr()->getAppVersion();
+                mRegistry = std::make_unique<LicenseRegistry>(options);
+                result["stores"] = mRegistry->AddStored();
+            }
+            const auto dir = command.at("dir").get<std::string>();
+            if (command.value("watch", false))
+            {
+                mRefreshIngest.reset();
+                mRefreshIngest = std::make_unique<RefreshIngest>(*mRegistry, dir);
+                if (!mRefreshIngest->Start())
+                    throw std::runtime_error("cannot watch " + dir);
+                result["watching"] = dir;
+            }
+            else
+            {
+                RefreshIngest ingest(*mRegistry, dir);
+                const auto stats = ingest.ProcessExisting();
+                result["applied"] = stats.applied;
+                result["quarantined"] = stats.quarantined;
+            }
+        }
+        else
+            throw std::invalid_argument("unknown command '" + cmd + "'");
+        result["ok"] = true;
+    }
+    catch (const LicenseSpringException& ex)
+    {
+        result["ok"] = false;
+        result["error"] = ex.what();
+        result["code"] = static_cast<int>(ex.getCode());
+    }
+    catch (const std::exception& ex)
+    {
+        result["ok"] = false;
+        result["error"] = ex.what();
+    }
+    return result.dump();
+}
@@ -0,0 +1,162 @@
+#include "PresienCryptoProvider.h"
+#include "SecretVault.h"
+
+#include <LicenseSpring/Exceptions.h>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include <vector>
+
+using namespace LicenseSpring;
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    const std::string GCM_PREFIX = "PGCM1:";
+    constexpr int KEY_SIZE = 32;
+    constexpr int IV_SIZE = 12;
+    constexpr int TAG_SIZE = 16;
+    // derivation runs once per process, keep it well below the startup budget
+    constexpr int PBKDF2_ITERATIONS = 10000;
+    // used only when the SDK did not provide a key
+    PRESIEN_SECRET(kDefaultPassphrase, "presien-blindsight-license-store");
+
+    std::string toBase64(const unsigned char* data, size_t size){
+        std::string out(4 * ((size + 2) / 3), '\0');
+        auto len = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(&out[0]), data, static_cast<int>(size));
+        out.resize(len);
+        return out;
+    }
+
+    std::vector<unsigned char> fromBase64(const char* data, size_t size){
+        std::vector<unsigned char> out(3 * size / 4 + 3);
+        auto len = EVP_DecodeBlock(out.data(), reinterpret_cast<const unsigned char*>(data), static_cast<int>(size));
+        if (len < 0)
+            throw LocalLicenseException("Invalid license encoding.");
+        // EVP_DecodeBlock keeps the bytes produced by '=' padding
+        while (size > 0 && data[size - 1] == '=')
+        {
+            --size;
+            --len;
+        }
+        out.resize(len);
+        return out;
+    }
+}
+
+PresienCryptoProvider::PresienCryptoProvider()
+    : mLegacy(DefaultCryptoProvider::create()){
+}
+
+PresienCryptoProvider::~PresienCryptoProvider(){
+    _releaseContexts();
+}
+
+void PresienCryptoProvider::setSalt(const std::string& salt){
+    std::lock_guard<std::mutex> lock(mMutex);
+    CryptoProvider::setSalt(salt);
+    mLegacy->setSalt(salt);
+    mReady = false;
+}
+
+void PresienCryptoProvider::setKey(const std::string& key){
+    std::lock_guard<std::mutex> lock(mMutex);
+    CryptoProvider::setKey(key);
+    mLegacy->setKey(key);
+    mReady = false;
+}
+
+void PresienCryptoProvider::_releaseContexts(){
+    EVP_CIPHER_CTX_free(mEncryptCtx);
+    EVP_CIPHER_CTX_free(mDecryptCtx);
+    EVP_CIPHER_free(mCipher);
+    mEncryptCtx = nullptr;
+    mDecryptCtx = nullptr;
+    mCipher = nullptr;
+    mReady = false;
+}
+
+void PresienCryptoProvider::_prepare(){
+    if (mReady)
+        return;
+    _releaseContexts();
+
+    std::string passphrase = m_key.empty() ? std::string(kDefaultPassphrase.Reveal()) : m_key;
+    unsigned char key[KEY_SIZE];
+    bool ok = PKCS5_PBKDF2_HMAC(passphrase.data(), static_cast<int>(passphrase.size()),
+                                reinterpret_cast<const unsigned char*>(m_salt.data()), static_cast<int>(m_salt.size()),
+                                PBKDF2_ITERATIONS, EVP_sha256(), KEY_SIZE, key) == 1;
+    OPENSSL_cleanse(&passphrase[0], passphrase.size());
+
+    // explicit fetch once, avoids the implicit algorithm lookup on every init
+    mCipher = EVP_CIPHER_fetch(nullptr, "AES-256-GCM", nullptr);
+    mEncryptCtx = EVP_CIPHER_CTX_new();
+    mDecryptCtx = EVP_CIPHER_CTX_new();
+    ok = ok && mCipher && mEncryptCtx && mDecryptCtx
+        && EVP_EncryptInit_ex2(mEncryptCtx, mCipher, key, nullptr, nullptr) == 1
+        && EVP_DecryptInit_ex2(mDecryptCtx, mCipher, key, nullptr, nullptr) == 1;
+    OPENSSL_cleanse(key, sizeof(key));
+
+    if (!ok)
+    {
+        _releaseContexts();
+        throw LicenseSpringInternalException("Failed to initialize AES-256-GCM crypto provider.");
+    }
+    mReady = true;
+}
+
+std::string PresienCryptoProvider::encrypt(const std::string& inputString){
+    std::lock_guard<std::mutex> lock(mMutex);
+    _prepare();
+
+    std::vector<unsigned char> buffer(IV_SIZE + inputString.size() + TAG_SIZE);
+    unsigned char* iv = buffer.data();
+    unsigned char* cipherText = iv + IV_SIZE;
+    if (RAND_bytes(iv, IV_SIZE) != 1)
+        throw LicenseSpringInternalException("Failed to generate IV.");
+
+    int len = 0;
+    int finalLen = 0;
+    // key schedule stays in the context, only IV is set here
+    bool ok = EVP_EncryptInit_ex2(mEncryptCtx, nullptr, nullptr, iv, nullptr) == 1
+        && EVP_EncryptUpdate(mEncryptCtx, cipherText, &len,
+                             reinterpret_cast<const unsigned char*>(inputString.data()), static_cast<int>(inputString.size())) == 1
+        && EVP_EncryptFinal_ex(mEncryptCtx, cipherText + len, &finalLen) == 1
+        && EVP_CIPHER_CTX_ctrl(mEncryptCtx, EVP_CTRL_GCM_GET_TAG, TAG_SIZE, cipherText + len + finalLen) == 1;
+    if (!ok)
+        throw LicenseSpringInternalException("License encryption failed.");
+
+    return GCM_PREFIX + toBase64(buffer.data(), buffer.size());
+}
+
+std::string PresienCryptoProvider::decrypt(const std::string& inputString){
+    if (inputString.compare(0, GCM_PREFIX.size(), GCM_PREFIX) != 0)
+        return mLegacy->decrypt(inputString);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    _prepare();
+
+    auto buffer = fromBase64(inputString.data() + GCM_PREFIX.size(), inputString.size() - GCM_PREFIX.size());
+    if (buffer.size() < IV_SIZE + TAG_SIZE)
+        throw LocalLicenseException("License data is truncated.");
+
+    const unsigned char* iv = buffer.data();
+    const unsigned char* cipherText = iv + IV_SIZE;
+    const int cipherSize = static_cast<int>(buffer.size()) - IV_SIZE - TAG_SIZE;
+    unsigned char* tag = buffer.data() + IV_SIZE + cipherSize;
+
+    std::string plain(cipherSize, '\0');
+    int len = 0;
+    int finalLen = 0;
+    bool ok = EVP_DecryptInit_ex2(mDecryptCtx, nullptr, nullptr, iv, nullptr) == 1
+        && EVP_DecryptUpdate(mDecryptCtx, reinterpret_cast<unsigned char*>(&plain[0]), &len, cipherText, cipherSize) == 1
+        && EVP_CIPHER_CTX_ctrl(mDecryptCtx, EVP_CTRL_GCM_SET_TAG, TAG_SIZE, tag) == 1
+        && EVP_DecryptFinal_ex(mDecryptCtx, reinterpret_cast<unsigned char*>(&plain[0]) + len, &finalLen) == 1;
+    if (!ok)
+        throw LocalLicenseException("License authentication failed, license file is corrupted or was modified.");
+
+    plain.resize(len + finalLen);
+    return plain;
+}
@@ -1,16 +1,63 @@
 
 #include "PresienLic.h"
+#include "LicenseMetrics.h"
 // uncomment to disable assert()
 // #define NDEBUG
 #include <cassert>
  
  #include <json/json.hpp>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
 // Use (void) to silence unused warnings.
 #define assertm(exp, msg) assert(((void)msg, exp))
 
 //#include "cpu-info.h"
 using namespace PRESIEN::BlindSight;
 
+namespace {
+
+    // Last product details received from the server, answers startup when the budget runs out
+    const char* PRODUCT_DETAILS_CACHE = "product_details.json";
+
+    void saveProductDetails(const std::string& file, const ProductDetails& productInfo){
+        nlohmann::json data;
+        data["authorization_method"] = static_cast<int>(productInfo.authorizationMethod());
+        data["product_name"] = productInfo.productName();
+        data["vm_allowed"] = productInfo.isVMAllowed();
+        data["trial_allowed"] = productInfo.isTrialAllowed();
+        data["metadata"] = productInfo.metadata();
+        // a request that outlived its budget may still be writing while startup reads the cache,
+        // so the file is only ever replaced whole
+        static std::mutex saveMutex;
+        std::lock_guard<std::mutex> lock(saveMutex);
+        const auto tmpFile = file + ".tmp";
+        {
+            std::ofstream os(tmpFile, std::ios::trunc);
+            if (!(os << data.dump()))
+                return;
+        }
+        std::rename(tmpFile.c_str(), file.c_str());
+    }
+
+    bool loadProductDetails(const std::string& file, nlohmann::json& data){
+        std::ifstream is(file);
+        if (!is.good())
+            return false;
+        try
+        {
+            data = nlohmann::json::parse(is);
+            return data.contains("authorization_method");
+        }
+        catch (const nlohmann::json::exception&)
+        {
+            return false;
+        }
+    }
+}
+
 PresienLicense::PresienLicense(REQUEST_CENTRE _req):mRequest(_req){
     Initialize();
 }
@@ -25,61 +72,99 @@ void PresienLicense::Initialize(){
     m_licenseManager = LicenseManager::create(mConfig.GetBasePtr());
     assertm(m_licenseManager != nullptr, "Failed to Create lmgr."); // assertion fails
 
-    std::cout << "------------- General info -------------" << std::endl;
-    std::cout << mConfig.getAppName() + ' ' << mConfig.getAppVersion() << std::endl;
-    std::cout << "LicenseSpring SDK version: " << mConfig.getSdkVersion() << std::endl;
-    std::cout << "LicenseSpring API version: " << mConfig.getLicenseSpringAPIVersion() << std::endl;
-    std::cout << "Determined OS version:     " << mConfig.getOsVersion() << std::endl;
-    std::cout << "Hardware ID: " << mConfig.getHardwareID() << std::endl;
-    std::cout << std::endl;
+    PLOG_INFO("------------- General info -------------");
+    PLOG_INFO(mConfig.getAppName() + ' ' << mConfig.getAppVersion());
+    PLOG_INFO("LicenseSpring SDK version: " << mConfig.getSdkVersion());
+    PLOG_INFO("LicenseSpring API version: " << mConfig.getLicenseSpringAPIVersion());
+    PLOG_INFO("Determined OS version:     " << mConfig.getOsVersion());
+    PLOG_INFO("Hardware ID: " << mConfig.getHardwareID());
 
     //Update license Data store to the mounted volume
-    UpdateDataStorePath();
+    UpdateDataStorePath(m_licenseManager);
+
+    auto telemetryState = std::filesystem::path(m_licenseManager->dataLocation()) / "device_telemetry.json";
+    m_telemetry = std::make_shared<DeviceTelemetry>(telemetryState.string());
+    m_telemetry->SetStaticVariable("TegraCpuUid", mConfig.GetTegraCpuUid());
+    m_telemetry->SetStaticVariable("AppVersion", mConfig.GetBasePtr()->getAppVersion());
+
+    auto updateMetadata = std::filesystem::path(m_licenseManager->dataLocation()) / "update_metadata.json";
+    m_updateCache = std::make_shared<UpdateMetadataCache>(m_licenseManager, updateMetadata.string());
+    MemoryGovernor::GetInstance().Register("update metadata", [cache = std::weak_ptr<UpdateMetadataCache>(m_updateCache)]{
+        if (auto updateCache = cache.lock())
+            updateCache->ReleaseMemory();
+    });
 
     ReadProductInfoFromServer();
 
     ReadTargetPlatformVMInfo();
 }
 
-void PresienLicense::ParseCmdArgs(int argc, char**argv){
-    
+REQUEST_CENTRE PresienLicense::_requestFromArgs(int argc, char**argv){
     if(argc != 2 ){
-        mRequest = REQUEST_CENTRE::INVALID_ACTION;
-        return ;//always offline validate
+        return REQUEST_CENTRE::INVALID_ACTION;//always offline validate
     }
 
     string cmd=argv[1];
     std::transform(cmd.begin(), cmd.end(), cmd.begin(),
         [](unsigned char c){ return std::tolower(c); });
 
-    std::string install_cmd = "install";
-    std::string update_cmd = "update";
-    if (cmd == "install") {
-        mRequest = REQUEST_CENTRE::INSTALL;
-    }
-    else if( cmd == "update"){
-        std::cout << "\n Err - Update license action not supported.\n";
-        mRequest = REQUEST_CENTRE::UPDATE;
-    }
-    else if( (cmd == "deactivate")||(cmd == "purge") ){
-        std::cout << "\n WARN - deactivation | Purge license action requested.\n";
-        mRequest = REQUEST_CENTRE::PURGE;
+    if (cmd == "--batch")
+        return REQUEST_CENTRE::BATCH;
+    if (cmd == "install")
+        return REQUEST_CENTRE::INSTALL;
+    if (cmd == "update")
+        return REQUEST_CENTRE::UPDATE;
+    if ((cmd == "deactivate")||(cmd == "purge"))
+        return REQUEST_CENTRE::PURGE;
+    return REQUEST_CENTRE::VALIDATE;
+}
+
+REQUEST_CENTRE PresienLicense::_requestFromEnvironment(){
+    const char* val = std::getenv("VBSINSTALL");
+    return val != nullptr && string(val) == "1" ? REQUEST_CENTRE::INSTALL : REQUEST_CENTRE::VALIDATE;
+}
+
+void PresienLicense::ParseCmdArgs(int argc, char**argv){
+    mRequest = _requestFromArgs(argc, argv);
+    if( mRequest == REQUEST_CENTRE::UPDATE ){
+        PLOG_ERROR("Err - Update license action not supported.");
     }
-    else{
-        mRequest = REQUEST_CENTRE::VALIDATE;
+    else if( mRequest == REQUEST_CENTRE::PURGE ){
+        PLOG_WARN("WARN - deactivation | Purge license action requested.");
     }
 }
 
-void PresienLicense::UpdateDataStorePath() {
-    wstring currPath = m_licenseManager->licenseFilePath();
+bool PresienLicense::ValidatedByToken(int argc, char**argv){
+    // same resolution as ProcessRequest: no command is a validation, an install with
+    // VBSINSTALL=1; install starts with an offline validation and stops there when it passes
+    auto request = _requestFromArgs(argc, argv);
+    if (request == REQUEST_CENTRE::INVALID_ACTION)
+        request = _requestFromEnvironment();
+    if (request != REQUEST_CENTRE::VALIDATE && request != REQUEST_CENTRE::INSTALL)
+        return false;
+
+    ValidationToken token(VALIDATION_TOKEN_FILE, ValidationToken::TtlFromEnvironment());
+    if (!token.Enabled())
+        return false;
+    // cached fingerprint, no hardware probing on the fast path; the token itself checks the live
+    // device binding
+    const auto hardwareId = HardwareFingerprint::CreateDefault(PresienLicenseConfig::PRESIEN_HWID_CACHE_FILE).Resolve().id;
+    if (!token.Verify(hardwareId))
+        return false;
+    PLOG_INFO("Validated -------------------------");
+    PLOG_INFO("Local validation successful (validation token)");
+    return true;
+}
+
+void PresienLicense::UpdateDataStorePath(LicenseManager::ptr_t manager) {
+    wstring currPath = manager->licenseFilePath();
     wstring newPath = VIRTUAL_BLINDSIGHT_LIC_STORE_PATH + currPath;
     #ifdef __DEBUG
-        wcout << "\n Lic filepath = " << m_licenseManager->licenseFilePath() << std::endl;
-        wcout << "Lic file name = " << m_licenseManager->licenseFileName() << std::endl;
-        wcout << "localdatastorePath = " << localdatastorePath << std::endl;
-        wcout << "Lic newPath = " << newPath<< std::endl;
+        PLOG_DEBUG("Lic filepath = " << std::filesystem::path(manager->licenseFilePath()).string());
+        PLOG_DEBUG("Lic file name = " << std::filesystem::path(manager->licenseFileName()).string());
+        PLOG_DEBUG("Lic newPath = " << std::filesystem::path(newPath).string());
     #endif
-    m_licenseManager->setDataLocation(newPath);
+    manager->setDataLocation(newPath);
 }
 
 bool PresienLicense::ProcessRequest(){
@@ -87,17 +172,7 @@ bool PresienLicense::ProcessRequest(){
     if(mRequest == REQUEST_CENTRE::INVALID_ACTION){
         //AY - if no cmdline args provided, check env variables
         //even no env variable do offline validation.
-        mRequest = REQUEST_CENTRE::VALIDATE;
-        string req = "VBSINSTALL";
-        auto* val = std::getenv(req.c_str());
-        if ( val )
-        {
-            string ans = val;
-            if(ans == "1")
-            {
-                mRequest = REQUEST_CENTRE::INSTALL;
-            }
-        }
+        mRequest = _requestFromEnvironment();
     }
     
     if(mRequest == REQUEST_CENTRE::INVALID_ACTION)
@@ -134,8 +209,10 @@ bool PresienLicense::ProcessRequest(){
             case REQUEST_CENTRE::PURGE:
                 DeactivateLicense();
                 break;
+            case REQUEST_CENTRE::BATCH:
+                return RunBatch(std::cin, stdout);
             default:
-                std::cerr << "\n Default action not supported.\n";
+                PLOG_ERROR("Default action not supported.");
                 return false;
         }
         return true;
@@ -145,7 +222,7 @@ void PresienLicense::runOnline(bool dr ){
     auto license = m_licenseManager->getCurrentLicense();
     if (license)
     {
-        std::cout << "\nError - License is already installed.";
+        PLOG_ERROR("Error - License is already installed.");
         // return;
     }
 
@@ -155,13 +232,17 @@ void PresienLicense::runOnline(bool dr ){
     auto licenseId = LicenseID::fromKey(data["LicKeyValue"]);
     if (licenseId.isEmpty())
     {
-        std::cout << "\nError - Invalid License Key supplied.";
+        PLOG_ERROR("Error - Invalid License Key supplied.");
         return;
     }
 
-    license = m_licenseManager->activateLicense(licenseId);
-    license->addDeviceVariable( "TegraCpuUid", mConfig.GetTegraCpuUid() );
-    std::cout << "SUCCESS - License activated successfully.." << std::endl;
+    {
+        PRESIEN_SDK_TIMER(ACTIVATE_LICENSE);
+        license = m_licenseManager->activateLicense(licenseId);
+    }
+    PLOG_INFO("SUCCESS - License activated successfully..");
+    if (m_telemetry)
+        m_telemetry->ResetAcknowledged();
     // AY - required to send device variables
     updateAndCheckLicense(license);
 #ifdef __DEBUG
@@ -175,84 +256,141 @@ void PresienLicense::runOffline(bool dr ){
 }
 
 bool PresienLicense::InstallLicenseOnline(){
-    std::cout << "\nActivating Install mode -----------";
-    std::cout << "\nActivating ------------------------";
-    std::cout << "\nActivated Install mode ------------\n";
+    PLOG_INFO("Activating Install mode -----------");
+    PLOG_INFO("Activating ------------------------");
+    PLOG_INFO("Activated Install mode ------------");
     
-    if( !m_licenseManager->isOnline() )
+    if( !IsOnlineWithinBudget() )
     {
-        std::cout <<"\n Error - Offline system cannot install license.";
+        PLOG_ERROR("Error - Offline system cannot install license.");
         ValidateLicenseOffline();
         return false;
     }
 
-    std::cout <<"\n System is online -----";
+    PLOG_INFO("System is online -----");
+    _beginLicenseChange();
     runOnline();
     return true;
 }
 
 bool PresienLicense::ValidateLicenseOffline(){
-    std::cout <<std::endl<< "Validating offline mode -----------";
-    std::cout <<std::endl<< "Validated -------------------------\n";
+    PLOG_INFO("Validating offline mode -----------");
+    PLOG_INFO("Validated -------------------------");
 
     auto license = m_licenseManager->getCurrentLicense();
     if(!license){
-        std::cerr <<"\n Error - failed to get local license. License not installed.\n";
+        PLOG_ERROR("Error - failed to get local license. License not installed.");
         return false;
     }
 
     //Throw exception if failed local check
     checkLicenseLocal( license ); 
+    // floating registrations time out on the server, those keep doing the full check
+    if( !license->isFloating() )
+        mToken.Issue(mConfig.GetBasePtr()->getHardwareID(), std::filesystem::path(m_licenseManager->licenseFilePath()).string());
     return true;
 }
 
 bool PresienLicense::UpdateLicense(){
-    std::cout << "\n UpdateLicense -- to be implemented.";
+    PLOG_INFO("UpdateLicense -- to be implemented.");
     return false;
 }
 
 bool PresienLicense::DeactivateLicense(){
-    std::cout << "\n DeactivateLicense and removing from local store -- Online only.";
-    if( !m_licenseManager->isOnline() )
+    PLOG_INFO("DeactivateLicense and removing from local store -- Online only.");
+    if( !IsOnlineWithinBudget() )
     {
-        std::cout <<"\n Error - Offline system cannot deactivate license.";
+        PLOG_ERROR("Error - Offline system cannot deactivate license.");
         return false;
     }
     auto license = m_licenseManager->getCurrentLicense();
     if(!license){
-        std::cout <<"\nError - No local license found, nothing to remove.";
+        PLOG_ERROR("Error - No local license found, nothing to remove.");
         return false;
     }
+    mToken.Revoke();
     
+    _beginLicenseChange();
     updateAndCheckLicense( license );
     cleanUp( license );
     return true;
 }
 
 bool PresienLicense::ReadProductInfoFromServer(){
-    auto productInfo = m_licenseManager->getProductDetails(true);
-    if (AuthMethodKeyBased != productInfo.authorizationMethod())
+    const auto cacheFile = (std::filesystem::path(m_licenseManager->dataLocation()) / PRODUCT_DETAILS_CACHE).string();
+    auto licenseManager = m_licenseManager;
+    _applyNetworkTimeout();
+    // work may outlive this call, capture nothing from the stack by reference
+    bool fresh = mBudget.RunWithin("product details request", [licenseManager, cacheFile]{
+        ProductDetails productInfo;
+        {
+            PRESIEN_SDK_TIMER(GET_PRODUCT_DETAILS);
+            productInfo = licenseManager->getProductDetails(true);
+        }
+        saveProductDetails(cacheFile, productInfo);
+    });
+
+    nlohmann::json productInfo;
+    if (!loadProductDetails(cacheFile, productInfo))
+    {
+        PLOG_WARN("Product details not available yet, skipping product checks.");
+        return false;
+    }
+    if (!fresh)
+        PLOG_INFO("Using cached product details.");
+
+    if (AuthMethodKeyBased != productInfo["authorization_method"].get<int>())
     {
         throw("\n Exception - Only KeyBased authentication supported.");
         return false;
     }
 
 #ifdef __DEBUG
-        std::cout << "------------- Product info -------------" << std::endl;
-        std::cout << "Product name:             " << productInfo.productName() << std::endl;
-        std::cout << "Virtual machines allowed: " << productInfo.isVMAllowed() << std::endl;
-        std::cout << "Trial allowed:            " << productInfo.isTrialAllowed() << std::endl;
-        std::cout << "Metadata:                 " << productInfo.metadata() << std::endl;
+        PLOG_INFO("------------- Product info -------------");
+        PLOG_INFO("Product name:             " << productInfo.value("product_name", ""));
+        PLOG_INFO("Virtual machines allowed: " << productInfo.value("vm_allowed", false));
+        PLOG_INFO("Trial allowed:            " << productInfo.value("trial_allowed", false));
+        PLOG_INFO("Metadata:                 " << productInfo.value("metadata", ""));
 #endif
     return true;
 }
 
+void PresienLicense::_applyNetworkTimeout(){
+    auto config = mConfig.GetBasePtr();
+    if (mDefaultNetworkTimeout == 0)
+        mDefaultNetworkTimeout = config->getNetworkTimeout();
+    // a phase left in the background still reads the configuration, it keeps the timeout it
+    // started with, which the exhausted budget would lower to 1 s anyway
+    if (mBudget.HasBackground())
+        return;
+    config->setNetworkTimeout(mBudget.NetworkTimeoutSeconds(mDefaultNetworkTimeout));
+}
+
+void PresienLicense::_beginLicenseChange(){
+    // activation and deactivation run in the foreground with the SDK timeout, so their result
+    // and exceptions reach the caller; read-only phases still in the background finish first
+    mBudget.JoinBackground();
+    if (mDefaultNetworkTimeout != 0)
+        mConfig.GetBasePtr()->setNetworkTimeout(mDefaultNetworkTimeout);
+}
+
+bool PresienLicense::IsOnlineWithinBudget(){
+    auto online = std::make_shared<std::atomic<bool>>(false);
+    auto licenseManager = m_licenseManager;
+    _applyNetworkTimeout();
+    // an unfinished connectivity check counts as offline
+    mBudget.RunWithin("connectivity check", [licenseManager, online]{
+        *online = licenseManager->isOnline();
+    });
+    return online->load();
+}
+
 bool PresienLicense::ReadTargetPlatformVMInfo(){
 
     // Detect virtualized environment
     if (mConfig.isVMDetectionEnabled())
     {
-        std::cout << "Checking for virtual machines..." << std::endl;
+        PLOG_INFO("Checking for virtual machines...");
         std::string msg;
         if (mConfig.isVM())
         {
@@ -265,7 +403,7 @@ bool PresienLicense::ReadTargetPlatformVMInfo(){
         else
             msg = "Check passed, VM not detected.";
         
-        std::cout << msg << std::endl<< std::endl;
+        PLOG_INFO(msg);
     }
     return false;
 }
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "PresienLicenseHandle.h"
+#include "LicenseMetrics.h"
+#include "LicenseWatcher.h"
+#include "PresienLic.h"
+#include "PresienLog.h"
+
+#include <filesystem>
+
+using namespace LicenseSpring;
+using namespace PRESIEN::BlindSight;
+
+// SampleBase for its local check (device id upgrade, floating re-registration)
+class PresienLicenseHandle::Impl : public SampleBase{
+    public:
+        Impl(LicenseManager::ptr_t manager, const std::string& hardwareId)
+            :mHardwareId(hardwareId), mToken(PresienLicense::VALIDATION_TOKEN_FILE, ValidationToken::TtlFromEnvironment()),
+             mMetadata(manager){
+            m_licenseManager = std::move(manager);
+        }
+
+        void runOnline( bool ) override {}
+        void runOffline( bool ) override {}
+
+        License::ptr_t CurrentLicense() const { return m_licenseManager->getCurrentLicense(); }
+
+        bool Validate(){
+            if (mToken.Verify(mHardwareId))
+                return true;
+            auto license = CurrentLicense();
+            if (!license)
+            {
+                PLOG_ERROR("Error - failed to get local license. License not installed.");
+                return false;
+            }
+            checkLicenseLocal(license);
+            if (!license->isFloating())
+                mToken.Issue(mHardwareId, std::filesystem::path(m_licenseManager->licenseFilePath()).string());
+            return true;
+        }
+
+        MetadataIndex::SnapshotPtr Metadata(){
+            if (!mWatcher)
+            {
+                mWatcher = std::make_unique<LicenseWatcher>(m_licenseManager);
+                // reloads happen here under the handle mutex, never on the watch thread
+                mWatcher->SetDeferred(true);
+                mMetadata.Attach(*mWatcher);
+                mWatcher->Start();
+            }
+            return mMetadata.Current();
+        }
+
+        // Start of every handle call: changes presien-lic-app made to the license file
+        void ApplyFileChanges(){
+            if (mWatcher)
+                mWatcher->ReloadIfChanged();
+        }
+
+        // After calls that save the license file, so that save causes no reload
+        void AcknowledgeSave(){
+            if (mWatcher)
+                mWatcher->Acknowledge();
+        }
+
+    private:
+        std::string mHardwareId;
+        ValidationToken mToken;
+        std::unique_ptr<LicenseWatcher> mWatcher;
+        MetadataIndex mMetadata;                        // after mWatcher, unsubscribes first
+};
+
+PresienLicenseHandle::PresienLicenseHandle() = default;
+
+PresienLicenseHandle::~PresienLicenseHandle(){
+    Shutdown();
+}
+
+bool PresienLicenseHandle::Initialize(){
+    std::lock_guard<std::mutex> lock(mMutex);
+    return _initialize();
+}
+
+bool PresienLicenseHandle::_initialize(){
+    try
+    {
+        if (!mImpl)
+        {
+            PresienLicenseConfig config;
+            config.Initialize();
+            auto manager = LicenseManager::create(config.GetBasePtr());
+            PresienLicense::UpdateDataStorePath(manager);
+            mImpl = std::make_unique<Impl>(manager, config.GetBasePtr()->getHardwareID());
+        }
+        mImpl->ApplyFileChanges();
+        return mImpl->CurrentLicense() != nullptr;
+    }
+    catch (const LicenseSpringException& ex)
+    {
+        PLOG_ERROR("License handle initialization failed: " << ex.what());
+        return false;
+    }
+}
+
+bool PresienLicenseHandle::Initialized() const{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mImpl != nullptr;
+}
+
+bool PresienLicenseHandle::Validate(){
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!_initialize())
+        return false;
+    try
+    {
+        const bool valid = mImpl->Validate();
+        mImpl->AcknowledgeSave();
+        return valid;
+    }
+    catch (const LicenseSpringException& ex)
+    {
+        PLOG_ERROR("Local check failed: " << ex.what());
+        return false;
+    }
+}
+
+PresienLicenseHandle::FeatureStatus PresienLicenseHandle::QueryFeature(const std::string& featureCode){
+    FeatureStatus status;
+    status.code = featureCode;
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!_initialize())
+        return status;
+    try
+    {
+        const auto feature = mImpl->CurrentLicense()->feature(featureCode);
+        status.found = true;
+        status.expired = feature.isExpired();
+        status.consumption = feature.featureType() == FeatureTypeConsumption;
+        if (status.consumption)
+        {
+            status.totalConsumption = feature.totalConsumption();
+            status.maxConsumption = feature.maxConsumption();
+        }
+        status.floating = feature.isFloating() || feature.isOfflineFloating();
+        if (status.floating)
+        {
+            status.floatingUsers = feature.floatingUsers();
+            status.floatingInUse = feature.floatingInUseCount();
+        }
+    }
+    catch (const LicenseSpringException& ex)
+    {
+        PLOG_WARN("Feature " << featureCode << " not available: " << ex.what());
+    }
+    return status;
+}
+
+bool PresienLicenseHandle::Consume(const std::string& featureCode, int value, bool sync){
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!_initialize())
+        return false;
+    try
+    {
+        auto license = mImpl->CurrentLicense();
+        bool synced = true;
+        if (featureCode.empty())
+        {
+            license->updateConsumption(value);
+            if (sync)
+            {
+                PRESIEN_SDK_TIMER(SYNC_CONSUMPTION);
+                synced = license->syncConsumption();
+            }
+        }
+        else
+        {
+            license->updateFeatureConsumption(featureCode, value);
+            synced = !sync || license->syncFeatureConsumption(featureCode);
+        }
+        mImpl->AcknowledgeSave();
+        return synced;
+    }
+    catch (const LicenseSpringException& ex)
+    {
+        PLOG_ERROR("Consumption update failed: " << ex.what());
+        return false;
+    }
+}
+
+MetadataIndex::SnapshotPtr PresienLicenseHandle::Metadata(){
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!_initialize())
+        return nullptr;
+    return mImpl->Metadata();
+}
+
+void PresienLicenseHandle::Shutdown(){
+    std::lock_guard<std::mutex> lock(mMutex);
+    mImpl.reset();
+}
@@ -0,0 +1,213 @@
+#include "PresienLicenseSnapshot.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct FeatureStrings{
+        std::string code;
+        std::string name;
+        PresienFeatureSnapshot snapshot;
+    };
+
+    int64_t epoch(tm value){
+        // the SDK hands out a zeroed tm for dates a license does not have
+        if (value.tm_mday == 0)
+            return 0;
+        const auto seconds = timegm(&value);
+        return seconds > 0 ? static_cast<int64_t>(seconds) : 0;
+    }
+
+    std::string copy(const char* value){
+        return value ? std::string(value) : std::string();
+    }
+
+    uint32_t flag(bool set, uint32_t bit){
+        return set ? bit : 0u;
+    }
+
+    std::vector<FeatureStrings> readFeatures(LSLicenseHandler* handler){
+        std::vector<FeatureStrings> result;
+        if (!handler->hasLicenseFeatures(handler))
+            return result;
+        // first call counts, second one fills
+        const int count = handler->getLicenseFeatures(handler, nullptr);
+        if (count <= 0)
+            return result;
+        std::vector<LSLicenseFeature> features(static_cast<size_t>(count));
+        handler->getLicenseFeatures(handler, features.data());
+
+        result.reserve(features.size());
+        for (auto& feature : features)
+        {
+            FeatureStrings entry;
+            entry.code = copy(feature.code(&feature));
+            entry.name = copy(feature.name(&feature));
+            auto& out = entry.snapshot;
+            std::memset(&out, 0, sizeof(out));
+            const bool consumption = feature.featureType(&feature) == FeatureTypeConsumption;
+            out.flags = flag(feature.isExpired(&feature), PRESIEN_FEATURE_EXPIRED)
+                      | flag(consumption, PRESIEN_FEATURE_CONSUMPTION)
+                      | flag(feature.isFloating(&feature), PRESIEN_FEATURE_FLOATING)
+                      | flag(feature.isOfflineFloating(&feature), PRESIEN_FEATURE_OFFLINE_FLOATING);
+            out.expiryDate = epoch(feature.expiryDateUtc(&feature));
+            if (consumption)
+            {
+                out.flags |= flag(feature.isOveragesAllowed(&feature), PRESIEN_FEATURE_OVERAGES_ALLOWED)
+                           | flag(feature.isUnlimitedConsumptionAllowed(&feature), PRESIEN_FEATURE_UNLIMITED_CONSUMPTION);
+                out.totalConsumption = feature.totalConsumption(&feature);
+                out.maxConsumption = feature.maxConsumption(&feature);
+                out.localConsumption = feature.localConsumption(&feature);
+                out.maxOverages = feature.maxOverages(&feature);
+            }
+            if (out.flags & (PRESIEN_FEATURE_FLOATING | PRESIEN_FEATURE_OFFLINE_FLOATING))
+            {
+                out.floatingUsers = feature.floatingUsers(&feature);
+                out.floatingInUse = feature.floatingInUseCount(&feature);
+                out.floatingTimeout = feature.floatingTimeout(&feature);
+                out.floatingEndDate = epoch(feature.floatingEndDateTimeUtc(&feature));
+            }
+            result.push_back(std::move(entry));
+        }
+        std::sort(result.begin(), result.end(), [](const FeatureStrings& a, const FeatureStrings& b){ return a.code < b.code; });
+        return result;
+    }
+
+    // One allocation for the feature array followed by every string
+    void* buildBlock(PresienLicenseSnapshot& snapshot, std::vector<FeatureStrings>& features,
+                     const std::vector<std::string>& strings, uint32_t parts){
+        const bool withFeatures = (parts & PRESIEN_SNAPSHOT_FEATURES) && !features.empty();
+        const bool withStrings = (parts & PRESIEN_SNAPSHOT_STRINGS) != 0;
+        if (!withFeatures && !withStrings)
+            return nullptr;
+
+        size_t size = withFeatures ? features.size() * sizeof(PresienFeatureSnapshot) : 0;
+        if (withFeatures)
+        {
+            for (const auto& feature : features)
+                size += feature.code.size() + feature.name.size() + 2;
+        }
+        if (withStrings)
+        {
+            for (const auto& value : strings)
+                size += value.size() + 1;
+        }
+
+        auto* block = static_cast<char*>(std::malloc(size));
+        if (!block)
+            return nullptr;
+        char* text = block + (withFeatures ? features.size() * sizeof(PresienFeatureSnapshot) : 0);
+        auto append = [&text](const std::string& value){
+            std::memcpy(text, value.c_str(), value.size() + 1);
+            const char* start = text;
+            text += value.size() + 1;
+            return start;
+        };
+        if (withFeatures)
+        {
+            auto* array = reinterpret_cast<PresienFeatureSnapshot*>(block);
+            for (size_t i = 0; i < features.size(); ++i)
+            {
+                array[i] = features[i].snapshot;
+                array[i].code = append(features[i].code);
+                array[i].name = append(features[i].name);
+            }
+            snapshot.features = array;
+        }
+        if (withStrings)
+        {
+            snapshot.key = append(strings[0]);
+            snapshot.user = append(strings[1]);
+            snapshot.status = append(strings[2]);
+        }
+        return block;
+    }
+}
+
+int PresienLicenseSnapshotQuery(LSLicenseHandler* handler, PresienLicenseSnapshot* out, uint32_t parts){
+    if (!handler || !out || out->size < offsetof(PresienLicenseSnapshot, flags))
+        return -1;
+    if (!handler->isLicenseExists(handler))
+        return handler->wasError(handler) ? handler->getLastError(handler) : eLicenseNotFound;
+
+    PresienLicenseSnapshot snapshot;
+    std::memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.size = out->size;
+    snapshot.version = PRESIEN_LICENSE_SNAPSHOT_VERSION;
+    snapshot.flags = flag(handler->isLicenseValid(handler), PRESIEN_LICENSE_VALID)
+                   | flag(handler->isLicenseActive(handler), PRESIEN_LICENSE_ACTIVE)
+                   | flag(handler->isLicenseEnabled(handler), PRESIEN_LICENSE_ENABLED)
+                   | flag(handler->isLicenseExpired(handler), PRESIEN_LICENSE_EXPIRED)
+                   | flag(handler->isLicenseTrial(handler), PRESIEN_LICENSE_TRIAL)
+                   | flag(handler->isLicenseFloating(handler), PRESIEN_LICENSE_FLOATING)
+                   | flag(handler->isLicenseBorrowed(handler), PRESIEN_LICENSE_BORROWED)
+                   | flag(handler->isLicenseOfflineActivated(handler), PRESIEN_LICENSE_OFFLINE_ACTIVATED)
+                   | flag(handler->isLicenseAirGapped(handler), PRESIEN_LICENSE_AIR_GAPPED)
+                   | flag(handler->isGracePeriodStarted(handler), PRESIEN_LICENSE_GRACE_PERIOD)
+                   | flag(handler->isLicenseMaintenanceExpired(handler), PRESIEN_LICENSE_MAINTENANCE_EXPIRED)
+                   | flag(handler->isLicenseOveragesAllowed(handler), PRESIEN_LICENSE_OVERAGES_ALLOWED)
+                   | flag(handler->isLicenseUnlimitedConsumptionAllowed(handler), PRESIEN_LICENSE_UNLIMITED_CONSUMPTION)
+                   | flag(handler->isLicenseVMAllowed(handler), PRESIEN_LICENSE_VM_ALLOWED);
+    snapshot.licenseType = static_cast<int32_t>(handler->getLicenseType(handler));
+
+    snapshot.validityPeriod = epoch(handler->getLicenseExpiryDateUtc(handler));
+    snapshot.validityWithGracePeriod = epoch(handler->validityWithGracePeriodUtc(handler));
+    snapshot.maintenancePeriod = epoch(handler->getLicenseMaintenancePeriodUtc(handler));
+    snapshot.lastCheckDate = epoch(handler->getLicenseLastCheckDateUtc(handler));
+    snapshot.daysRemaining = handler->getDaysRemaining(handler);
+    snapshot.maintenanceDaysRemaining = handler->getMaintenanceDaysRemaining(handler);
+    snapshot.daysSinceLastCheck = handler->getDaysPassedSinceLastCheck(handler);
+    if (snapshot.flags & PRESIEN_LICENSE_GRACE_PERIOD)
+    {
+        snapshot.gracePeriodEndDate = epoch(handler->gracePeriodEndDateTimeUTC(handler));
+        snapshot.gracePeriodHoursRemaining = handler->gracePeriodHoursRemaining(handler);
+    }
+
+    snapshot.totalConsumption = handler->getLicenseTotalConsumption(handler);
+    snapshot.maxConsumption = handler->getLicenseMaxConsumption(handler);
+    snapshot.maxOverages = handler->getLicenseMaxOverages(handler);
+    if (snapshot.flags & PRESIEN_LICENSE_FLOATING)
+    {
+        snapshot.floatingEndDate = epoch(handler->getLicenseFloatingEndDateTimeUtc(handler));
+        snapshot.floatingTimeout = static_cast<uint32_t>(handler->getLicenseFloatingTimeout(handler));
+        snapshot.floatingInUse = static_cast<uint32_t>(handler->getLicenseFloatingInUseCount(handler));
+        snapshot.maxFloatingUsers = static_cast<uint32_t>(handler->getLicenseMaxFloatingUsers(handler));
+    }
+
+    auto features = readFeatures(handler);
+    snapshot.featureCount = static_cast<uint32_t>(features.size());
+    for (size_t i = 0; i < features.size() && i < 64; ++i)
+    {
+        if (!(features[i].snapshot.flags & PRESIEN_FEATURE_EXPIRED))
+            snapshot.featureBitmap |= uint64_t(1) << i;
+    }
+
+    std::vector<std::string> strings;
+    if (parts & PRESIEN_SNAPSHOT_STRINGS)
+        strings = {copy(handler->getLicenseKey(handler)), copy(handler->getLicenseUser(handler)), copy(handler->getLicenseStatusStr(handler))};
+    if (handler->wasError(handler))
+        return handler->getLastError(handler);
+
+    // the pointers must fit, otherwise the caller could never release the block
+    if (out->size >= offsetof(PresienLicenseSnapshot, block) + sizeof(void*))
+        snapshot.block = buildBlock(snapshot, features, strings, parts);
+    std::memcpy(out, &snapshot, std::min<size_t>(out->size, sizeof(snapshot)));
+    return 0;
+}
+
+void PresienLicenseSnapshotRelease(PresienLicenseSnapshot* snapshot){
+    if (!snapshot || snapshot->size < offsetof(PresienLicenseSnapshot, block) + sizeof(void*))
+        return;
+    std::free(snapshot->block);
+    snapshot->block = nullptr;
+    snapshot->features = nullptr;
+    snapshot->key = nullptr;
+    snapshot->user = nullptr;
+    snapshot->status = nullptr;
+}
@@ -0,0 +1,262 @@
+#include "PresienLog.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <string.h>
+#include <syslog.h>
+
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    std::string getEnv(const char* var){
+        const char* val = std::getenv(var);
+        return val ? val : "";
+    }
+
+    std::string toLower(std::string value){
+        for (auto& c : value)
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return value;
+    }
+
+    const char* levelName(LogLevel level){
+        switch (level)
+        {
+            case LogLevel::TRACE: return "TRACE";
+            case LogLevel::DEBUG: return "DEBUG";
+            case LogLevel::INFO: return "INFO";
+            case LogLevel::WARN: return "WARN";
+            case LogLevel::ERROR: return "ERROR";
+            default: return "OFF";
+        }
+    }
+
+    int syslogPriority(LogLevel level){
+        switch (level)
+        {
+            case LogLevel::TRACE:
+            case LogLevel::DEBUG: return LOG_DEBUG;
+            case LogLevel::INFO: return LOG_INFO;
+            case LogLevel::WARN: return LOG_WARNING;
+            default: return LOG_ERR;
+        }
+    }
+
+    void appendTime(std::string& out, std::chrono::system_clock::time_point time){
+        auto seconds = std::chrono::system_clock::to_time_t(time);
+        auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count() % 1000;
+        tm utc{};
+        gmtime_r(&seconds, &utc);
+        char buffer[32];
+        auto len = strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+        out.append(buffer, len);
+        snprintf(buffer, sizeof(buffer), ".%03dZ", static_cast<int>(millis));
+        out.append(buffer);
+    }
+
+    void appendJsonString(std::string& out, const std::string& value){
+        out += '"';
+        for (unsigned char c : value)
+        {
+            switch (c)
+            {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (c < 0x20)
+                    {
+                        char buffer[8];
+                        snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                        out += buffer;
+                    }
+                    else
+                        out += static_cast<char>(c);
+            }
+        }
+        out += '"';
+    }
+}
+
+Logger::Logger():mRing(new Cell[CAPACITY]){
+    for (size_t i = 0; i < CAPACITY; ++i)
+        mRing[i].seq.store(i, std::memory_order_relaxed);
+
+    auto level = toLower(getEnv("VBSLOGLEVEL"));
+    if (level == "trace") mLevel = LogLevel::TRACE;
+    else if (level == "debug") mLevel = LogLevel::DEBUG;
+    else if (level == "warn") mLevel = LogLevel::WARN;
+    else if (level == "error") mLevel = LogLevel::ERROR;
+    else if (level == "off") mLevel = LogLevel::OFF;
+
+    if (toLower(getEnv("VBSLOGFORMAT")) == "json")
+        mFormat = LogFormat::JSON;
+
+    if (getEnv("VBSLOGSTDOUT") == "0")
+        mConsole = nullptr;
+    auto file = getEnv("VBSLOGFILE");
+    if (!file.empty())
+        mFile = fopen(file.c_str(), "a");
+    if (getEnv("VBSLOGSYSLOG") == "1")
+    {
+        // rsyslog is part of the docker image
+        mSyslog = true;
+        openlog("presien-lic-app", LOG_PID, LOG_USER);
+    }
+
+    mWriter = std::thread([this]{
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        while (!mStop.load())
+        {
+            lock.unlock();
+            _drain();
+            lock.lock();
+            mWakeCv.wait_for(lock, std::chrono::milliseconds(50));
+        }
+        lock.unlock();
+        _drain();
+    });
+}
+
+Logger::~Logger(){
+    mStop = true;
+    mWakeCv.notify_one();
+    if (mWriter.joinable())
+        mWriter.join();
+    if (mFile)
+        fclose(mFile);
+    if (mSyslog)
+        closelog();
+}
+
+bool Logger::_tryPush(LogRecord& record){
+    size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell& cell = mRing[pos & (CAPACITY - 1)];
+        size_t seq = cell.seq.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0)
+        {
+            if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                cell.record = std::move(record);
+                cell.seq.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+            return false; // full
+        else
+            pos = mEnqueuePos.load(std::memory_order_relaxed);
+    }
+}
+
+bool Logger::_tryPop(LogRecord& record){
+    Cell& cell = mRing[mDequeuePos & (CAPACITY - 1)];
+    size_t seq = cell.seq.load(std::memory_order_acquire);
+    if (seq != mDequeuePos + 1)
+        return false; // empty or producer still writing
+    record = std::move(cell.record);
+    cell.seq.store(mDequeuePos + CAPACITY, std::memory_order_release);
+    ++mDequeuePos;
+    return true;
+}
+
+void Logger::Submit(LogLevel level, const char* file, int line, std::string message){
+    LogRecord record;
+    record.level = level;
+    record.time = std::chrono::system_clock::now();
+    record.file = file;
+    record.line = line;
+    record.message = std::move(message);
+    if (!_tryPush(record))
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+    else if (level >= LogLevel::ERROR)
+        mWakeCv.notify_one();
+}
+
+void Logger::_write(const LogRecord& record, std::string& out) const{
+    if (mFormat.load(std::memory_order_relaxed) == LogFormat::JSON)
+    {
+        out += "{\"ts\":\"";
+        appendTime(out, record.time);
+        out += "\",\"level\":\"";
+        out += levelName(record.level);
+        out += "\",\"src\":\"";
+        const char* base = strrchr(record.file, '/');
+        out += base ? base + 1 : record.file;
+        out += ':';
+        out += std::to_string(record.line);
+        out += "\",\"msg\":";
+        appendJsonString(out, record.message);
+        out += "}\n";
+    }
+    else
+    {
+        appendTime(out, record.time);
+        out += ' ';
+        out += levelName(record.level);
+        out += ' ';
+        out += record.message;
+        out += '\n';
+    }
+}
+
+void Logger::_drain(){
+    std::string batch;
+    LogRecord record;
+    size_t count = 0;
+    while (_tryPop(record))
+    {
+        _write(record, batch);
+        if (mSyslog)
+            syslog(syslogPriority(record.level), "%s", record.message.c_str());
+        ++count;
+    }
+
+    auto dropped = mDropped.exchange(0, std::memory_order_relaxed);
+    if (dropped)
+    {
+        LogRecord note;
+        note.level = LogLevel::WARN;
+        note.time = std::chrono::system_clock::now();
+        note.message = "log ring buffer full, dropped " + std::to_string(dropped) + " records";
+        _write(note, batch);
+    }
+
+    if (!batch.empty())
+    {
+        // one write and flush per batch instead of std::endl per line
+        if (auto* console = mConsole.load(std::memory_order_relaxed))
+        {
+            fwrite(batch.data(), 1, batch.size(), console);
+            fflush(console);
+        }
+        if (mFile)
+        {
+            fwrite(batch.data(), 1, batch.size(), mFile);
+            fflush(mFile);
+        }
+    }
+
+    if (count)
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mWritten.fetch_add(count, std::memory_order_release);
+        mFlushedCv.notify_all();
+    }
+}
+
+void Logger::Flush(){
+    // records are enqueued in order, so everything up to target is in the ring or written
+    const size_t target = mEnqueuePos.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(mWakeMutex);
+    mWakeCv.notify_one();
+    while (mWritten.load(std::memory_order_acquire) < target && !mStop.load())
+        mFlushedCv.wait_for(lock, std::chrono::milliseconds(10));
+}
@@ -0,0 +1,252 @@
+#include "RefreshIngest.h"
+#include "PresienLog.h"
+
+#include <LicenseSpring/Exceptions.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <json/json.hpp>
+
+using namespace LicenseSpring;
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    constexpr const char* APPLIED_DIR = "applied";
+    constexpr const char* QUARANTINE_DIR = "quarantine";
+
+    bool isRefreshFile(const std::string& name){
+        return name.size() > 4 && name[0] != '.' && name.compare(name.size() - 4, 4, ".lic") == 0;
+    }
+
+    std::string isoNow(){
+        const auto now = std::time(nullptr);
+        tm utc{};
+        gmtime_r(&now, &utc);
+        return TmToString(utc, "%Y-%m-%dT%H:%M:%SZ");
+    }
+}
+
+RefreshIngest::RefreshIngest(LicenseRegistry& registry, const std::string& dropDir)
+    :mRegistry(registry), mDropDir(dropDir){
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(mDropDir) / APPLIED_DIR, ec);
+    std::filesystem::create_directories(std::filesystem::path(mDropDir) / QUARANTINE_DIR, ec);
+}
+
+RefreshIngest::~RefreshIngest(){
+    Stop();
+    // queued applies reference this object
+    std::unique_lock<std::mutex> lock(mInFlightMutex);
+    mInFlightCv.wait(lock, [this]{ return mInFlight.empty(); });
+}
+
+RefreshIngest::Stats RefreshIngest::ProcessExisting(){
+    const auto before = Totals();
+    std::vector<std::future<bool>> pending;
+    std::error_code ec;
+    for (const auto& file : std::filesystem::directory_iterator(mDropDir, ec))
+    {
+        const auto name = file.path().filename().string();
+        if (file.is_regular_file() && isRefreshFile(name))
+            pending.push_back(_submit(name));
+    }
+
+    for (auto& future : pending)
+        future.get();
+    const auto after = Totals();
+    const Stats stats{after.applied - before.applied, after.quarantined - before.quarantined};
+    PLOG_INFO("Refresh ingest of " << mDropDir << ": " << stats.applied << " applied, " << stats.quarantined << " quarantined");
+    return stats;
+}
+
+std::future<bool> RefreshIngest::_submit(const std::string& name){
+    {
+        std::lock_guard<std::mutex> lock(mInFlightMutex);
+        if (!mInFlight.insert(name).second)
+        {
+            std::promise<bool> duplicate;
+            duplicate.set_value(false);
+            return duplicate.get_future();
+        }
+    }
+    return mRegistry.Pool().Submit([this, name]{
+        bool applied = false;
+        try
+        {
+            // already handled by an earlier event for the same name
+            if (std::filesystem::exists(std::filesystem::path(mDropDir) / name))
+                applied = _apply(name);
+        }
+        catch (const std::exception& ex)
+        {
+            _quarantine(name, ex.what());
+        }
+        // notified under the lock, the destructor may destroy the cv as soon as it is released
+        std::lock_guard<std::mutex> lock(mInFlightMutex);
+        mInFlight.erase(name);
+        mInFlightCv.notify_all();
+        return applied;
+    });
+}
+
+bool RefreshIngest::_apply(const std::string& name){
+    const auto path = (std::filesystem::path(mDropDir) / name).string();
+    const auto stem = std::filesystem::path(name).stem().string();
+
+    // named after the device first, then whoever accepts it
+    std::vector<LicenseRegistry::Key> candidates;
+    const auto at = stem.find('@');
+    const auto keys = mRegistry.Keys();
+    for (const auto& key : keys)
+    {
+        if (at != std::string::npos ? (key.productCode == stem.substr(0, at) && key.hardwareId == stem.substr(at + 1)) : key.hardwareId == stem)
+            candidates.push_back(key);
+    }
+    const bool named = !candidates.empty();
+    if (!named)
+        candidates = keys;
+
+    std::string lastError = "no license store in the registry";
+    for (const auto& key : candidates)
+    {
+        auto manager = mRegistry.Get(key);
+        auto updateMutex = mRegistry.UpdateMutex(key);
+        if (!manager || !updateMutex)
+            continue;
+        // unnamed files are offered to every entry from several pool threads at once
+        std::unique_lock<std::mutex> lock(*updateMutex);
+        auto license = manager->getCurrentLicense();
+        if (!license)
+        {
+            lastError = "no license installed for " + key.productCode + "/" + key.hardwareId;
+            continue;
+        }
+        try
+        {
+            if (!license->updateOffline(std::filesystem::path(path).wstring()))
+            {
+                lastError = "refresh file rejected by " + key.productCode + "/" + key.hardwareId;
+                continue;
+            }
+        }
+        catch (const LicenseSpringException& ex)
+        {
+            lastError = ex.what();
+            continue;
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(path, std::filesystem::path(mDropDir) / APPLIED_DIR / name, ec);
+        _publish(key, license);
+        ++mApplied;
+        PLOG_INFO("Refresh file " << name << " applied to " << key.productCode << "/" << key.hardwareId);
+        return true;
+    }
+    _quarantine(name, named ? lastError : "no registry entry accepted it, last error: " + lastError);
+    return false;
+}
+
+void RefreshIngest::_quarantine(const std::string& name, const std::string& reason){
+    const auto target = std::filesystem::path(mDropDir) / QUARANTINE_DIR / name;
+    std::error_code ec;
+    std::filesystem::rename(std::filesystem::path(mDropDir) / name, target, ec);
+    std::ofstream os(target.string() + ".error", std::ios::trunc);
+    os << isoNow() << " " << reason << std::endl;
+    ++mQuarantined;
+    PLOG_WARN("Refresh file " << name << " quarantined: " << reason);
+}
+
+void RefreshIngest::_publish(const LicenseRegistry::Key& key, License::ptr_t license){
+    nlohmann::json snapshot;
+    snapshot["product"] = key.productCode;
+    snapshot["hardware_id"] = key.hardwareId;
+    snapshot["key"] = license->key();
+    snapshot["valid"] = license->isValid();
+    snapshot["expired"] = license->isExpired();
+    snapshot["trial"] = license->isTrial();
+    snapshot["days_remaining"] = license->daysRemaining();
+    snapshot["validity_period"] = TmToString(license->validityPeriod(), "%Y-%m-%dT%H:%M:%S");
+    snapshot["updated_at"] = isoNow();
+
+    const auto path = std::filesystem::path(mRegistry.StoreDirectory(key)) / "snapshot.json";
+    const auto tmpPath = path.string() + ".tmp";
+    {
+        std::ofstream os(tmpPath, std::ios::trunc);
+        os << snapshot.dump();
+    }
+    std::rename(tmpPath.c_str(), path.c_str());
+
+    if (mOnApplied)
+        mOnApplied(key, license);
+}
+
+bool RefreshIngest::Start(){
+    Stop();
+    mInotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    mStopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mInotifyFd < 0 || mStopFd < 0 || inotify_add_watch(mInotifyFd, mDropDir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        PLOG_ERROR("Cannot watch " << mDropDir);
+        Stop();
+        return false;
+    }
+    mWatcher = std::thread([this]{ _watch(); });
+    // files which arrived before the watch existed
+    ProcessExisting();
+    return true;
+}
+
+void RefreshIngest::Stop(){
+    if (mStopFd >= 0)
+    {
+        uint64_t one = 1;
+        if (write(mStopFd, &one, sizeof(one)) < 0)
+            PLOG_WARN("Cannot signal refresh ingest watcher");
+    }
+    if (mWatcher.joinable())
+        mWatcher.join();
+    if (mInotifyFd >= 0)
+        close(mInotifyFd);
+    if (mStopFd >= 0)
+        close(mStopFd);
+    mInotifyFd = mStopFd = -1;
+}
+
+void RefreshIngest::_watch(){
+    alignas(inotify_event) char buffer[16 * 1024];
+    pollfd fds[2] = {{mInotifyFd, POLLIN, 0}, {mStopFd, POLLIN, 0}};
+    for (;;)
+    {
+        if (poll(fds, 2, -1) < 0 && errno != EINTR)
+            return;
+        if (fds[1].revents & POLLIN)
+            return;
+        if (!(fds[0].revents & POLLIN))
+            continue;
+        ssize_t length;
+        while ((length = read(mInotifyFd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* p = buffer; p < buffer + length;)
+            {
+                auto* event = reinterpret_cast<inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+                if (event->len == 0 || (event->mask & IN_ISDIR))
+                    continue;
+                const std::string name(event->name);
+                if (isRefreshFile(name))
+                    _submit(name);
+            }
+        }
+    }
+}
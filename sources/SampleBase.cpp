@@ -1,5 +1,12 @@
 #include "SampleBase.h"
-#include <iostream>
+#include "LicenseMetrics.h"
+#include "PackageDelta.h"
+#include "PackageDownloader.h"
+#include "PresienLog.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <stdexcept>
 #include <thread>
 
 using namespace LicenseSpring;
@@ -16,33 +23,34 @@ SampleBase::SampleBase( )
 
 void SampleBase::checkLicenseLocal( License::ptr_t license )
 {
-    std::cout << "License successfully loaded, performing local check of the license..." << std::endl;
+    PLOG_INFO( "License successfully loaded, performing local check of the license..." );
     // it's highly recommended to perform a localCheck (offline check) on every startup
     // to be ensure that license file wasn't copied from another computer and license in a valid state
     try
     {
+        PRESIEN_SDK_TIMER( LOCAL_CHECK );
         license->localCheck(); // throws exceptions in case of errors, see documentation
     }
     catch( const DeviceNotLicensedException& ex )
     {
         // Below is an example on how to upgrade to new or other device id algorithm
-        std::cout << "Local check failed: " << ex.what() << std::endl;
-        std::cout << "Trying to upgrade to newer device id algorithm..." << std::endl;
+        PLOG_ERROR( "Local check failed: " << ex.what() );
+        PLOG_INFO( "Trying to upgrade to newer device id algorithm..." );
         license = m_licenseManager->relinkLicense( WinCryptographyId );
-        std::cout << "License successfully linked to new device id." << std::endl;
+        PLOG_INFO( "License successfully linked to new device id." );
         return;
     }
     catch( const FloatingTimeoutExpiredException& ex )
     {
-        std::cout << ex.what() << std::endl;
+        PLOG_WARN( ex.what() );
         auto endDate = TmToStr( license->floatingEndDateTime() );
-        std::cout << "Registration of this floating license has expired at: " << endDate << std::endl;
-        std::cout << "Trying to register floating license..." << std::endl;
+        PLOG_INFO( "Registration of this floating license has expired at: " << endDate );
+        PLOG_INFO( "Trying to register floating license..." );
         license->registerFloatingLicense(); // this call is equivalent to online license check
-        std::cout << "License successfully checked in" << std::endl;
+        PLOG_INFO( "License successfully checked in" );
         return;
     }
-    std::cout << "Local validation successful" << std::endl;
+    PLOG_INFO( "Local validation successful" );
 }
 
 void SampleBase::updateAndCheckLicense( License::ptr_t license )
@@ -51,6 +59,7 @@ void SampleBase::updateAndCheckLicense( License::ptr_t license )
     if( license->type() == LicenseTypeConsumption )
     {
         license->updateConsumption( 1 );
+        PRESIEN_SDK_TIMER( SYNC_CONSUMPTION );
         license->syncConsumption(); // this call is not necessary, consumption will be synced during online check
     }
 
@@ -68,43 +77,58 @@ void SampleBase::updateAndCheckLicense( License::ptr_t license )
         if( !(feature.isFloating() || feature.isOfflineFloating()) )
             continue;
 
-        std::cout << "Registering floating feature " << feature.code() << std::endl;
-        license->registerFloatingFeature( feature.code() );
+        PLOG_INFO( "Registering floating feature " << feature.code() );
+        {
+            PRESIEN_SDK_TIMER( REGISTER_FLOATING_FEATURE );
+            license->registerFloatingFeature( feature.code() );
+        }
         // need to reload feature
         auto updatedFeature = license->feature( feature.code() );
-        std::cout << updatedFeature.toString() << std::endl;
+        PLOG_INFO( updatedFeature.toString() );
 
-        std::cout << "Releasing floating feature " << feature.code() << std::endl;
+        PLOG_INFO( "Releasing floating feature " << feature.code() );
         license->releaseFloatingFeature( feature.code() );
         updatedFeature = license->feature( feature.code() );
-        std::cout << updatedFeature.toString() << std::endl;
+        PLOG_INFO( updatedFeature.toString() );
     }
 
     // Sync license with the platform
-    std::cout << "Checking license online..." << std::endl;
+    PLOG_INFO( "Checking license online..." );
     bool includeExpiredFeatures = false;
-    license->check( InstallFileFilter(), includeExpiredFeatures ); // throws exceptions in case of errors
-    std::cout << "License successfully checked" << std::endl;
+    {
+        PRESIEN_SDK_TIMER( CHECK );
+        license->check( InstallFileFilter(), includeExpiredFeatures ); // throws exceptions in case of errors
+    }
+    PLOG_INFO( "License successfully checked" );
     if( license->isGracePeriodStarted() )
     {
-        std::cout << "Grace period started!" << std::endl;
-        std::cout << license->gracePeriodHoursRemaining() << " hours till the end of grace period." << std::endl;
-        std::cout << "Grace period end date time: " << TmToStr( license->gracePeriodEndDateTime() ) << std::endl;
+        PLOG_INFO( "Grace period started!" );
+        PLOG_INFO( license->gracePeriodHoursRemaining() << " hours till the end of grace period." );
+        PLOG_INFO( "Grace period end date time: " << TmToStr( license->gracePeriodEndDateTime() ) );
     }
 
     // Example of sending and getting custom data to the LS backend (see device variables on the platform)
-    std::cout << "Sending custom data to the LicenseSpring..." << std::endl;
-    auto approxCoreCount = std::thread::hardware_concurrency();
-    license->addDeviceVariable( "CPU_Cores", std::to_string( approxCoreCount ) );
-    license->sendDeviceVariables();
+    PLOG_INFO( "Sending custom data to the LicenseSpring..." );
+    if( m_telemetry )
+    {
+        // only variables changed since the last acknowledged send go out, in one batch
+        m_telemetry->Sample();
+        PLOG_INFO( "Device variables sent: " << m_telemetry->Flush( license ) );
+    }
+    else
+    {
+        auto approxCoreCount = std::thread::hardware_concurrency();
+        license->addDeviceVariable( "CPU_Cores", std::to_string( approxCoreCount ) );
+        license->sendDeviceVariables();
+    }
     // bool argument below means request variables list from the backend
     auto deviceVariables = license->getDeviceVariables( true );
     for( const auto& variable : deviceVariables )
     {
-        std::cout << "Device variable: " << variable.name() << ", value: "
-            << variable.value() << ", last time updated: " << TmToStr( variable.dateTimeUpdated() ) << std::endl;
+        PLOG_INFO( "Device variable: " << variable.name() << ", value: "
+            << variable.value() << ", last time updated: " << TmToStr( variable.dateTimeUpdated() ) );
     }
-    std::cout << "Operation completed successfully" << std::endl;
+    PLOG_INFO( "Operation completed successfully" );
 }
 
 void SampleBase::setupAutomaticLicenseUpdates( License::ptr_t license )
@@ -123,11 +147,11 @@ void SampleBase::setupAutomaticLicenseUpdates( License::ptr_t license )
         {
             // Attention, do not capture License::ptr_t (shared_ptr), this will lead to problems.
 
-            std::cout << std::endl << "License check failed: " << ex.what() << std::endl;
+            PLOG_ERROR( "License check failed: " << ex.what() );
 
             if( ex.getCode() == eMaxFloatingReached )
             {
-                std::cout << "Application cannot use this license at the moment because floating license limit reached." << std::endl;
+                PLOG_ERROR( "Application cannot use this license at the moment because floating license limit reached." );
                 exit( 0 );
             }
 
@@ -153,7 +177,7 @@ void SampleBase::setupAutomaticFloatingFeatureUpdates( License::ptr_t license )
                                    {
                                        // Attention, do not capture License::ptr_t (shared_ptr), this will lead to problems.
 
-                                       std::cout << std::endl << "License check failed: " << ex.what() << std::endl;
+                                       PLOG_ERROR( "License check failed: " << ex.what() );
 
                                        // Ignore other errors and continue running watchdog if possible
                                        if( auto pLicense = wpLicense.lock() )
@@ -169,15 +193,18 @@ void SampleBase::setupAutomaticFloatingFeatureUpdates( License::ptr_t license )
     try
     {
         for (const std::string &featureCode: featureCodes)
+        {
+            PRESIEN_SDK_TIMER( REGISTER_FLOATING_FEATURE );
             license->registerFloatingFeature(featureCode);
+        }
     }
     catch ( const LicenseSpring::MaxFloatingReachedException& e )
     {
-        std::cout << "Error while checking floating feature: max floating reached!" << std::endl;
+        PLOG_ERROR( "Error while checking floating feature: max floating reached!" );
     }
     catch( const LicenseSpring::LicenseSpringException& e )
     {
-        std::cout << "Error while checking floating feature: " << ' ' << e.getCode() << ' ' << e.what() << std::endl;
+        PLOG_ERROR( "Error while checking floating feature: " << ' ' << e.getCode() << ' ' << e.what() );
     }
 
     // sleep for 100 seconds and check features in the meantime
@@ -190,7 +217,7 @@ void SampleBase::setupAutomaticFloatingFeatureUpdates( License::ptr_t license )
     }
     catch( const LicenseSpring::LicenseSpringException& e )
     {
-        std::cout << "Error while releasing floating feature: " << ' ' << e.getCode() << ' ' << e.what() << std::endl;
+        PLOG_ERROR( "Error while releasing floating feature: " << ' ' << e.getCode() << ' ' << e.what() );
     }
 
     license->stopFeatureWatchdog();
@@ -199,25 +226,24 @@ void SampleBase::setupAutomaticFloatingFeatureUpdates( License::ptr_t license )
 void SampleBase::cleanUp( License::ptr_t license )
 {
     if( license->deactivate( true ) )
-        std::cout << "License deactivated successfully." << std::endl << std::endl;
+        PLOG_INFO( "License deactivated successfully." );
 }
 
 void SampleBase::cleanUpLocal( License::ptr_t license )
 {
     auto filePath = license->deactivateOffline();
     m_licenseManager->clearLocalStorage();
-    std::cout << "To finish deactivation process please upload deactivation request file to the LicenseSpring portal." << std::endl;
-    std::cout << "File path: " << filePath.c_str() << std::endl << std::endl;
+    PLOG_INFO( "To finish deactivation process please upload deactivation request file to the LicenseSpring portal." );
+    PLOG_INFO( "File path: " << std::filesystem::path( filePath ).string() );
 }
 
 void SampleBase::createOfflineActivationRequest( const LicenseID& licenseId )
 {
-    std::cout << "Creating offline activation request file..." << std::endl;
+    PLOG_INFO( "Creating offline activation request file..." );
     auto filePath = m_licenseManager->createOfflineActivationFile( licenseId );
-    std::cout << "File created: " << std::endl;
-    std::wcout << filePath << std::endl;
-    std::cout << "Please upload that request file to LicenseSpring offline activation portal to get response file.\n";
-    std::cout << "Offline activation portal address: https://offline.licensespring.com" << std::endl;
+    PLOG_INFO( "File created: " << std::filesystem::path( filePath ).string() );
+    PLOG_INFO( "Please upload that request file to LicenseSpring offline activation portal to get response file." );
+    PLOG_INFO( "Offline activation portal address: https://offline.licensespring.com" );
 }
 
 void SampleBase::updateOfflineLicense( LicenseSpring::License::ptr_t license )
@@ -230,7 +256,23 @@ void SampleBase::updateOfflineLicense( LicenseSpring::License::ptr_t license )
     // Assign license refresh file path below
     std::wstring refreshFilePath = L"license_refresh.lic";
     if( license->updateOffline( refreshFilePath ) )
-        std::cout << "\nLicense refresh file successfully applied\n";
+        PLOG_INFO( "License refresh file successfully applied" );
+}
+
+std::vector<std::string> SampleBase::availableVersions( License::ptr_t license )
+{
+    if( m_updateCache )
+        return m_updateCache->VersionList( license->id() );
+    PRESIEN_SDK_TIMER( GET_VERSION_LIST );
+    return m_licenseManager->getVersionList( license->id() );
+}
+
+InstallationFile::ptr_t SampleBase::installationFile( License::ptr_t license, const std::string& version )
+{
+    if( m_updateCache )
+        return m_updateCache->InstallationFile( license->id(), version );
+    PRESIEN_SDK_TIMER( GET_INSTALLATION_FILE );
+    return m_licenseManager->getInstallationFile( license->id(), version );
 }
 
 void SampleBase::printUpdateInfo()
@@ -242,36 +284,138 @@ void SampleBase::printUpdateInfo()
     if( license == nullptr )
         return;
 
-    auto versionList = m_licenseManager->getVersionList( license->id() );
+    auto versionList = availableVersions( license );
     if( versionList.empty() )
         return;
 
-    std::cout << std::endl << "------------- Update info -------------" << std::endl;
-    std::cout << "Total app versions available: " << versionList.size() << std::endl;
+    PLOG_INFO( "------------- Update info -------------" );
+    PLOG_INFO( "Total app versions available: " << versionList.size() );
 
-    auto installFile = m_licenseManager->getInstallationFile( license->id(), versionList.at( versionList.size() - 1 ) );
+    auto installFile = installationFile( license, versionList.back() );
     if( installFile )
     {
-        std::cout << "Latest installation package information" << std::endl;
+        PLOG_INFO( "Latest installation package information" );
         printProductVersionInfo( installFile );
     }
 }
 
+std::string SampleBase::downloadLatestUpdate( const std::string& directory, const std::string& installedPackage,
+    const std::string& installedVersion )
+{
+    if( !m_licenseManager )
+        return std::string();
+
+    auto license = m_licenseManager->getCurrentLicense();
+    if( license == nullptr )
+        return std::string();
+
+    auto versionList = availableVersions( license );
+    if( versionList.empty() )
+        return std::string();
+
+    if( !installedVersion.empty() && installedVersion == versionList.back() )
+    {
+        PLOG_INFO( "Installed version " << installedVersion << " is the latest" );
+        return std::string();
+    }
+
+    if( !installedPackage.empty() && !installedVersion.empty() )
+    {
+        try
+        {
+            auto path = applyDeltaUpdates( license, versionList, directory, installedPackage, installedVersion );
+            if( !path.empty() )
+                return path;
+        }
+        catch( const std::exception& ex )
+        {
+            PLOG_WARN( "Delta update failed, downloading full package: " << ex.what() );
+        }
+    }
+
+    auto installFile = installationFile( license, versionList.back() );
+    if( installFile == nullptr || installFile->url().empty() )
+        return std::string();
+
+    const auto fileName = std::filesystem::path( installFile->url() ).filename().string();
+    const auto destination = ( std::filesystem::path( directory ) / ( fileName.empty() ? "package" : fileName ) ).string();
+
+    PRESIEN::BlindSight::PackageDownloader downloader;
+    auto result = downloader.Download( installFile->url(), destination, installFile->size(), installFile->md5Hash() );
+    if( !result.ok )
+        throw std::runtime_error( "Package download failed: " + result.error );
+
+    PLOG_INFO( "Downloaded " << installFile->version() << " to " << destination << " (" << result.size << " bytes, "
+        << ( result.resumed ? "resumed" : "fresh" ) << ", md5 " << result.md5 << ")" );
+    return destination;
+}
+
+std::string SampleBase::applyDeltaUpdates( License::ptr_t license, const std::vector<std::string>& versionList,
+    const std::string& directory, const std::string& installedPackage, const std::string& installedVersion )
+{
+    auto current = std::find( versionList.begin(), versionList.end(), installedVersion );
+    if( current == versionList.end() )
+        return std::string();
+
+    std::string base = installedPackage;
+    std::string baseVersion = installedVersion;
+    uint64_t transferred = 0;
+    for( auto version = std::next( current ); version != versionList.end(); ++version )
+    {
+        auto installFile = installationFile( license, *version );
+        if( installFile == nullptr || installFile->url().empty() )
+            throw std::runtime_error( "No installation file for " + *version );
+        // a delta is built against the version this one requires
+        if( installFile->requiredVersion() != baseVersion )
+            throw std::runtime_error( *version + " requires " + installFile->requiredVersion() + ", have " + baseVersion );
+
+        // versions may publish under the same file name, the patched base must never be the target
+        const auto fileName = std::filesystem::path( installFile->url() ).filename().string();
+        const auto target = ( std::filesystem::path( directory ) / ( ( fileName.empty() ? "package" : fileName ) + "-" + *version ) ).string();
+        if( std::filesystem::path( target ) == std::filesystem::path( base ) )
+            throw std::runtime_error( "Delta target " + target + " is the package it patches" );
+        const auto deltaPath = target + ".delta";
+
+        PRESIEN::BlindSight::PackageDownloader downloader;
+        auto result = downloader.Download( installFile->url() + ".delta", deltaPath );
+        if( !result.ok )
+            throw std::runtime_error( "Delta download failed: " + result.error );
+        transferred += result.downloaded;
+
+        const auto md5 = PRESIEN::BlindSight::PackageDelta::Apply( base, deltaPath, target );
+        std::filesystem::remove( deltaPath );
+        if( base != installedPackage )
+            std::filesystem::remove( base );
+        if( !installFile->md5Hash().empty() && !std::equal( md5.begin(), md5.end(), installFile->md5Hash().begin(), installFile->md5Hash().end(),
+                []( char a, char b ) { return std::tolower( a ) == std::tolower( b ); } ) )
+        {
+            std::filesystem::remove( target );
+            throw std::runtime_error( "Patched " + *version + " does not match the published md5" );
+        }
+
+        PLOG_INFO( "Patched " << baseVersion << " -> " << *version << " (" << result.downloaded << " delta bytes)" );
+        base = target;
+        baseVersion = *version;
+    }
+
+    PLOG_INFO( "Delta updated to " << baseVersion << " at " << base << ", " << transferred << " bytes transferred" );
+    return base;
+}
+
 void SampleBase::printProductVersionInfo( LicenseSpring::InstallationFile::ptr_t installFile )
 {
     if( installFile == nullptr )
         return;
-    std::cout << "Product version: " << installFile->version() << std::endl;
-    std::cout << "Release date: " << installFile->releaseDate() << std::endl;
-    std::cout << "Required version for update: " << installFile->requiredVersion() << std::endl;
-    std::cout << "URL for downloading: " << installFile->url() << std::endl;
-    std::cout << "Md5 hash: " << installFile->md5Hash() << std::endl;
-    std::cout << "Environment: " << installFile->environment() << std::endl;
-    std::cout << "Eula Link: " << installFile->eulaLink() << std::endl;
-    std::cout << "Release Notes Link: " << installFile->releaseNotesLink() << std::endl;
-    std::cout << "Size: " << installFile->size() << std::endl;
-    std::cout << "Channel: " << installFile->channel() << std::endl;
-    std::cout << std::endl;
+    PLOG_INFO( "Product version: " << installFile->version() );
+    PLOG_INFO( "Release date: " << installFile->releaseDate() );
+    PLOG_INFO( "Required version for update: " << installFile->requiredVersion() );
+    PLOG_INFO( "URL for downloading: " << installFile->url() );
+    PLOG_INFO( "Md5 hash: " << installFile->md5Hash() );
+    PLOG_INFO( "Environment: " << installFile->environment() );
+    PLOG_INFO( "Eula Link: " << installFile->eulaLink() );
+    PLOG_INFO( "Release Notes Link: " << installFile->releaseNotesLink() );
+    PLOG_INFO( "Size: " << installFile->size() );
+    PLOG_INFO( "Channel: " << installFile->channel() );
 }
 
 void SampleBase::PrintLicense( License::ptr_t license )
@@ -279,7 +423,7 @@ void SampleBase::PrintLicense( License::ptr_t license )
     if( license == nullptr )
         return;
 
-    std::cout << std::endl << "------------- License info -------------" << std::endl;
+    PLOG_INFO( "------------- License info -------------" );
 
     auto formatStr = []( std::string& str, const std::string& value )
     {
@@ -298,7 +442,7 @@ void SampleBase::PrintLicense( License::ptr_t license )
         formatStr( ownerInfo, licenseOwner.email() );
         formatStr( ownerInfo, licenseOwner.company() );
         if( !ownerInfo.empty() )
-            std::cout << "Customer information (licensed to): " << ownerInfo << std::endl;
+            PLOG_INFO( "Customer information (licensed to): " << ownerInfo );
     }
 
     auto licenseUser = license->licenseUser();
@@ -309,101 +453,101 @@ void SampleBase::PrintLicense( License::ptr_t license )
         formatStr( userInfo, licenseUser->lastName() );
         formatStr( userInfo, licenseUser->email() );
         if( !userInfo.empty() )
-            std::cout << "License user information: " << userInfo << std::endl;
+            PLOG_INFO( "License user information: " << userInfo );
     }
 
     if( !license->key().empty() )
-        std::cout << "Key = " << license->key() << std::endl;
+        PLOG_INFO( "Key = " << license->key() );
 
     if( !license->user().empty() )
-        std::cout << "User = " << license->user() << std::endl;
+        PLOG_INFO( "User = " << license->user() );
     
-    std::cout << "Type = " << license->type().toFormattedString() << std::endl;
-    std::cout << "Status = " << license->status() << std::endl;
-    std::cout << "IsActive = " << license->isActive() << std::endl;
-    std::cout << "IsEnabled = " << license->isEnabled() << std::endl;
-    std::cout << "IsTrial = " << license->isTrial() << std::endl;
-    std::cout << "IsFloating = " << license->isFloating() << std::endl;
-    std::cout << "Trial period for current license = " << license->trialPeriod() << std::endl;
+    PLOG_INFO( "Type = " << license->type().toFormattedString() );
+    PLOG_INFO( "Status = " << license->status() );
+    PLOG_INFO( "IsActive = " << license->isActive() );
+    PLOG_INFO( "IsEnabled = " << license->isEnabled() );
+    PLOG_INFO( "IsTrial = " << license->isTrial() );
+    PLOG_INFO( "IsFloating = " << license->isFloating() );
+    PLOG_INFO( "Trial period for current license = " << license->trialPeriod() );
     if( license->isFloating() )
     {
-        std::cout << "Current floating slots count = " << license->floatingInUseCount() << std::endl;
-        std::cout << "Overall floating slots count = " << license->maxFloatingUsers() << std::endl;
+        PLOG_INFO( "Current floating slots count = " << license->floatingInUseCount() );
+        PLOG_INFO( "Overall floating slots count = " << license->maxFloatingUsers() );
         auto endDate = TmToStr( license->floatingEndDateTime() );
         if( license->isBorrowed() )
-            std::cout << "The license is borrowed until: " << endDate << std::endl;
+            PLOG_INFO( "The license is borrowed until: " << endDate );
         else
         {
-            std::cout << "Registration of this floating license expires at: " << endDate << std::endl;
+            PLOG_INFO( "Registration of this floating license expires at: " << endDate );
             if( license->maxBorrowTime() > 0 )
-                std::cout << "License can be borrowed for " << license->maxBorrowTime()
-                          << " hours max" << std::endl;
+                PLOG_INFO( "License can be borrowed for " << license->maxBorrowTime()
+                           << " hours max" );
             else
-                std::cout << "License borrowing is not allowed" << std::endl;
+                PLOG_INFO( "License borrowing is not allowed" );
         }
     }
-    std::cout << "IsOfflineActivated = " << license->isOfflineActivated() << std::endl;
-    std::cout << "Times activated = " << license->timesActivated() << std::endl;
-    std::cout << "Max activations = " << license->maxActivations() << std::endl;
-    std::cout << "Transfer count = " << license->transferCount() << std::endl;
+    PLOG_INFO( "IsOfflineActivated = " << license->isOfflineActivated() );
+    PLOG_INFO( "Times activated = " << license->timesActivated() );
+    PLOG_INFO( "Max activations = " << license->maxActivations() );
+    PLOG_INFO( "Transfer count = " << license->transferCount() );
 
     if( license->isDeviceTransferAllowed() )
     {
         if( license->isDeviceTransferLimited() )
-            std::cout << "Device transfer limit = " << license->transferLimit() << std::endl;
+            PLOG_INFO( "Device transfer limit = " << license->transferLimit() );
         else
-            std::cout << "This license has unlimited device transfers" << std::endl;
+            PLOG_INFO( "This license has unlimited device transfers" );
     }
     else
-        std::cout << "Device transfer is not allowed" << std::endl;
+        PLOG_INFO( "Device transfer is not allowed" );
 
     if( !license->startDate().empty() )
-        std::cout << "Start date = " << license->startDate() << std::endl;
-    std::cout << "Validity Period = " << TmToStr( license->validityPeriod() ) << std::endl;
-    std::cout << "Validity Period UTC = " << TmToStr( license->validityPeriodUtc() ) << std::endl;
-    std::cout << "Days remaining till license expires = " << license->daysRemaining() << std::endl;
+        PLOG_INFO( "Start date = " << license->startDate() );
+    PLOG_INFO( "Validity Period = " << TmToStr( license->validityPeriod() ) );
+    PLOG_INFO( "Validity Period UTC = " << TmToStr( license->validityPeriodUtc() ) );
+    PLOG_INFO( "Days remaining till license expires = " << license->daysRemaining() );
     if( license->type() == LicenseTypeSubscription )
-        std::cout << "Subscription grace period = " << license->subscriptionGracePeriod() << std::endl;
-    std::cout << "Maintenance period = " << TmToStr( license->maintenancePeriod() ) << std::endl;
-    std::cout << "Maintenance period UTC = " << TmToStr( license->maintenancePeriodUtc() ) <<std::endl;
-    std::cout << "Maintenance days remaining = " << license->maintenanceDaysRemaining() << std::endl;
-    std::cout << "Last online check date = " << TmToStr( license->lastCheckDate() ) << std::endl;
-    std::cout << "Days passed since last online check = " << license->daysPassedSinceLastCheck() << std::endl;
-    std::cout << "Metadata = " << license->metadata() << std::endl;
+        PLOG_INFO( "Subscription grace period = " << license->subscriptionGracePeriod() );
+    PLOG_INFO( "Maintenance period = " << TmToStr( license->maintenancePeriod() ) );
+    PLOG_INFO( "Maintenance period UTC = " << TmToStr( license->maintenancePeriodUtc() ) );
+    PLOG_INFO( "Maintenance days remaining = " << license->maintenanceDaysRemaining() );
+    PLOG_INFO( "Last online check date = " << TmToStr( license->lastCheckDate() ) );
+    PLOG_INFO( "Days passed since last online check = " << license->daysPassedSinceLastCheck() );
+    PLOG_INFO( "Metadata = " << license->metadata() );
 
     auto productFeatures = license->features();
     if( !productFeatures.empty() )
     {
-        std::cout << "Product features available for this license:" << std::endl;
+        PLOG_INFO( "Product features available for this license:" );
         for( auto feature : productFeatures )
-            std::cout << feature.toString() << std::endl;
+            PLOG_INFO( feature.toString() );
     }
 
     auto dataFields = license->customFields();
     if( !dataFields.empty() )
     {
-        std::cout << "Custom data fields available for this license:" << std::endl;
+        PLOG_INFO( "Custom data fields available for this license:" );
         for( const auto& field : dataFields )
-            std::cout << "Data field - Name: " << field.fieldName() << ", Value: " << field.fieldValue() << std::endl;
+            PLOG_INFO( "Data field - Name: " << field.fieldName() << ", Value: " << field.fieldValue() );
     }
 
     const auto& userData = license->userData();
     if( !userData.empty() )
     {
-        std::cout << "User data for this license: " << std::endl;
+        PLOG_INFO( "User data for this license: " );
         for( const auto& field : userData )
-            std::cout << "Data field - Name: " << field.fieldName() << ", Value: " << field.fieldValue() << std::endl;
+            PLOG_INFO( "Data field - Name: " << field.fieldName() << ", Value: " << field.fieldValue() );
     }
 
     if( license->type() == LicenseTypeConsumption )
     {
-        std::cout << "Total consumptions = " << license->totalConsumption() << std::endl;
+        PLOG_INFO( "Total consumptions = " << license->totalConsumption() );
         if( license->isUnlimitedConsumptionAllowed() )
-            std::cout << "Max consumptions = " << "Unlimited" << std::endl;
+            PLOG_INFO( "Max consumptions = " << "Unlimited" );
         else
-            std::cout << "Max consumptions = " << license->maxConsumption() << std::endl;
-        std::cout << "Is overages allowed = " << license->isOveragesAllowed() << std::endl;
+            PLOG_INFO( "Max consumptions = " << license->maxConsumption() );
+        PLOG_INFO( "Is overages allowed = " << license->isOveragesAllowed() );
         if( license->isOveragesAllowed() )
-            std::cout << "Max overages = " << license->maxOverages() << std::endl;
+            PLOG_INFO( "Max overages = " << license->maxOverages() );
     }
 }
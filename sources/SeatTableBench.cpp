@@ -0,0 +1,656 @@
+#include "SeatTableBench.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+#include <json/json.hpp>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    int64_t nowSeconds(){
+        return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    std::string percentDecode(const std::string& value){
+        std::string out;
+        out.reserve(value.size());
+        for (size_t i = 0; i < value.size(); ++i)
+        {
+            // a malformed escape ("%zz", trailing '%') stays as it is
+            if (value[i] == '%' && i + 2 < value.size()
+                && std::isxdigit(static_cast<unsigned char>(value[i + 1])) && std::isxdigit(static_cast<unsigned char>(value[i + 2])))
+            {
+                out += static_cast<char>(std::stoi(value.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            }
+            else if (value[i] == '+')
+                out += ' ';
+            else
+                out += value[i];
+        }
+        return out;
+    }
+
+    std::map<std::string, std::string> parseQuery(const std::string& query){
+        std::map<std::string, std::string> params;
+        size_t pos = 0;
+        while (pos < query.size())
+        {
+            auto end = query.find('&', pos);
+            if (end == std::string::npos)
+                end = query.size();
+            auto item = query.substr(pos, end - pos);
+            auto eq = item.find('=');
+            if (eq != std::string::npos)
+                params[percentDecode(item.substr(0, eq))] = percentDecode(item.substr(eq + 1));
+            pos = end + 1;
+        }
+        return params;
+    }
+
+    bool sendAll(int fd, const std::string& data){
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            auto n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n > 0)
+            {
+                sent += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                // responses are small, waiting here is rare and short
+                pollfd pfd{fd, POLLOUT, 0};
+                if (poll(&pfd, 1, 1000) > 0)
+                    continue;
+            }
+            return false;
+        }
+        return true;
+    }
+
+    const char* reasonPhrase(int status){
+        switch (status)
+        {
+            case 200: return "OK";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 409: return "Conflict";
+            default: return "Error";
+        }
+    }
+}
+
+SeatTableBench::SeatTableBench(const Options& options):mOptions(options){
+    // at least twice the seats, so probing always finds a free slot quickly
+    size_t size = 16;
+    while (size < static_cast<size_t>(mOptions.seats) * 2)
+        size <<= 1;
+    mMask = size - 1;
+    mSlots.reset(new Slot[size]);
+    mWheel.reset(new Bucket[WHEEL_SIZE]);
+    mLastTick = nowSeconds();
+
+    _load();
+
+    mTicker = std::thread([this]{
+        auto lastSave = std::chrono::steady_clock::now();
+        while (mRunning.load())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            ExpireDue(nowSeconds());
+            if (!mOptions.stateFile.empty() && std::chrono::steady_clock::now() - lastSave >= mOptions.persistInterval)
+            {
+                lastSave = std::chrono::steady_clock::now();
+                if (mDirty.exchange(false))
+                    Save();
+            }
+        }
+    });
+}
+
+SeatTableBench::~SeatTableBench(){
+    StopHttp();
+    mRunning = false;
+    if (mTicker.joinable())
+        mTicker.join();
+    if (!mOptions.stateFile.empty())
+        Save();
+}
+
+uint64_t SeatTableBench::_hash(const std::string& id){
+    // FNV-1a, values below RESERVED are markers
+    uint64_t hash = 1469598103934665603ull;
+    for (unsigned char c : id)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash > RESERVED ? hash : hash + RESERVED + 1;
+}
+
+long SeatTableBench::_find(uint64_t key) const{
+    for (size_t i = 0; i <= mMask; ++i)
+    {
+        const size_t index = (key + i) & mMask;
+        const auto current = mSlots[index].key.load(std::memory_order_acquire);
+        if (current == key)
+            return static_cast<long>(index);
+        if (current == EMPTY)
+            break;
+    }
+    return -1;
+}
+
+void SeatTableBench::_schedule(size_t slot, uint64_t key, int64_t expires){
+    auto& bucket = mWheel[static_cast<size_t>(expires) % WHEEL_SIZE];
+    std::lock_guard<std::mutex> lock(bucket.mutex);
+    bucket.entries.emplace_back(slot, key);
+}
+
+bool SeatTableBench::_release(size_t index, uint64_t key){
+    if (!mSlots[index].key.compare_exchange_strong(key, TOMBSTONE, std::memory_order_acq_rel))
+        return false;
+    mInUse.fetch_sub(1);
+    ++mTombstones;
+    return true;
+}
+
+SeatTableBench::Status SeatTableBench::_acquire(const std::string& id, int64_t expires, int64_t* result){
+    if (id.empty() || id.size() > MAX_ID)
+        return Status::BAD_REQUEST;
+    const auto key = _hash(id);
+    std::shared_lock<std::shared_mutex> tableLock(mTableMutex);
+
+    // a lost race against a concurrent register of the same id starts over and renews its slot
+    for (;;)
+    {
+        // already registered: renewing only moves the expiry, the wheel entry is re-checked lazily
+        auto existing = _find(key);
+        if (existing >= 0)
+        {
+            auto& slot = mSlots[static_cast<size_t>(existing)];
+            auto previous = slot.expires.exchange(expires);
+            if (expires < previous)
+                _schedule(static_cast<size_t>(existing), key, expires);
+            // lease may have expired between find and renew, then a new seat is needed
+            if (slot.key.load(std::memory_order_acquire) == key)
+            {
+                mDirty = true;
+                if (result)
+                    *result = expires;
+                return Status::OK;
+            }
+        }
+
+        auto used = mInUse.load(std::memory_order_relaxed);
+        do
+        {
+            if (used >= mOptions.seats)
+                return Status::NO_SEAT;
+        }
+        while (!mInUse.compare_exchange_weak(used, used + 1, std::memory_order_acq_rel));
+
+        long claimed = -1;
+        for (size_t i = 0; i <= mMask && claimed < 0; ++i)
+        {
+            const size_t index = (key + i) & mMask;
+            auto& slot = mSlots[index];
+            auto current = slot.key.load(std::memory_order_relaxed);
+            if (current != EMPTY && current != TOMBSTONE)
+                continue;
+            if (!slot.key.compare_exchange_strong(current, RESERVED, std::memory_order_acq_rel))
+                continue;
+            if (current == TOMBSTONE)
+                --mTombstones;
+
+            uint64_t words[8] = {};
+            memcpy(words, id.data(), id.size());
+            for (size_t w = 0; w < 8; ++w)
+                slot.id[w].store(words[w], std::memory_order_relaxed);
+            slot.idLength.store(static_cast<uint32_t>(id.size()), std::memory_order_relaxed);
+            slot.expires.store(expires, std::memory_order_relaxed);
+            // seq_cst publish and re-check: of two registers of the same id at least one sees
+            // the other's slot
+            slot.key.store(key, std::memory_order_seq_cst);
+            claimed = static_cast<long>(index);
+        }
+        if (claimed < 0)
+        {
+            mInUse.fetch_sub(1);
+            return Status::NO_SEAT;
+        }
+
+        // the slot first in probe order stays, the other one is rolled back
+        const auto index = static_cast<size_t>(claimed);
+        bool duplicate = false;
+        for (size_t i = 0; i <= mMask; ++i)
+        {
+            const size_t other = (key + i) & mMask;
+            const auto current = mSlots[other].key.load(std::memory_order_seq_cst);
+            if (current == EMPTY)
+                break;
+            if (other == index || current != key)
+                continue;
+            if (_probeDistance(other, key) < _probeDistance(index, key))
+                duplicate = true;
+            else
+                _release(other, key);
+        }
+        if (duplicate)
+        {
+            _release(index, key);
+            continue;
+        }
+
+        _schedule(index, key, expires);
+        mDirty = true;
+        if (result)
+            *result = expires;
+        return Status::OK;
+    }
+}
+
+SeatTableBench::Status SeatTableBench::Register(const std::string& id, int64_t* expires){
+    return _acquire(id, nowSeconds() + mOptions.lease.count(), expires);
+}
+
+SeatTableBench::Status SeatTableBench::Borrow(const std::string& id, int64_t until, int64_t* expires){
+    if (until <= nowSeconds())
+        return Status::BAD_REQUEST;
+    return _acquire(id, until, expires);
+}
+
+SeatTableBench::Status SeatTableBench::Unregister(const std::string& id){
+    const auto key = _hash(id);
+    std::shared_lock<std::shared_mutex> tableLock(mTableMutex);
+    auto index = _find(key);
+    if (index < 0 || !_release(static_cast<size_t>(index), key))
+        return Status::NOT_FOUND;
+    mDirty = true;
+    return Status::OK;
+}
+
+size_t SeatTableBench::ExpireDue(int64_t now){
+    std::lock_guard<std::mutex> lock(mTickMutex);
+    // every miss of _find scans up to the next empty slot, tombstones left behind by churn
+    // would make that the whole table
+    if (mTombstones.load() > (mMask + 1) / 4)
+        _rebuild();
+    std::shared_lock<std::shared_mutex> tableLock(mTableMutex);
+    size_t released = 0;
+    // after a long stall one full turn of the wheel covers every bucket
+    int64_t from = std::max(mLastTick + 1, now - static_cast<int64_t>(WHEEL_SIZE) + 1);
+    for (int64_t tick = from; tick <= now; ++tick)
+    {
+        std::vector<std::pair<size_t, uint64_t>> entries;
+        {
+            auto& bucket = mWheel[static_cast<size_t>(tick) % WHEEL_SIZE];
+            std::lock_guard<std::mutex> bucketLock(bucket.mutex);
+            entries.swap(bucket.entries);
+        }
+        for (const auto& entry : entries)
+        {
+            auto& slot = mSlots[entry.first];
+            auto current = entry.second;
+            if (slot.key.load(std::memory_order_acquire) != current)
+                continue; // unregistered already
+            const auto expires = slot.expires.load(std::memory_order_relaxed);
+            if (expires > now)
+            {
+                _schedule(entry.first, current, expires); // renewed in the meantime
+                continue;
+            }
+            if (_release(entry.first, current))
+                ++released;
+        }
+    }
+    mLastTick = std::max(mLastTick, now);
+    if (released)
+    {
+        mExpired.fetch_add(released, std::memory_order_relaxed);
+        mDirty = true;
+    }
+    return released;
+}
+
+void SeatTableBench::_rebuild(){
+    // mTickMutex held, so the wheel is not being drained
+    std::unique_lock<std::shared_mutex> tableLock(mTableMutex);
+    struct Live{
+        uint64_t key;
+        int64_t expires;
+        uint32_t idLength;
+        uint64_t id[8];
+    };
+    std::vector<Live> live;
+    for (size_t i = 0; i <= mMask; ++i)
+    {
+        auto& slot = mSlots[i];
+        const auto key = slot.key.load(std::memory_order_relaxed);
+        if (key > RESERVED)
+        {
+            Live entry{key, slot.expires.load(std::memory_order_relaxed), slot.idLength.load(std::memory_order_relaxed), {}};
+            for (size_t w = 0; w < 8; ++w)
+                entry.id[w] = slot.id[w].load(std::memory_order_relaxed);
+            live.push_back(entry);
+        }
+        slot.key.store(EMPTY, std::memory_order_relaxed);
+    }
+    for (size_t b = 0; b < WHEEL_SIZE; ++b)
+    {
+        std::lock_guard<std::mutex> bucketLock(mWheel[b].mutex);
+        mWheel[b].entries.clear();
+    }
+    for (const auto& entry : live)
+    {
+        size_t index = entry.key & mMask;
+        while (mSlots[index].key.load(std::memory_order_relaxed) != EMPTY)
+            index = (index + 1) & mMask;
+        auto& slot = mSlots[index];
+        for (size_t w = 0; w < 8; ++w)
+            slot.id[w].store(entry.id[w], std::memory_order_relaxed);
+        slot.idLength.store(entry.idLength, std::memory_order_relaxed);
+        slot.expires.store(entry.expires, std::memory_order_relaxed);
+        slot.key.store(entry.key, std::memory_order_release);
+        // leases already due are picked up by the next tick
+        _schedule(index, entry.key, std::max(entry.expires, mLastTick + 1));
+    }
+    mTombstones = 0;
+}
+
+bool SeatTableBench::Save() const{
+    if (mOptions.stateFile.empty())
+        return false;
+    nlohmann::json leases = nlohmann::json::array();
+    std::shared_lock<std::shared_mutex> tableLock(mTableMutex);
+    for (size_t i = 0; i <= mMask; ++i)
+    {
+        const auto& slot = mSlots[i];
+        const auto key = slot.key.load(std::memory_order_acquire);
+        if (key <= RESERVED)
+            continue;
+        uint64_t words[8];
+        for (size_t w = 0; w < 8; ++w)
+            words[w] = slot.id[w].load(std::memory_order_relaxed);
+        const auto length = slot.idLength.load(std::memory_order_relaxed);
+        const auto expires = slot.expires.load(std::memory_order_relaxed);
+        // slot was released and reused while copying, skip it this time
+        if (slot.key.load(std::memory_order_acquire) != key)
+            continue;
+        leases.push_back({{"id", std::string(reinterpret_cast<const char*>(words), length)}, {"expires", expires}});
+    }
+
+    nlohmann::json data;
+    data["seats"] = mOptions.seats;
+    data["leases"] = leases;
+    const std::string tmpPath = mOptions.stateFile + ".tmp";
+    {
+        std::ofstream os(tmpPath, std::ios::trunc);
+        if (!os.good())
+            return false;
+        os << data.dump();
+        if (!os.good())
+            return false;
+    }
+    return std::rename(tmpPath.c_str(), mOptions.stateFile.c_str()) == 0;
+}
+
+void SeatTableBench::_load(){
+    if (mOptions.stateFile.empty())
+        return;
+    std::ifstream is(mOptions.stateFile);
+    if (!is.good())
+        return;
+    try
+    {
+        auto data = nlohmann::json::parse(is);
+        const auto now = nowSeconds();
+        for (const auto& lease : data.at("leases"))
+        {
+            auto expires = lease.at("expires").get<int64_t>();
+            if (expires > now)
+                _acquire(lease.at("id").get<std::string>(), expires, nullptr);
+        }
+    }
+    catch (const nlohmann::json::exception&)
+    {
+        // corrupted state, clients simply register again
+    }
+    mDirty = false;
+}
+
+int SeatTableBench::HandleRequest(const std::string& method, const std::string& target, std::string& body){
+    const auto question = target.find('?');
+    const auto path = target.substr(0, question);
+    const auto params = parseQuery(question == std::string::npos ? std::string() : target.substr(question + 1));
+    auto param = [&](const char* name){
+        auto it = params.find(name);
+        return it == params.end() ? std::string() : it->second;
+    };
+
+    nlohmann::json response;
+    int status = 200;
+    int64_t expires = 0;
+    auto reply = [&](Status result){
+        switch (result)
+        {
+            case Status::OK:
+                response["status"] = "ok";
+                if (expires)
+                    response["lease_expires"] = expires;
+                break;
+            case Status::NO_SEAT:
+                status = 409;
+                response["status"] = "max_floating_reached";
+                break;
+            case Status::NOT_FOUND:
+                status = 404;
+                response["status"] = "not_registered";
+                break;
+            default:
+                status = 400;
+                response["status"] = "bad_request";
+        }
+        response["in_use"] = InUse();
+        response["seats"] = Capacity();
+    };
+
+    if (path == "/info" && method == "GET")
+    {
+        response["seats"] = Capacity();
+        response["in_use"] = InUse();
+        response["lease_seconds"] = mOptions.lease.count();
+        response["expired_total"] = Expired();
+    }
+    else if (path == "/register" && method == "POST")
+        reply(Register(param("id"), &expires));
+    else if (path == "/borrow" && method == "POST")
+    {
+        int64_t until = 0;
+        try
+        {
+            until = std::stoll(param("until"));
+        }
+        catch (const std::exception&)
+        {
+        }
+        reply(Borrow(param("id"), until, &expires));
+    }
+    else if (path == "/unregister" && method == "POST")
+        reply(Unregister(param("id")));
+    else
+    {
+        status = 404;
+        response["status"] = "unknown_request";
+    }
+    body = response.dump();
+    return status;
+}
+
+bool SeatTableBench::StartHttp(uint16_t port, unsigned workers){
+    if (mServing.load())
+        return true;
+
+    std::vector<int> listeners;
+    for (unsigned w = 0; w < std::max(1u, workers); ++w)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (fd < 0)
+            break;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 1024) != 0)
+        {
+            close(fd);
+            break;
+        }
+        listeners.push_back(fd);
+    }
+    if (listeners.size() != std::max(1u, workers))
+    {
+        for (int fd : listeners)
+            close(fd);
+        return false;
+    }
+
+    mServing = true;
+    for (int fd : listeners)
+        mHttpWorkers.emplace_back([this, fd]{ _serve(fd); });
+    return true;
+}
+
+void SeatTableBench::StopHttp(){
+    mServing = false;
+    for (auto& worker : mHttpWorkers)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+    mHttpWorkers.clear();
+}
+
+void SeatTableBench::_serve(int listenFd){
+    int epollFd = epoll_create1(0);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+
+    std::unordered_map<int, std::string> buffers;
+    auto closeConnection = [&](int fd){
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        buffers.erase(fd);
+    };
+
+    epoll_event events[64];
+    while (mServing.load())
+    {
+        int count = epoll_wait(epollFd, events, 64, 200);
+        for (int e = 0; e < count; ++e)
+        {
+            const int fd = events[e].data.fd;
+            if (fd == listenFd)
+            {
+                int client;
+                while ((client = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK)) >= 0)
+                {
+                    int one = 1;
+                    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    epoll_event clientEvent{};
+                    clientEvent.events = EPOLLIN | EPOLLRDHUP;
+                    clientEvent.data.fd = client;
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, client, &clientEvent);
+                    buffers[client];
+                }
+                continue;
+            }
+
+            auto& buffer = buffers[fd];
+            bool open = true;
+            char chunk[4096];
+            for (;;)
+            {
+                auto n = recv(fd, chunk, sizeof(chunk), 0);
+                if (n > 0)
+                    buffer.append(chunk, static_cast<size_t>(n));
+                else
+                {
+                    open = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+                    break;
+                }
+            }
+
+            // keep-alive: answer every complete request in the buffer
+            size_t headerEnd;
+            while (open && (headerEnd = buffer.find("\r\n\r\n")) != std::string::npos)
+            {
+                size_t bodyLength = 0;
+                auto lengthPos = buffer.find("Content-Length:");
+                if (lengthPos != std::string::npos && lengthPos < headerEnd)
+                    bodyLength = std::strtoul(buffer.c_str() + lengthPos + 15, nullptr, 10);
+                if (buffer.size() < headerEnd + 4 + bodyLength)
+                    break;
+
+                const auto lineEnd = buffer.find("\r\n");
+                const auto requestLine = buffer.substr(0, lineEnd);
+                buffer.erase(0, headerEnd + 4 + bodyLength);
+
+                const auto methodEnd = requestLine.find(' ');
+                const auto targetEnd = requestLine.find(' ', methodEnd + 1);
+                std::string body;
+                int status = 400;
+                if (methodEnd != std::string::npos && targetEnd != std::string::npos)
+                {
+                    // one bad request must not take the server down
+                    try
+                    {
+                        status = HandleRequest(requestLine.substr(0, methodEnd),
+                                               requestLine.substr(methodEnd + 1, targetEnd - methodEnd - 1), body);
+                    }
+                    catch (const std::exception& ex)
+                    {
+                        status = 400;
+                        body = nlohmann::json{{"error", ex.what()}}.dump();
+                    }
+                }
+
+                std::string response = "HTTP/1.1 " + std::to_string(status) + " " + reasonPhrase(status) + "\r\n"
+                                       "Content-Type: application/json\r\n"
+                                       "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+                open = sendAll(fd, response);
+            }
+            if (!open)
+                closeConnection(fd);
+        }
+    }
+
+    for (const auto& connection : buffers)
+        close(connection.first);
+    close(epollFd);
+    close(listenFd);
+}
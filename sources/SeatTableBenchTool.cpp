@@ -0,0 +1,293 @@
+// Synthetic seat-table benchmark server and its load generator, see SeatTableBench.h.
+// usage: presien-seat-bench serve [port=8080] [seats=100] [lease=30] [workers=4] [state=<file>]
+//        presien-seat-bench load [host=127.0.0.1] [port=0] [clients=1000] [threads=32] [duration=10]
+//                                [hold=3] [seats=500] [lease=30] [workers=4]
+// load with port=0 starts a benchmark server in process on port 18080. Every client keeps one
+// connection and cycles register, renew hold times, unregister.
+
+#include "SeatTableBench.h"
+
+#include <algorithm>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    using Args = std::map<std::string, std::string>;
+
+    class HttpConnection{
+        public:
+            HttpConnection(const std::string& host, uint16_t port):mHost(host), mPort(port) {}
+            ~HttpConnection() { _close(); }
+
+            // returns HTTP status, 0 on transport error
+            int Request(const std::string& method, const std::string& target){
+                for (int attempt = 0; attempt < 2; ++attempt)
+                {
+                    if (mFd < 0 && !_connect())
+                        return 0;
+                    const auto request = method + " " + target + " HTTP/1.1\r\nHost: " + mHost + "\r\nContent-Length: 0\r\n\r\n";
+                    int status = 0;
+                    if (send(mFd, request.data(), request.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(request.size()) && _readResponse(status))
+                        return status;
+                    _close(); // server closed keep-alive connection, retry once
+                }
+                return 0;
+            }
+
+        private:
+            bool _connect(){
+                addrinfo hints{};
+                hints.ai_family = AF_INET;
+                hints.ai_socktype = SOCK_STREAM;
+                addrinfo* info = nullptr;
+                if (getaddrinfo(mHost.c_str(), std::to_string(mPort).c_str(), &hints, &info) != 0)
+                    return false;
+                mFd = socket(AF_INET, SOCK_STREAM, 0);
+                if (mFd >= 0 && connect(mFd, info->ai_addr, info->ai_addrlen) != 0)
+                    _close();
+                freeaddrinfo(info);
+                if (mFd < 0)
+                    return false;
+                int one = 1;
+                setsockopt(mFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                return true;
+            }
+
+            bool _readResponse(int& status){
+                std::string buffer;
+                char chunk[2048];
+                size_t headerEnd;
+                while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos)
+                {
+                    auto n = recv(mFd, chunk, sizeof(chunk), 0);
+                    if (n <= 0)
+                        return false;
+                    buffer.append(chunk, static_cast<size_t>(n));
+                }
+                size_t length = 0;
+                auto lengthPos = buffer.find("Content-Length:");
+                if (lengthPos != std::string::npos && lengthPos < headerEnd)
+                    length = std::strtoul(buffer.c_str() + lengthPos + 15, nullptr, 10);
+                while (buffer.size() < headerEnd + 4 + length)
+                {
+                    auto n = recv(mFd, chunk, sizeof(chunk), 0);
+                    if (n <= 0)
+                        return false;
+                    buffer.append(chunk, static_cast<size_t>(n));
+                }
+                status = std::atoi(buffer.c_str() + 9); // "HTTP/1.1 200"
+                return true;
+            }
+
+            void _close(){
+                if (mFd >= 0)
+                    close(mFd);
+                mFd = -1;
+            }
+
+            std::string mHost;
+            uint16_t mPort;
+            int mFd = -1;
+    };
+
+    struct ThreadStats{
+        std::vector<double> registerUs;
+        std::vector<double> renewUs;
+        uint64_t requests = 0;
+        uint64_t cycles = 0;
+        uint64_t rejected = 0;
+        uint64_t failed = 0;
+    };
+
+    double percentile(const std::vector<double>& sorted, double p){
+        if (sorted.empty())
+            return 0;
+        auto index = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    SeatTableBench::Options benchOptions(Args& args){
+        SeatTableBench::Options options;
+        options.seats = static_cast<uint32_t>(std::stoul(args["seats"]));
+        options.lease = std::chrono::seconds(std::stol(args["lease"]));
+        options.stateFile = args["state"];
+        return options;
+    }
+
+    int serve(Args& args){
+        // block the signals before any thread starts, so only sigwait receives them
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        SeatTableBench bench(benchOptions(args));
+        const auto port = static_cast<uint16_t>(std::stoul(args["port"]));
+        if (!bench.StartHttp(port, static_cast<unsigned>(std::stoul(args["workers"]))))
+        {
+            std::cout << "Error - cannot listen on port " << port << std::endl;
+            return -1;
+        }
+        std::cout << "Seat table benchmark server on port " << port << ", " << bench.Capacity() << " seats, "
+                  << bench.InUse() << " restored leases" << std::endl;
+        int signal = 0;
+        sigwait(&signals, &signal);
+        std::cout << "Stopping, " << bench.InUse() << " seats in use" << std::endl;
+        return 0;
+    }
+
+    int load(Args& args){
+        std::unique_ptr<SeatTableBench> local;
+        auto port = static_cast<uint16_t>(std::stoul(args["port"]));
+        if (port == 0)
+        {
+            port = 18080;
+            local.reset(new SeatTableBench(benchOptions(args)));
+            if (!local->StartHttp(port, static_cast<unsigned>(std::stoul(args["workers"]))))
+            {
+                std::cout << "Error - cannot listen on port " << port << std::endl;
+                return -1;
+            }
+        }
+
+        const int clients = std::stoi(args["clients"]);
+        const int threads = std::min(std::stoi(args["threads"]), clients);
+        const int hold = std::stoi(args["hold"]);
+        const auto duration = std::chrono::seconds(std::stol(args["duration"]));
+        const auto host = args["host"];
+
+        std::vector<ThreadStats> stats(static_cast<size_t>(threads));
+        std::vector<std::thread> workers;
+        const auto start = std::chrono::steady_clock::now();
+        const auto deadline = start + duration;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]{
+                using clock = std::chrono::steady_clock;
+                struct Client{
+                    std::unique_ptr<HttpConnection> connection;
+                    std::string id;
+                    bool holding = false;
+                    int renewals = 0;
+                };
+                std::vector<Client> own;
+                for (int c = t; c < clients; c += threads)
+                    own.push_back({std::make_unique<HttpConnection>(host, port), "blindsight-" + std::to_string(c), false, 0});
+
+                auto& s = stats[static_cast<size_t>(t)];
+                while (clock::now() < deadline)
+                {
+                    for (auto& client : own)
+                    {
+                        const auto begin = clock::now();
+                        int status;
+                        if (!client.holding || client.renewals < hold)
+                            status = client.connection->Request("POST", "/register?id=" + client.id);
+                        else
+                            status = client.connection->Request("POST", "/unregister?id=" + client.id);
+                        const double us = std::chrono::duration<double, std::micro>(clock::now() - begin).count();
+                        ++s.requests;
+
+                        if (status == 0)
+                            ++s.failed;
+                        else if (status == 409)
+                            ++s.rejected;
+                        else if (!client.holding)
+                        {
+                            s.registerUs.push_back(us);
+                            client.holding = status == 200;
+                            client.renewals = 0;
+                        }
+                        else if (client.renewals < hold)
+                        {
+                            s.renewUs.push_back(us);
+                            ++client.renewals;
+                        }
+                        else
+                        {
+                            client.holding = false;
+                            ++s.cycles;
+                        }
+                    }
+                }
+                // leave the server clean for the next run
+                for (auto& client : own)
+                {
+                    if (client.holding)
+                        client.connection->Request("POST", "/unregister?id=" + client.id);
+                }
+            });
+        }
+        for (auto& worker : workers)
+            worker.join();
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        ThreadStats total;
+        for (auto& s : stats)
+        {
+            total.registerUs.insert(total.registerUs.end(), s.registerUs.begin(), s.registerUs.end());
+            total.renewUs.insert(total.renewUs.end(), s.renewUs.begin(), s.renewUs.end());
+            total.requests += s.requests;
+            total.cycles += s.cycles;
+            total.rejected += s.rejected;
+            total.failed += s.failed;
+        }
+        std::sort(total.registerUs.begin(), total.registerUs.end());
+        std::sort(total.renewUs.begin(), total.renewUs.end());
+
+        std::cout << "clients=" << clients << " threads=" << threads << " hold=" << hold
+                  << " duration=" << std::fixed << std::setprecision(2) << elapsed << " s" << std::endl;
+        std::cout << std::setprecision(1)
+                  << "requests " << static_cast<double>(total.requests) / elapsed << " req/s"
+                  << ", seat churn " << static_cast<double>(total.cycles) / elapsed << " cycles/s"
+                  << ", rejected (max floating) " << total.rejected << ", transport errors " << total.failed << std::endl;
+        std::cout << "register us: p50 " << percentile(total.registerUs, 50) << ", p99 " << percentile(total.registerUs, 99)
+                  << ", p99.9 " << percentile(total.registerUs, 99.9) << std::endl;
+        std::cout << "renew us:    p50 " << percentile(total.renewUs, 50) << ", p99 " << percentile(total.renewUs, 99)
+                  << ", p99.9 " << percentile(total.renewUs, 99.9) << std::endl;
+        if (local)
+            std::cout << "seats in use at exit: " << local->InUse() << std::endl;
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::string mode = argc > 1 ? argv[1] : "";
+    Args args = {
+        {"host", "127.0.0.1"}, {"port", mode == "serve" ? "8080" : "0"}, {"seats", mode == "serve" ? "100" : "500"},
+        {"lease", "30"}, {"workers", "4"}, {"state", ""},
+        {"clients", "1000"}, {"threads", "32"}, {"duration", "10"}, {"hold", "3"}
+    };
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if (eq == std::string::npos || !args.count(arg.substr(0, eq)))
+        {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            return -1;
+        }
+        args[arg.substr(0, eq)] = arg.substr(eq + 1);
+    }
+
+    if (mode == "serve")
+        return serve(args);
+    if (mode == "load")
+        return load(args);
+    std::cout << "usage: " << argv[0] << " serve|load [key=value ...]" << std::endl;
+    return -1;
+}
@@ -0,0 +1,55 @@
+#include "SecretVault.h"
+
+#include <stdexcept>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace PRESIEN::BlindSight;
+
+SecretVault::SecretVault(){
+    mPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    void* page = mmap(nullptr, mPageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED)
+        throw std::runtime_error("Error: failed to allocate secret vault.");
+    mPage = static_cast<char*>(page);
+
+    // mlock may be refused by RLIMIT_MEMLOCK in containers, vault still works unlocked
+    mlock(mPage, mPageSize);
+#ifdef MADV_DONTDUMP
+    madvise(mPage, mPageSize, MADV_DONTDUMP);
+#endif
+}
+
+SecretVault::~SecretVault(){
+    Wipe();
+    munlock(mPage, mPageSize);
+    munmap(mPage, mPageSize);
+}
+
+std::string_view SecretVault::Fetch(const void* owner, const char* encoded, size_t size, unsigned long long key){
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mSecrets.find(owner);
+    if (it != mSecrets.end())
+        return it->second;
+
+    // keep one byte for the terminating zero, callers may need a C string
+    if (mUsed + size + 1 > mPageSize)
+        throw std::runtime_error("Error: secret vault is full.");
+
+    char* out = mPage + mUsed;
+    for (size_t i = 0; i < size; ++i)
+        out[i] = encoded[i] ^ static_cast<char>(key + i);
+    out[size] = '\0';
+    mUsed += size + 1;
+
+    return mSecrets.emplace(owner, std::string_view(out, size)).first->second;
+}
+
+void SecretVault::Wipe(){
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mPage)
+        explicit_bzero(mPage, mPageSize);
+    mSecrets.clear();
+    mUsed = 0;
+}
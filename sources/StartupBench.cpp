@@ -0,0 +1,214 @@
+// Cold start time and size of presien-lic-app builds, e.g. the plain release build against
+// the PGO + LTO one (see pgo.sh).
+// usage: presien-startup-bench <app> [<app> ...] [runs=20] [args=<app arguments>] [stdin=<file>]
+//                              [cwd=<dir>] [cold=1] [evict=<file>,<file>]
+// Runs alternate between the apps. With cold=1 every run first drops the app binary and the
+// evict files (shared libraries, config) from the page cache with posix_fadvise(DONTNEED),
+// which needs no root and covers what a fresh boot of the device reads from flash.
+// The first app is the reference for the reported differences.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+    using Args = std::map<std::string, std::string>;
+
+    struct BinarySize{
+        uint64_t file = 0;
+        uint64_t loaded = 0;    // SHF_ALLOC sections, what is mapped at startup
+        uint64_t text = 0;
+    };
+
+    struct AppResult{
+        std::string path;
+        BinarySize size;
+        std::vector<double> startMs;
+        int failures = 0;
+    };
+
+    std::vector<std::string> split(const std::string& value, char separator){
+        std::vector<std::string> parts;
+        std::string part;
+        std::istringstream is(value);
+        while (std::getline(is, part, separator))
+        {
+            if (!part.empty())
+                parts.push_back(part);
+        }
+        return parts;
+    }
+
+    BinarySize binarySize(const std::string& path){
+        BinarySize size;
+        std::ifstream is(path, std::ios::binary);
+        const std::string image((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+        size.file = image.size();
+        // x86_64 and aarch64 are both ELF64
+        if (image.size() < sizeof(Elf64_Ehdr) || image.compare(0, SELFMAG, ELFMAG) != 0 || image[EI_CLASS] != ELFCLASS64)
+            return size;
+        Elf64_Ehdr header;
+        std::memcpy(&header, image.data(), sizeof(header));
+        if (header.e_shoff == 0 || header.e_shstrndx >= header.e_shnum
+            || header.e_shoff + static_cast<uint64_t>(header.e_shnum) * sizeof(Elf64_Shdr) > image.size())
+            return size;
+        std::vector<Elf64_Shdr> sections(header.e_shnum);
+        std::memcpy(sections.data(), image.data() + header.e_shoff, sections.size() * sizeof(Elf64_Shdr));
+        const auto& names = sections[header.e_shstrndx];
+        for (const auto& section : sections)
+        {
+            if (section.sh_flags & SHF_ALLOC)
+                size.loaded += section.sh_size;
+            if (names.sh_offset + section.sh_name < image.size()
+                && std::strcmp(image.c_str() + names.sh_offset + section.sh_name, ".text") == 0)
+                size.text = section.sh_size;
+        }
+        return size;
+    }
+
+    void evict(const std::string& path){
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return;
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+
+    // wall time from fork to exit in ms, negative when the app could not be started; a license
+    // error exit still counts, the startup work was done
+    double runOnce(const std::string& app, const std::vector<std::string>& appArgs, const Args& args){
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>(app.c_str()));
+        for (const auto& arg : appArgs)
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        argv.push_back(nullptr);
+
+        const auto start = std::chrono::steady_clock::now();
+        const pid_t pid = fork();
+        if (pid < 0)
+            return -1;
+        if (pid == 0)
+        {
+            const auto& input = args.at("stdin");
+            int in = open(input.empty() ? "/dev/null" : input.c_str(), O_RDONLY);
+            int out = open("/dev/null", O_WRONLY);
+            if (in < 0 || out < 0 || dup2(in, STDIN_FILENO) < 0 || dup2(out, STDOUT_FILENO) < 0 || dup2(out, STDERR_FILENO) < 0)
+                _exit(127);
+            if (!args.at("cwd").empty() && chdir(args.at("cwd").c_str()) != 0)
+                _exit(127);
+            execv(app.c_str(), argv.data());
+            _exit(127);
+        }
+        int status = 0;
+        if (waitpid(pid, &status, 0) < 0)
+            return -1;
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return WIFEXITED(status) && WEXITSTATUS(status) != 127 ? ms : -ms;
+    }
+
+    double percentile(const std::vector<double>& sorted, double p){
+        if (sorted.empty())
+            return 0;
+        auto index = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    std::string change(double value, double reference){
+        if (reference <= 0)
+            return std::string();
+        std::ostringstream os;
+        os << std::showpos << std::fixed << std::setprecision(1) << (value - reference) * 100.0 / reference << "%";
+        return " (" + os.str() + ")";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Args args = {{"runs", "20"}, {"args", ""}, {"stdin", ""}, {"cwd", ""}, {"cold", "1"}, {"evict", ""}};
+    std::vector<AppResult> apps;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if (eq != std::string::npos && args.count(arg.substr(0, eq)))
+            args[arg.substr(0, eq)] = arg.substr(eq + 1);
+        else if (access(arg.c_str(), X_OK) == 0)
+            apps.push_back({arg, binarySize(arg), {}, 0});
+        else
+        {
+            std::cout << "Not an executable or unknown argument: " << arg << std::endl;
+            return -1;
+        }
+    }
+    if (apps.empty())
+    {
+        std::cout << "usage: " << argv[0] << " <app> [<app> ...] [runs=20] [args=...] [stdin=<file>] [cwd=<dir>] [cold=1] [evict=<files>]" << std::endl;
+        return -1;
+    }
+    const int runs = std::stoi(args["runs"]);
+    const bool cold = args["cold"] == "1";
+    const auto appArgs = split(args["args"], ' ');
+    const auto evictFiles = split(args["evict"], ',');
+
+    // one warm run each so the first measured run does not pay for the dynamic loader cache
+    for (auto& app : apps)
+        runOnce(app.path, appArgs, args);
+    for (int run = 0; run < runs; ++run)
+    {
+        for (auto& app : apps)
+        {
+            if (cold)
+            {
+                evict(app.path);
+                for (const auto& file : evictFiles)
+                    evict(file);
+            }
+            const double ms = runOnce(app.path, appArgs, args);
+            if (ms < 0)
+                ++app.failures;
+            app.startMs.push_back(std::abs(ms));
+        }
+    }
+
+    std::cout << (cold ? "cold" : "warm") << " start, " << runs << " runs, args \"" << args["args"] << "\"" << std::endl;
+    const auto& reference = apps.front();
+    auto referenceTimes = reference.startMs;
+    std::sort(referenceTimes.begin(), referenceTimes.end());
+    for (auto& app : apps)
+    {
+        std::sort(app.startMs.begin(), app.startMs.end());
+        const bool isReference = &app == &reference;
+        std::cout << app.path << std::endl << std::fixed << std::setprecision(2)
+                  << "  start ms: min " << app.startMs.front()
+                  << ", p50 " << percentile(app.startMs, 50)
+                  << (isReference ? "" : change(percentile(app.startMs, 50), percentile(referenceTimes, 50)))
+                  << ", p90 " << percentile(app.startMs, 90)
+                  << (isReference ? "" : change(percentile(app.startMs, 90), percentile(referenceTimes, 90))) << std::endl
+                  << "  size: file " << app.size.file
+                  << (isReference ? "" : change(static_cast<double>(app.size.file), static_cast<double>(reference.size.file)))
+                  << ", loaded " << app.size.loaded
+                  << (isReference ? "" : change(static_cast<double>(app.size.loaded), static_cast<double>(reference.size.loaded)))
+                  << ", .text " << app.size.text
+                  << (isReference ? "" : change(static_cast<double>(app.size.text), static_cast<double>(reference.size.text))) << std::endl;
+        if (app.failures)
+            std::cout << "  " << app.failures << " runs could not start the app" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "StartupBudget.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace PRESIEN::BlindSight;
+
+StartupBudget::StartupBudget(std::chrono::milliseconds budget):mBudget(budget), mDeadline(clock::now() + budget){
+}
+
+StartupBudget::~StartupBudget(){
+    JoinBackground();
+}
+
+std::chrono::milliseconds StartupBudget::FromEnvironment(){
+    const char* val = std::getenv("VBSSTARTUPBUDGETMS");
+    if (!val)
+        return std::chrono::milliseconds(0);
+    try
+    {
+        return std::chrono::milliseconds(std::stol(val));
+    }
+    catch (const std::exception&)
+    {
+        PLOG_WARN("Ignoring invalid VBSSTARTUPBUDGETMS=" << val);
+        return std::chrono::milliseconds(0);
+    }
+}
+
+std::chrono::milliseconds StartupBudget::Remaining() const{
+    if (Unlimited())
+        return std::chrono::milliseconds::max();
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(mDeadline - clock::now());
+    return remaining.count() > 0 ? remaining : std::chrono::milliseconds(0);
+}
+
+long StartupBudget::NetworkTimeoutSeconds(long fallback) const{
+    if (Unlimited())
+        return fallback;
+    const auto ms = Remaining().count();
+    return std::max(1L, static_cast<long>((ms + 999) / 1000));
+}
+
+void StartupBudget::JoinBackground(){
+    std::vector<std::thread> background;
+    {
+        std::lock_guard<std::mutex> lock(mBackgroundMutex);
+        background.swap(mBackground);
+    }
+    for (auto& thread : background)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+}
+
+bool StartupBudget::HasBackground(){
+    std::lock_guard<std::mutex> lock(mBackgroundMutex);
+    return !mBackground.empty();
+}
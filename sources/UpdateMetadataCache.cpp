@@ -0,0 +1,303 @@
+#include "UpdateMetadataCache.h"
+#include "LicenseMetrics.h"
+#include "PresienLog.h"
+
+#include <LicenseSpring/Exceptions.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include <json/json.hpp>
+
+using namespace LicenseSpring;
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    nlohmann::json fileToJson(const InstallationFile& file){
+        return {
+            {"url", file.url()}, {"version", file.version()}, {"required_version", file.requiredVersion()},
+            {"md5", file.md5Hash()}, {"release_date", file.releaseDate()}, {"environment", file.environment()},
+            {"eula", file.eulaLink()}, {"release_notes", file.releaseNotesLink()}, {"channel", file.channel()},
+            {"size", file.size()}
+        };
+    }
+
+    InstallationFile::ptr_t fileFromJson(const nlohmann::json& data){
+        return std::make_shared<InstallationFile>(
+            data.at("url").get<std::string>(), data.at("version").get<std::string>(),
+            data.at("required_version").get<std::string>(), data.at("md5").get<std::string>(),
+            data.at("release_date").get<std::string>(), data.at("environment").get<std::string>(),
+            data.at("eula").get<std::string>(), data.at("release_notes").get<std::string>(),
+            data.at("channel").get<std::string>(), data.at("size").get<uint64_t>());
+    }
+}
+
+UpdateMetadataCache::UpdateMetadataCache(LicenseManager::ptr_t manager, const std::string& stateFile, std::chrono::seconds ttl)
+    :mManager(std::move(manager)), mStateFile(stateFile), mTtl(TtlFromEnvironment(ttl)){
+    _loadState();
+}
+
+UpdateMetadataCache::~UpdateMetadataCache(){
+    StopBackgroundRefresh();
+}
+
+std::chrono::seconds UpdateMetadataCache::TtlFromEnvironment(std::chrono::seconds fallback){
+    const char* val = std::getenv("VBSUPDATETTL");
+    if (val == nullptr)
+        return fallback;
+    char* end = nullptr;
+    long seconds = std::strtol(val, &end, 10);
+    if (end == val || seconds < 0)
+    {
+        PLOG_WARN("Ignoring invalid VBSUPDATETTL=" << val);
+        return fallback;
+    }
+    return std::chrono::seconds(seconds);
+}
+
+std::string UpdateMetadataCache::_key(const LicenseID& licenseId, const InstallFileFilter& filter){
+    return licenseId.id() + '\n' + filter.Channel + '\n' + filter.Environment;
+}
+
+bool UpdateMetadataCache::_fresh(const Entry& entry) const{
+    return std::chrono::system_clock::now() - entry.fetched < mTtl;
+}
+
+std::vector<std::string> UpdateMetadataCache::VersionList(const LicenseID& licenseId, const InstallFileFilter& filter){
+    const auto key = _key(licenseId, filter);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mEntries.find(key);
+        if (it != mEntries.end() && _fresh(it->second))
+            return it->second.versions;
+    }
+    _refresh(key, licenseId, filter);
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries.at(key).versions;
+}
+
+LicenseSpring::InstallationFile::ptr_t UpdateMetadataCache::InstallationFile(const LicenseID& licenseId, const std::string& version,
+                                                              const InstallFileFilter& filter){
+    const auto versions = VersionList(licenseId, filter);
+    const auto& wanted = version.empty() && !versions.empty() ? versions.back() : version;
+    const auto key = _key(licenseId, filter);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& files = mEntries.at(key).files;
+        auto it = files.find(wanted);
+        if (it != files.end())
+            return it->second;
+    }
+
+    // older versions are fetched on demand and kept, published files do not change
+    LicenseSpring::InstallationFile::ptr_t file;
+    {
+        PRESIEN_SDK_TIMER(GET_INSTALLATION_FILE);
+        file = mManager->getInstallationFile(licenseId, wanted, filter);
+    }
+    if (file)
+    {
+        std::lock_guard<std::mutex> refreshLock(mRefreshMutex);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mEntries.at(key).files[wanted] = file;
+        }
+        _saveState();
+    }
+    return file;
+}
+
+bool UpdateMetadataCache::_refresh(const std::string& key, const LicenseID& licenseId, const InstallFileFilter& filter, bool force){
+    std::lock_guard<std::mutex> refreshLock(mRefreshMutex);
+    std::map<std::string, LicenseSpring::InstallationFile::ptr_t> known;
+    bool stale = false;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mEntries.find(key);
+        if (it != mEntries.end())
+        {
+            // refreshed by another caller while this one waited
+            if (!force && _fresh(it->second))
+                return true;
+            known = it->second.files;
+            stale = true;
+        }
+    }
+
+    try
+    {
+        std::vector<std::string> versions;
+        {
+            PRESIEN_SDK_TIMER(GET_VERSION_LIST);
+            versions = mManager->getVersionList(licenseId, filter);
+        }
+        std::map<std::string, LicenseSpring::InstallationFile::ptr_t> files;
+        for (const auto& version : versions)
+        {
+            auto it = known.find(version);
+            if (it != known.end())
+                files.insert(*it);
+        }
+        // the latest file is what update checks ask for, have it before anyone does
+        if (!versions.empty() && !files.count(versions.back()))
+        {
+            PRESIEN_SDK_TIMER(GET_INSTALLATION_FILE);
+            if (auto latest = mManager->getInstallationFile(licenseId, versions.back(), filter))
+                files[versions.back()] = latest;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto& entry = mEntries[key];
+            entry.licenseId = licenseId;
+            entry.filter = filter;
+            entry.versions = std::move(versions);
+            entry.files = std::move(files);
+            entry.fetched = std::chrono::system_clock::now();
+        }
+        _saveState();
+        return true;
+    }
+    catch (const LicenseSpringException& ex)
+    {
+        if (!stale)
+            throw;
+        PLOG_WARN("Update metadata refresh failed, using cached data: " << ex.what());
+        return false;
+    }
+}
+
+void UpdateMetadataCache::Invalidate(){
+    std::lock_guard<std::mutex> refreshLock(mRefreshMutex);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEntries.clear();
+    }
+    _saveState();
+}
+
+void UpdateMetadataCache::ReleaseMemory(){
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& entry : mEntries)
+    {
+        auto& files = entry.second.files;
+        if (entry.second.versions.empty())
+        {
+            files.clear();
+            continue;
+        }
+        for (auto it = files.begin(); it != files.end();)
+            it = it->first == entry.second.versions.back() ? std::next(it) : files.erase(it);
+    }
+}
+
+void UpdateMetadataCache::StartBackgroundRefresh(std::chrono::seconds interval){
+    StopBackgroundRefresh();
+    {
+        std::lock_guard<std::mutex> lock(mWorkerMutex);
+        mStopWorker = false;
+    }
+    mWorker = std::thread([this, interval]{
+        std::unique_lock<std::mutex> lock(mWorkerMutex);
+        while (!mWorkerCv.wait_for(lock, interval, [this]{ return mStopWorker; }))
+        {
+            lock.unlock();
+            // entries which would expire before the next wake up are refreshed now
+            std::vector<Entry> due;
+            {
+                std::lock_guard<std::mutex> entriesLock(mMutex);
+                for (const auto& entry : mEntries)
+                {
+                    if (std::chrono::system_clock::now() + interval - entry.second.fetched >= mTtl)
+                        due.push_back(entry.second);
+                }
+            }
+            for (const auto& entry : due)
+            {
+                try
+                {
+                    _refresh(_key(entry.licenseId, entry.filter), entry.licenseId, entry.filter, true);
+                }
+                catch (const LicenseSpringException& ex)
+                {
+                    PLOG_ERROR("Update metadata refresh failed: " << ex.what());
+                }
+            }
+            lock.lock();
+        }
+    });
+}
+
+void UpdateMetadataCache::StopBackgroundRefresh(){
+    {
+        std::lock_guard<std::mutex> lock(mWorkerMutex);
+        mStopWorker = true;
+    }
+    mWorkerCv.notify_all();
+    if (mWorker.joinable())
+        mWorker.join();
+}
+
+void UpdateMetadataCache::_loadState(){
+    if (mStateFile.empty())
+        return;
+    std::ifstream is(mStateFile);
+    if (!is.good())
+        return;
+    try
+    {
+        auto data = nlohmann::json::parse(is);
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const auto& item : data)
+        {
+            Entry entry;
+            const auto licenseKey = item.at("key").get<std::string>();
+            entry.licenseId = !licenseKey.empty() ? LicenseID::fromKey(licenseKey) : LicenseID::fromUser(item.at("user").get<std::string>());
+            entry.filter = InstallFileFilter(item.at("channel").get<std::string>(), item.at("environment").get<std::string>());
+            entry.versions = item.at("versions").get<std::vector<std::string>>();
+            for (const auto& file : item.at("files"))
+            {
+                auto installFile = fileFromJson(file);
+                entry.files[installFile->version()] = installFile;
+            }
+            entry.fetched = std::chrono::system_clock::time_point(std::chrono::seconds(item.at("fetched").get<int64_t>()));
+            mEntries[_key(entry.licenseId, entry.filter)] = std::move(entry);
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        PLOG_WARN("Ignoring update metadata cache " << mStateFile << ": " << ex.what());
+    }
+}
+
+void UpdateMetadataCache::_saveState() const{
+    if (mStateFile.empty())
+        return;
+    nlohmann::json data = nlohmann::json::array();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const auto& entry : mEntries)
+        {
+            nlohmann::json item;
+            // the password is never written, same as the SDK
+            item["key"] = entry.second.licenseId.key();
+            item["user"] = entry.second.licenseId.user();
+            item["channel"] = entry.second.filter.Channel;
+            item["environment"] = entry.second.filter.Environment;
+            item["versions"] = entry.second.versions;
+            item["files"] = nlohmann::json::array();
+            for (const auto& file : entry.second.files)
+                item["files"].push_back(fileToJson(*file.second));
+            item["fetched"] = std::chrono::duration_cast<std::chrono::seconds>(entry.second.fetched.time_since_epoch()).count();
+            data.push_back(item);
+        }
+    }
+    const auto tmpFile = mStateFile + ".tmp";
+    {
+        std::ofstream os(tmpFile, std::ios::trunc);
+        os << data.dump();
+    }
+    std::rename(tmpFile.c_str(), mStateFile.c_str());
+}
@@ -0,0 +1,160 @@
+#include "ValidationToken.h"
+#include "HardwareFingerprint.h"
+#include "PresienLog.h"
+#include "SecretVault.h"
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <memory>
+
+#include <json/json.hpp>
+
+using namespace PRESIEN::BlindSight;
+
+namespace {
+
+    constexpr int TOKEN_VERSION = 1;
+    PRESIEN_SECRET(kTokenSecret, "presien-blindsight-validation-token");
+
+    std::string toHex(const unsigned char* data, size_t size){
+        static const char digits[] = "0123456789abcdef";
+        std::string out(size * 2, '\0');
+        for (size_t i = 0; i < size; ++i)
+        {
+            out[2 * i] = digits[data[i] >> 4];
+            out[2 * i + 1] = digits[data[i] & 0x0f];
+        }
+        return out;
+    }
+}
+
+ValidationToken::ValidationToken(const std::string& path, std::chrono::seconds ttl)
+    :mPath(path), mTtl(ttl){
+}
+
+std::chrono::seconds ValidationToken::TtlFromEnvironment(std::chrono::seconds fallback){
+    const char* val = std::getenv("VBSTOKENTTL");
+    if (val == nullptr)
+        return fallback;
+    char* end = nullptr;
+    long seconds = std::strtol(val, &end, 10);
+    if (end == val || seconds < 0)
+    {
+        PLOG_WARN("Ignoring invalid VBSTOKENTTL=" << val);
+        return fallback;
+    }
+    return std::chrono::seconds(seconds);
+}
+
+std::string ValidationToken::_payload(long long expiry, const std::string& hardwareId,
+                                      const std::string& licenseFile, const std::string& licenseHash){
+    return std::to_string(TOKEN_VERSION) + '\n' + std::to_string(expiry) + '\n' + hardwareId + '\n' + licenseFile + '\n' + licenseHash;
+}
+
+std::string ValidationToken::_mac(const std::string& hardwareId, const std::string& binding, const std::string& payload){
+    // per device key: the hardware id is read from the fingerprint cache on the license volume,
+    // the binding live from the device, a copied volume does not carry it along
+    const auto secret = kTokenSecret.Reveal();
+    const auto device = hardwareId + '\n' + binding;
+    unsigned char key[EVP_MAX_MD_SIZE];
+    unsigned int keySize = 0;
+    HMAC(EVP_sha256(), secret.data(), static_cast<int>(secret.size()),
+         reinterpret_cast<const unsigned char*>(device.data()), device.size(), key, &keySize);
+
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int macSize = 0;
+    HMAC(EVP_sha256(), key, static_cast<int>(keySize),
+         reinterpret_cast<const unsigned char*>(payload.data()), payload.size(), mac, &macSize);
+    OPENSSL_cleanse(key, sizeof(key));
+    return toHex(mac, macSize);
+}
+
+std::string ValidationToken::_hashFile(const std::string& path){
+    std::ifstream is(path, std::ios::binary);
+    if (!is)
+        return std::string();
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    if (!ctx || EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr) != 1)
+        return std::string();
+    char buffer[16 * 1024];
+    while (is.read(buffer, sizeof(buffer)) || is.gcount() > 0)
+        EVP_DigestUpdate(ctx.get(), buffer, static_cast<size_t>(is.gcount()));
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int size = 0;
+    EVP_DigestFinal_ex(ctx.get(), digest, &size);
+    return toHex(digest, size);
+}
+
+bool ValidationToken::Issue(const std::string& hardwareId, const std::string& licenseFile) const{
+    if (!Enabled())
+        return false;
+    const auto binding = HardwareFingerprint::ReadBinding();
+    const auto licenseHash = _hashFile(licenseFile);
+    if (binding.empty() || licenseHash.empty())
+        return false;
+    const long long expiry = static_cast<long long>(std::time(nullptr)) + mTtl.count();
+
+    nlohmann::json token;
+    token["version"] = TOKEN_VERSION;
+    token["expiry"] = expiry;
+    token["hardware_id"] = hardwareId;
+    token["license_file"] = licenseFile;
+    token["license_sha256"] = licenseHash;
+    token["mac"] = _mac(hardwareId, binding, _payload(expiry, hardwareId, licenseFile, licenseHash));
+
+    const auto tmpPath = mPath + ".tmp";
+    {
+        std::ofstream os(tmpPath, std::ios::trunc);
+        if (!(os << token.dump()))
+            return false;
+    }
+    return std::rename(tmpPath.c_str(), mPath.c_str()) == 0;
+}
+
+bool ValidationToken::Verify(const std::string& hardwareId) const{
+    if (!Enabled() || hardwareId.empty())
+        return false;
+    std::ifstream is(mPath);
+    if (!is)
+        return false;
+    try
+    {
+        const auto token = nlohmann::json::parse(is);
+        if (token.at("version").get<int>() != TOKEN_VERSION || token.at("hardware_id").get<std::string>() != hardwareId)
+            return false;
+
+        // a token from the future means the clock went back, do not trust it
+        const auto expiry = token.at("expiry").get<long long>();
+        const long long now = static_cast<long long>(std::time(nullptr));
+        if (now >= expiry || expiry - now > mTtl.count())
+            return false;
+
+        const auto licenseFile = token.at("license_file").get<std::string>();
+        const auto licenseHash = token.at("license_sha256").get<std::string>();
+        const auto binding = HardwareFingerprint::ReadBinding();
+        if (binding.empty())
+            return false;
+        const auto expected = _mac(hardwareId, binding, _payload(expiry, hardwareId, licenseFile, licenseHash));
+        const auto mac = token.at("mac").get<std::string>();
+        if (mac.size() != expected.size() || CRYPTO_memcmp(mac.data(), expected.data(), mac.size()) != 0)
+        {
+            PLOG_WARN("Validation token signature mismatch, ignoring it");
+            return false;
+        }
+        return _hashFile(licenseFile) == licenseHash;
+    }
+    catch (const nlohmann::json::exception&)
+    {
+        return false;
+    }
+}
+
+void ValidationToken::Revoke() const{
+    std::remove(mPath.c_str());
+}
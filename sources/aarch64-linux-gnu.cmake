@@ -0,0 +1,14 @@
+# Cross build for aarch64 (Jetson) from an x86_64 host:
+#   cmake -DCMAKE_TOOLCHAIN_FILE=aarch64-linux-gnu.cmake -DCMAKE_BUILD_TYPE=Release ..
+# The SDK is taken from bin/aarch64/<link type>/<build type>. PGO profiles have to come from a
+# training run on the device (pgo.sh there, then PGO_PROFILE_DIR pointing at the copied profiles).
+set(CMAKE_SYSTEM_NAME Linux)
+set(CMAKE_SYSTEM_PROCESSOR aarch64)
+
+set(CMAKE_C_COMPILER aarch64-linux-gnu-gcc)
+set(CMAKE_CXX_COMPILER aarch64-linux-gnu-g++)
+set(CMAKE_FIND_ROOT_PATH /usr/aarch64-linux-gnu)
+
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
+set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
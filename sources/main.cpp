@@ -1,10 +1,39 @@
 
 #include "PresienLic.h"
+#include "LicenseMetrics.h"
+#include "MemoryGovernor.h"
+#include "PresienLog.h"
 
 using namespace PRESIEN::BlindSight;
+
+// VBSMETRICSFILE=/var/lib/node_exporter/textfile/presien_lic.prom exports SDK call metrics
+// for the node-exporter textfile collector when the process exits.
+struct MetricsTextfileOnExit{
+    ~MetricsTextfileOnExit(){
+        auto* path = std::getenv("VBSMETRICSFILE");
+        if (path && *path)
+            LicenseMetrics::GetInstance().WriteTextfile(path);
+    }
+};
+
+// VBSLOWMEM=1 / VBSRSSBUDGETMB=<MiB> report the peak RSS when the process exits
+struct MemoryReportOnExit{
+    ~MemoryReportOnExit(){
+        auto& memory = MemoryGovernor::GetInstance();
+        if (memory.LowMemory() || memory.Budget())
+            memory.LogPeak();
+    }
+};
+
 int main(int argc, char** argv)
 {
-   
+    MemoryGovernor::GetInstance().ConfigureFromEnvironment();
+    MemoryReportOnExit memoryOnExit;
+    MetricsTextfileOnExit metricsOnExit;
+    // in batch mode stdout carries the JSON results, initialization logs included go to stderr
+    if (argc == 2 && std::string(argv[1]) == "--batch")
+        Logger::GetInstance().SetConsole(stderr);
+
 #ifdef _WIN32
     // Enable displaying Unicode symbols in console (custom fields and metadata are UTF-8 encoded)
     SetConsoleOutputCP( CP_UTF8 );
@@ -12,25 +41,26 @@ int main(int argc, char** argv)
 #endif
     try
     {
-        PresienLicense presienLicense = PresienLicense::GetInstance();
+        if (PresienLicense::ValidatedByToken(argc, argv))
+            return 0;
+        PresienLicense& presienLicense = PresienLicense::GetInstance();
         presienLicense.ParseCmdArgs(argc,argv);
         presienLicense.ProcessRequest();
-        std::cout <<"\n\n";
         return 0;
     }
     catch( const LicenseSpringException& ex )
     {
-        std::cout << "LicenseSpring exception encountered: " << ex.what();std::cout <<"\n\n";
+        PLOG_ERROR("LicenseSpring exception encountered: " << ex.what());
         return static_cast<int>( ex.getCode() );
     }
     catch( const std::exception& ex )
     {
-        std::cout << "Standard exception encountered: " << ex.what();std::cout <<"\n\n";
+        PLOG_ERROR("Standard exception encountered: " << ex.what());
         return -1;
     }
     catch( ... )
     {
-        std::cout << "Unknown exception encountered!";std::cout <<"\n\n";
+        PLOG_ERROR("Unknown exception encountered!");
         return -3;
     }
 }
@@ -0,0 +1,73 @@
+#!/bin/bash
+# Profile guided, link time optimized release build of presien-lic-app.
+# usage: ./pgo.sh [static|shared]
+#   release_baseline  plain Release build (no LTO, no PGO) for comparison
+#   release_pgo       instrumented build, trained against MockBackend with presien-lic-loadtest
+#                     in the shapes of the validate, install, check and batch modes plus app
+#                     cold starts, then rebuilt with the profiles, LTO and section GC
+# presien-startup-bench compares cold start and size of both presien-lic-app binaries at the end.
+# Run it natively on x86_64 or on the aarch64 device, the profiles do not carry over between them.
+# Install mode only trains through the mock backend, the app never activates a real seat here.
+
+set -e
+
+LINK_TYPE_CHECK=${1:-static}
+SHARED_FLAG="OFF"
+if [ ${LINK_TYPE_CHECK,,} == "shared" ]; then
+    SHARED_FLAG="ON"
+fi
+
+cproc=$(nproc)
+SOURCE_DIR=$(cd "$(dirname "$0")" && pwd)
+BASELINE_DIR=${SOURCE_DIR}/release_baseline
+PGO_DIR=${SOURCE_DIR}/release_pgo
+PROFILE_DIR=${PGO_DIR}/pgo-profile
+APPS="presien-lic-app presien-lic-loadtest presien-startup-bench"
+
+configure()
+{
+    local dir=$1
+    shift
+    cmake -S "${SOURCE_DIR}" -B "${dir}" -DCMAKE_BUILD_TYPE=Release -DUSE_SHARED_LIBS=${SHARED_FLAG} -DBUILD_BENCHMARKS=ON "$@"
+}
+
+build()
+{
+    cmake --build "$1" -j${cproc} --clean-first --target ${APPS}
+    cp "${SOURCE_DIR}/PresienLic.config.json" "$1/"
+}
+
+train()
+{
+    cd "${PGO_DIR}"
+    # validate: local checks
+    ./presien-lic-loadtest op=local threads=4 iterations=20000
+    # install: activation of a new license per iteration
+    ./presien-lic-loadtest op=activate threads=4 iterations=2000 timeout=0.01
+    # check: online check with the occasional network error
+    ./presien-lic-loadtest op=check threads=4 iterations=5000 timeout=0.01
+    # batch: many concurrent callers, floating seats and features
+    ./presien-lic-loadtest op=mixed threads=8 iterations=5000 floating=1 features=2 seats=6 maxfloat=0.01 tamper=0.001
+    # the app startup path itself (config, secrets, hardware id, local store) in validate and batch mode
+    for i in $(seq 10); do
+        timeout 60 ./presien-lic-app > /dev/null 2>&1 || true
+        printf '{"id":1,"cmd":"validate"}\n{"id":2,"cmd":"memory"}\n{"id":3,"cmd":"quit"}\n' \
+            | timeout 60 ./presien-lic-app --batch > /dev/null 2>&1 || true
+    done
+    cd "${SOURCE_DIR}"
+}
+
+configure "${BASELINE_DIR}" -DRELEASE_LTO=OFF -DPGO_MODE=
+build "${BASELINE_DIR}"
+
+rm -rf "${PROFILE_DIR}"
+configure "${PGO_DIR}" -DRELEASE_LTO=ON -DPGO_MODE=generate -DPGO_PROFILE_DIR="${PROFILE_DIR}"
+build "${PGO_DIR}"
+train
+
+# same build directory, the profiles are keyed by object file path
+configure "${PGO_DIR}" -DPGO_MODE=use
+build "${PGO_DIR}"
+
+"${BASELINE_DIR}/presien-startup-bench" "${BASELINE_DIR}/presien-lic-app" "${PGO_DIR}/presien-lic-app" runs=20 cwd="${PGO_DIR}"
+"${BASELINE_DIR}/presien-startup-bench" "${BASELINE_DIR}/presien-lic-app" "${PGO_DIR}/presien-lic-app" runs=20 cwd="${PGO_DIR}" args=--batch